@@ -0,0 +1,90 @@
+# Benchmark for IFJ24 compiler
+# Counts instructions executed by the interpreter for generated programs
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+# Long palindrome-like lines for substring-heavy programs
+PALINDROME_HALF = 'abcdefghijklmnopqrstuvwxyz0123456789' * 6
+PALINDROME_INPUT = (PALINDROME_HALF + 'x' + PALINDROME_HALF[::-1] + '\n' +
+                    PALINDROME_HALF + PALINDROME_HALF[::-1] + '\n' +
+                    PALINDROME_HALF + 'xy' + PALINDROME_HALF[::-1] + '\n')
+
+# Benchmark programs and their standard input
+BENCHMARKS = [
+    ('all_tests/factorial_iterative.ifj24', '20\n'),
+    ('all_tests/sum_of_digits.ifj24', '98765432109876543210\n1234567890\n\n'),
+    ('all_tests/sort_digits.ifj24', '90817263549081726354\n'),
+    ('all_tests/palindrome_substring.ifj24', PALINDROME_INPUT),
+]
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='IFJ24 Benchmark (executed instruction count)')
+    parser.add_argument('--compiler', default='./ifj24_compiler', help='Compiler to benchmark')
+    parser.add_argument('--baseline', help='Second compiler to compare against')
+    parser.add_argument('--interpreter', default='./ic24int', help='IFJcode24 interpreter')
+    parser.add_argument('--compiler-args', default='', help='Extra arguments passed to the compiler(s)')
+    return parser.parse_args()
+
+
+def count_instructions(compiler, compiler_args, interpreter, program, input_data):
+    """Compiles the program and returns (executed instructions, generated lines, program output)"""
+    with tempfile.NamedTemporaryFile(suffix='.ifjcode24', delete=False) as code_file:
+        code_path = code_file.name
+    try:
+        command = [compiler] + compiler_args.split() + [program, code_path]
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f'compilation of {program} failed ({result.returncode}): {result.stderr}')
+        with open(code_path) as f:
+            code_lines = sum(1 for _ in f)
+
+        # The interpreter prints every executed instruction to stderr in verbose mode
+        result = subprocess.run([interpreter, '-v', code_path], input=input_data,
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f'interpretation of {program} failed ({result.returncode})')
+        executed = result.stderr.count('Executing instruction')
+        return executed, code_lines, result.stdout
+    finally:
+        os.remove(code_path)
+
+
+def main():
+    args = parse_args()
+    for tool in [args.compiler, args.interpreter] + ([args.baseline] if args.baseline else []):
+        if not os.path.isfile(tool):
+            print(f'Error: {tool} not found.')
+            sys.exit(1)
+
+    header = f'{"program":<40}{"executed":>12}{"lines":>8}'
+    if args.baseline:
+        header += f'{"baseline":>12}{"change":>10}'
+    print(header)
+
+    total = total_baseline = 0
+    for program, input_data in BENCHMARKS:
+        executed, lines, output = count_instructions(args.compiler, args.compiler_args, args.interpreter, program, input_data)
+        total += executed
+        row = f'{os.path.basename(program):<40}{executed:>12}{lines:>8}'
+        if args.baseline:
+            base_executed, _, base_output = count_instructions(args.baseline, args.compiler_args, args.interpreter, program, input_data)
+            if base_output != output:
+                print(f'Error: output of {program} differs from baseline.')
+                sys.exit(1)
+            total_baseline += base_executed
+            row += f'{base_executed:>12}{(executed - base_executed) / base_executed:>+10.1%}'
+        print(row)
+
+    summary = f'{"total":<40}{total:>12}{"":>8}'
+    if args.baseline:
+        summary += f'{total_baseline:>12}{(total - total_baseline) / total_baseline:>+10.1%}'
+    print(summary)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,380 @@
+/**
+ * @file batch.c
+ *
+ * Implementation of the batch mode.
+ * The workers take the next source from a shared counter. A finished
+ * source is reported as soon as all sources before it are, so the lines
+ * come in the order of the command line whatever the order of compiling.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include "error.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Extension of the sources replaced by BATCH_OUTPUT_EXTENSION */
+#define SOURCE_EXTENSION ".ifj24"
+
+/**
+ * Outcome of compiling one source
+ */
+typedef struct {
+    const char *source;
+    char *output;      // Path of the generated file, or NULL if the source is not compiled
+    int result;
+    char *diagnostics; // Freed once reported, or NULL
+    bool done;
+} BatchFile;
+
+/**
+ * State shared by the workers
+ */
+typedef struct {
+    BatchFile *files;
+    int count;
+    const char *output_directory;
+    const Ifj24Options *options;
+    pthread_mutex_t lock; // Guards the counters and the reporting
+    int next_file;        // Next source to compile
+    int next_report;      // Next source to report
+    int failed;
+} Batch;
+
+/**
+ * Formats a message of the batch mode about a file into a new buffer
+ */
+static char *file_message(const char *format, const char *path)
+{
+    size_t length = strlen(format) + strlen(path) + 1;
+    char *message = malloc(length);
+    if (message != NULL)
+    {
+        snprintf(message, length, format, path);
+    }
+    return message;
+}
+
+/**
+ * Reads a whole file into memory, returns NULL if it cannot be read
+ */
+static char *read_file(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    size_t capacity = 4096;
+    char *content = malloc(capacity);
+    *length = 0;
+    while (content != NULL)
+    {
+        *length += fread(content + *length, 1, capacity - *length, file);
+        if (*length < capacity)
+        {
+            break;
+        }
+        capacity *= 2;
+        char *larger = realloc(content, capacity);
+        if (larger == NULL)
+        {
+            free(content);
+        }
+        content = larger;
+    }
+    if (content != NULL && ferror(file))
+    {
+        free(content);
+        content = NULL;
+    }
+    fclose(file);
+    return content;
+}
+
+/**
+ * Returns the path of the generated file of a source in the output directory
+ */
+static char *output_path(const char *output_directory, const char *source)
+{
+    const char *name = strrchr(source, '/');
+    name = name != NULL ? name + 1 : source;
+    size_t name_length = strlen(name);
+    size_t extension_length = strlen(SOURCE_EXTENSION);
+    if (name_length > extension_length && strcmp(name + name_length - extension_length, SOURCE_EXTENSION) == 0)
+    {
+        name_length -= extension_length;
+    }
+
+    size_t length = strlen(output_directory) + 1 + name_length + strlen(BATCH_OUTPUT_EXTENSION) + 1;
+    char *path = malloc(length);
+    if (path != NULL)
+    {
+        snprintf(path, length, "%s/%.*s%s", output_directory, (int)name_length, name, BATCH_OUTPUT_EXTENSION);
+    }
+    return path;
+}
+
+/**
+ * Compares the output paths of two sources for qsort
+ */
+static int compare_outputs(const void *first, const void *second)
+{
+    const BatchFile *const *a = first;
+    const BatchFile *const *b = second;
+    return strcmp((*a)->output, (*b)->output);
+}
+
+/**
+ * Computes the output paths of the sources. Sources whose output path cannot be allocated
+ * or is shared with another source (the same file name in different directories) fail
+ * without being compiled, returns false if there is no memory
+ */
+static bool assign_outputs(Batch *batch)
+{
+    BatchFile **sorted = malloc(sizeof(BatchFile *) * (batch->count > 0 ? batch->count : 1));
+    if (sorted == NULL)
+    {
+        return false;
+    }
+    int sorted_count = 0;
+    for (int i = 0; i < batch->count; i++)
+    {
+        BatchFile *file = &batch->files[i];
+        file->output = output_path(batch->output_directory, file->source);
+        if (file->output == NULL)
+        {
+            file->result = ERR_INTERNAL;
+            file->diagnostics = file_message("Error: Cannot allocate the output path of %s.\n", file->source);
+        }
+        else
+        {
+            sorted[sorted_count++] = file;
+        }
+    }
+
+    qsort(sorted, sorted_count, sizeof(BatchFile *), compare_outputs);
+    for (int i = 0; i < sorted_count; i++)
+    {
+        bool shared = (i > 0 && strcmp(sorted[i]->output, sorted[i - 1]->output) == 0) ||
+                      (i + 1 < sorted_count && strcmp(sorted[i]->output, sorted[i + 1]->output) == 0);
+        if (shared)
+        {
+            sorted[i]->result = ERR_INTERNAL;
+            sorted[i]->diagnostics = file_message("Error: Output file %s is generated from another source too.\n",
+                                                  sorted[i]->output);
+        }
+    }
+    for (int i = 0; i < sorted_count; i++)
+    {
+        // The output of a failed source is removed so no stale code of an earlier run is left
+        if (sorted[i]->result != IFJ24_OK)
+        {
+            unlink(sorted[i]->output);
+            free(sorted[i]->output);
+            sorted[i]->output = NULL;
+        }
+    }
+    free(sorted);
+    return true;
+}
+
+/**
+ * Compiles one source and writes its code, the diagnostics are kept for the report.
+ * The output of a source that fails is removed.
+ */
+static void compile_file(const Batch *batch, BatchFile *file)
+{
+    if (file->output == NULL)
+    {
+        return;
+    }
+
+    size_t length;
+    char *source = read_file(file->source, &length);
+    if (source == NULL)
+    {
+        file->result = ERR_INTERNAL;
+        file->diagnostics = file_message("Error opening file: %s\n", file->source);
+        unlink(file->output);
+        return;
+    }
+
+    Ifj24Buffer code;
+    Ifj24Buffer diagnostics;
+    file->result = ifj24_compile(source, length, batch->options, &code, &diagnostics);
+    file->diagnostics = diagnostics.data;
+    free(source);
+    if (file->result != IFJ24_OK)
+    {
+        unlink(file->output);
+        return;
+    }
+
+    FILE *output_file = fopen(file->output, "w");
+    if (output_file == NULL || fwrite(code.data, 1, code.length, output_file) != code.length)
+    {
+        file->result = ERR_INTERNAL;
+        free(file->diagnostics);
+        file->diagnostics = file_message("Error: Cannot write output file %s.\n", file->output);
+    }
+    if (output_file != NULL && fclose(output_file) != 0 && file->result == IFJ24_OK)
+    {
+        file->result = ERR_INTERNAL;
+        free(file->diagnostics);
+        file->diagnostics = file_message("Error: Cannot write output file %s.\n", file->output);
+    }
+    if (file->result != IFJ24_OK)
+    {
+        unlink(file->output);
+    }
+    ifj24_free_buffer(&code);
+}
+
+/**
+ * Prints diagnostics with every line prefixed by the source
+ */
+static void print_diagnostics(const char *source, const char *diagnostics)
+{
+    while (*diagnostics != '\0')
+    {
+        const char *end = strchr(diagnostics, '\n');
+        size_t length = end != NULL ? (size_t)(end - diagnostics) : strlen(diagnostics);
+        fprintf(stderr, "%s: %.*s\n", source, (int)length, diagnostics);
+        diagnostics += end != NULL ? length + 1 : length;
+    }
+}
+
+/**
+ * Reports the finished sources not preceded by an unfinished one, called with the lock held
+ */
+static void report_finished(Batch *batch)
+{
+    while (batch->next_report < batch->count && batch->files[batch->next_report].done)
+    {
+        BatchFile *file = &batch->files[batch->next_report++];
+        if (file->diagnostics != NULL)
+        {
+            print_diagnostics(file->source, file->diagnostics);
+            free(file->diagnostics);
+            file->diagnostics = NULL;
+        }
+        if (file->result == IFJ24_OK)
+        {
+            printf("%s: ok\n", file->source);
+        }
+        else
+        {
+            printf("%s: error %d (%s)\n", file->source, file->result, ifj24_error_message(file->result));
+            batch->failed++;
+        }
+    }
+    fflush(stdout);
+}
+
+/**
+ * Compiles sources until none is left
+ */
+static void *run_worker(void *argument)
+{
+    Batch *batch = argument;
+    for (;;)
+    {
+        pthread_mutex_lock(&batch->lock);
+        int index = batch->next_file++;
+        pthread_mutex_unlock(&batch->lock);
+        if (index >= batch->count)
+        {
+            return NULL;
+        }
+
+        compile_file(batch, &batch->files[index]);
+
+        pthread_mutex_lock(&batch->lock);
+        batch->files[index].done = true;
+        report_finished(batch);
+        pthread_mutex_unlock(&batch->lock);
+    }
+}
+
+/**
+ * Compiles the sources into the output directory on the worker threads
+ */
+int batch_run(const char *const *sources, int count, const char *output_directory, int workers,
+              const Ifj24Options *options)
+{
+    if (mkdir(output_directory, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create the output directory %s: %s\n", output_directory, strerror(errno));
+        return ERR_INTERNAL;
+    }
+
+    Batch batch;
+    batch.files = calloc(count > 0 ? count : 1, sizeof(BatchFile));
+    pthread_t *pool = calloc(workers, sizeof(pthread_t));
+    if (batch.files == NULL || pool == NULL)
+    {
+        free(batch.files);
+        free(pool);
+        fprintf(stderr, "Failed to allocate the batch\n");
+        return ERR_INTERNAL;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        batch.files[i].source = sources[i];
+    }
+    batch.count = count;
+    batch.output_directory = output_directory;
+    batch.options = options;
+    batch.next_file = 0;
+    batch.next_report = 0;
+    batch.failed = 0;
+    if (!assign_outputs(&batch))
+    {
+        free(batch.files);
+        free(pool);
+        fprintf(stderr, "Failed to allocate the batch\n");
+        return ERR_INTERNAL;
+    }
+    pthread_mutex_init(&batch.lock, NULL);
+
+    // Without any worker thread the sources are compiled here
+    int started = 0;
+    while (started < workers && started < count && pthread_create(&pool[started], NULL, run_worker, &batch) == 0)
+    {
+        started++;
+    }
+    if (started == 0)
+    {
+        run_worker(&batch);
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(pool[i], NULL);
+    }
+    printf("%d files, %d failed\n", count, batch.failed);
+
+    int result = ERR_OK;
+    for (int i = 0; i < count; i++)
+    {
+        result = result == ERR_OK ? batch.files[i].result : result;
+        free(batch.files[i].output);
+    }
+    pthread_mutex_destroy(&batch.lock);
+    free(batch.files);
+    free(pool);
+    return result;
+}
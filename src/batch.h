@@ -0,0 +1,29 @@
+/**
+ * @file batch.h
+ *
+ * Header file for the batch mode.
+ * Compiles many programs in one process on a pool of worker threads, each
+ * program with its own diagnostics and exit code.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "ifj24.h"
+
+/** Extension of the generated files */
+#define BATCH_OUTPUT_EXTENSION ".ifjcode24"
+
+// Compiles the sources into the output directory, a source a.ifj24 into a.ifjcode24.
+// Sources sharing an output file fail, the output file of a failed source is removed.
+// Prints a line per source in the given order, returns ERR_OK or the exit code of the first failed source.
+int batch_run(const char *const *sources, int count, const char *output_directory, int workers,
+              const Ifj24Options *options);
+
+#endif // BATCH_H
@@ -0,0 +1,563 @@
+/**
+ * @file cache.c
+ *
+ * Implementation of the compile cache.
+ * An entry <key>.entry starts with the line "IFJ24C1 result code_length
+ * diagnostics_length" followed by the code and the diagnostics. Reading an
+ * entry sets its modification time, which orders the entries for eviction.
+ * The code of a function is an entry of its own with no diagnostics.
+ * The counters are kept in the file "statistics", updated under a lock.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+#include "error.h"
+#include "parser.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** First word of an entry, changed with the format of entries */
+#define ENTRY_MAGIC "IFJ24C1"
+
+/** Extension of the entries */
+#define ENTRY_EXTENSION ".entry"
+
+/** File with the counters of the cache */
+#define STATISTICS_FILE "statistics"
+
+/**
+ * Counters of the cache
+ */
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    unsigned long function_hits;
+    unsigned long function_misses;
+} CacheStatistics;
+
+/**
+ * Entry file found when evicting
+ */
+typedef struct {
+    char *path;
+    off_t size;
+    struct timespec used;
+} CacheFile;
+
+/**
+ * Returns the path of a file of the cache in a new buffer
+ */
+static char *cache_path(const Cache *cache, const char *name, const char *extension)
+{
+    size_t length = strlen(cache->directory) + strlen(name) + strlen(extension) + 2;
+    char *path = malloc(length);
+    if (path != NULL)
+    {
+        snprintf(path, length, "%s/%s%s", cache->directory, name, extension);
+    }
+    return path;
+}
+
+/**
+ * Creates the cache directory unless it exists, returns false if there is none
+ */
+static bool create_directory(const Cache *cache)
+{
+    return mkdir(cache->directory, 0777) == 0 || errno == EEXIST;
+}
+
+/**
+ * Starts a hash of the version and of everything that changes the code besides the source:
+ * the passes, the inlining and the code generator
+ */
+static void start_key(const CompilerContext *context, Sha256 *hash)
+{
+    unsigned char options[PASS_COUNT + 1];
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        options[i] = context->passes.enabled[i];
+    }
+    options[PASS_COUNT] = context->options.ir_codegen;
+    int inline_threshold = context->codegen.inline_threshold;
+
+    sha256_init(hash);
+    sha256_update(hash, COMPILER_VERSION, sizeof(COMPILER_VERSION));
+    sha256_update(hash, options, sizeof(options));
+    sha256_update(hash, &inline_threshold, sizeof(inline_threshold));
+}
+
+/**
+ * Writes the hash as the key in hexadecimal digits
+ */
+static void finish_key(Sha256 *hash, char key[CACHE_KEY_LENGTH + 1])
+{
+    unsigned char digest[SHA256_SIZE];
+    sha256_final(hash, digest);
+    for (int i = 0; i < SHA256_SIZE; i++)
+    {
+        snprintf(key + 2 * i, 3, "%02x", digest[i]);
+    }
+}
+
+/**
+ * Returns the permissions of the entries, 0644 without the bits of the umask
+ */
+mode_t cache_entry_mode()
+{
+    mode_t mask = umask(0);
+    umask(mask);
+    return 0644 & ~mask;
+}
+
+/**
+ * Computes the key of a source compiled with the options and passes of the context
+ */
+void cache_key(const CompilerContext *context, const char *source, size_t length, char key[CACHE_KEY_LENGTH + 1])
+{
+    Sha256 hash;
+    start_key(context, &hash);
+    sha256_update(&hash, source, length);
+    finish_key(&hash, key);
+}
+
+/**
+ * Adds a name with its terminating zero to a hash
+ */
+static void hash_name(Sha256 *hash, const char *name)
+{
+    sha256_update(hash, name, strlen(name) + 1);
+}
+
+/**
+ * Computes the key of the code of a function. Besides its own tokens the code depends
+ * on the signatures of the functions it calls, all of them are hashed as that is cheap,
+ * and on the bodies of the functions it calls directly or indirectly, which may be inlined.
+ */
+bool cache_function_key(const CompilerContext *context, ASTNode *program_node, CallGraph *graph, ASTNode *function,
+                        char key[CACHE_KEY_LENGTH + 1])
+{
+    CallGraphNode *start = callgraph_find(graph, function->name);
+    if (start == NULL)
+    {
+        return false;
+    }
+
+    Sha256 hash;
+    start_key(context, &hash);
+    hash_name(&hash, "function");
+    for (ASTNode *node = program_node->body; node != NULL; node = node->next)
+    {
+        hash_name(&hash, node->name);
+        sha256_update(&hash, &node->data_type, sizeof(node->data_type));
+        for (int i = 0; i < node->param_count; i++)
+        {
+            hash_name(&hash, node->parameters[i]->name);
+            sha256_update(&hash, &node->parameters[i]->data_type, sizeof(node->parameters[i]->data_type));
+        }
+    }
+
+    // Depth-first search of the called functions, every function is pushed once
+    bool *visited = calloc(graph->count, sizeof(bool));
+    CallGraphNode **stack = malloc(graph->count * sizeof(CallGraphNode *));
+    bool valid = visited != NULL && stack != NULL;
+    int stack_size = 0;
+    if (valid)
+    {
+        visited[start - graph->nodes] = true;
+        stack[stack_size++] = start;
+    }
+    while (valid && stack_size > 0)
+    {
+        CallGraphNode *node = stack[--stack_size];
+        const unsigned char *tokens = parser_function_tokens(node->function->name);
+        if (tokens == NULL)
+        {
+            valid = false;
+            break;
+        }
+        hash_name(&hash, node->function->name);
+        sha256_update(&hash, tokens, SHA256_SIZE);
+        for (CallEdge *edge = node->edges; edge != NULL; edge = edge->next)
+        {
+            if (!visited[edge->callee - graph->nodes])
+            {
+                visited[edge->callee - graph->nodes] = true;
+                stack[stack_size++] = edge->callee;
+            }
+        }
+    }
+    free(visited);
+    free(stack);
+    if (valid)
+    {
+        finish_key(&hash, key);
+    }
+    return valid;
+}
+
+/**
+ * Parses the counters of the statistics file, the ones it does not have stay as they are
+ */
+static void read_statistics(const char *text, CacheStatistics *statistics)
+{
+    sscanf(text, "hits %lu misses %lu evictions %lu function_hits %lu function_misses %lu", &statistics->hits,
+           &statistics->misses, &statistics->evictions, &statistics->function_hits, &statistics->function_misses);
+}
+
+/**
+ * Adds to the counters of the cache, the file is locked so concurrent compilers count correctly
+ */
+static void add_to_statistics(const Cache *cache, const CacheStatistics *change)
+{
+    char *path = create_directory(cache) ? cache_path(cache, STATISTICS_FILE, "") : NULL;
+    int file = path != NULL ? open(path, O_RDWR | O_CREAT, 0666) : -1;
+    free(path);
+    if (file < 0)
+    {
+        return;
+    }
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (fcntl(file, F_SETLKW, &lock) == 0)
+    {
+        char text[256];
+        ssize_t length = read(file, text, sizeof(text) - 1);
+        text[length > 0 ? length : 0] = '\0';
+        CacheStatistics statistics = {0, 0, 0, 0, 0};
+        read_statistics(text, &statistics);
+
+        length = snprintf(text, sizeof(text), "hits %lu\nmisses %lu\nevictions %lu\nfunction_hits %lu\nfunction_misses %lu\n",
+                          statistics.hits + change->hits, statistics.misses + change->misses,
+                          statistics.evictions + change->evictions, statistics.function_hits + change->function_hits,
+                          statistics.function_misses + change->function_misses);
+        if (lseek(file, 0, SEEK_SET) == 0 && write(file, text, length) == length)
+        {
+            // The counters only grow, so the text is never shorter than before and the truncate only removes
+            // what follows the counters in a damaged file. If it fails, read_statistics ignores that text.
+            (void)ftruncate(file, length);
+        }
+    }
+    close(file); // Releases the lock
+}
+
+/**
+ * Reads an entry file, returns false if it is missing or damaged
+ */
+static bool read_entry(const char *path, CacheEntry *entry)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    char magic[sizeof(ENTRY_MAGIC)];
+    bool valid = fscanf(file, "%7s %d %zu %zu", magic, &entry->result, &entry->code_length, &entry->diagnostics_length) == 4 &&
+                 strcmp(magic, ENTRY_MAGIC) == 0 && fgetc(file) == '\n';
+    entry->code = valid ? malloc(entry->code_length + 1) : NULL;
+    entry->diagnostics = valid ? malloc(entry->diagnostics_length + 1) : NULL;
+    valid = entry->code != NULL && entry->diagnostics != NULL &&
+            fread(entry->code, 1, entry->code_length, file) == entry->code_length &&
+            fread(entry->diagnostics, 1, entry->diagnostics_length, file) == entry->diagnostics_length &&
+            fgetc(file) == EOF;
+    fclose(file);
+    if (!valid)
+    {
+        cache_free_entry(entry);
+        return false;
+    }
+    entry->code[entry->code_length] = '\0';
+    entry->diagnostics[entry->diagnostics_length] = '\0';
+    return true;
+}
+
+/**
+ * Reads the entry of a key and marks it used
+ */
+static bool use_entry(const Cache *cache, const char *key, CacheEntry *entry)
+{
+    char *path = cache_path(cache, key, ENTRY_EXTENSION);
+    bool hit = path != NULL && read_entry(path, entry);
+    if (hit)
+    {
+        utimensat(AT_FDCWD, path, NULL, 0); // Most recently used now
+    }
+    free(path);
+    return hit;
+}
+
+/**
+ * Reads the entry of a key, counting a hit or a miss
+ */
+bool cache_lookup(const Cache *cache, const char *key, CacheEntry *entry)
+{
+    bool hit = use_entry(cache, key, entry);
+    CacheStatistics change = {hit ? 1 : 0, hit ? 0 : 1, 0, 0, 0};
+    add_to_statistics(cache, &change);
+    return hit;
+}
+
+/**
+ * Reads the code of a function, counted by cache_count_functions
+ */
+bool cache_lookup_function(const Cache *cache, const char *key, CacheEntry *entry)
+{
+    return use_entry(cache, key, entry);
+}
+
+/**
+ * Orders entry files from the least recently used
+ */
+static int compare_use(const void *first, const void *second)
+{
+    const struct timespec *a = &((const CacheFile *)first)->used;
+    const struct timespec *b = &((const CacheFile *)second)->used;
+    if (a->tv_sec != b->tv_sec)
+    {
+        return a->tv_sec < b->tv_sec ? -1 : 1;
+    }
+    return (a->tv_nsec > b->tv_nsec) - (a->tv_nsec < b->tv_nsec);
+}
+
+/**
+ * Lists the entry files of the cache with their sizes, returns their number or -1
+ */
+static int list_entries(const Cache *cache, CacheFile **files, size_t *total_size)
+{
+    DIR *directory = opendir(cache->directory);
+    if (directory == NULL)
+    {
+        return -1;
+    }
+    int count = 0;
+    int capacity = 64;
+    *files = malloc(capacity * sizeof(CacheFile));
+    *total_size = 0;
+    struct dirent *item;
+    while (*files != NULL && (item = readdir(directory)) != NULL)
+    {
+        size_t length = strlen(item->d_name);
+        size_t extension_length = strlen(ENTRY_EXTENSION);
+        if (length <= extension_length || strcmp(item->d_name + length - extension_length, ENTRY_EXTENSION) != 0)
+        {
+            continue;
+        }
+        char *path = cache_path(cache, item->d_name, "");
+        struct stat info;
+        if (path == NULL || stat(path, &info) != 0)
+        {
+            free(path);
+            continue;
+        }
+        if (count == capacity)
+        {
+            capacity *= 2;
+            CacheFile *larger = realloc(*files, capacity * sizeof(CacheFile));
+            if (larger == NULL)
+            {
+                free(path);
+                break;
+            }
+            *files = larger;
+        }
+        (*files)[count].path = path;
+        (*files)[count].size = info.st_size;
+        (*files)[count].used = info.st_mtim;
+        *total_size += info.st_size;
+        count++;
+    }
+    closedir(directory);
+    return *files != NULL ? count : -1;
+}
+
+/**
+ * Removes the least recently used entries until the entries fit the size of the cache
+ */
+static void evict(const Cache *cache)
+{
+    CacheFile *files;
+    size_t total_size;
+    int file_count = list_entries(cache, &files, &total_size);
+    if (file_count < 0)
+    {
+        return;
+    }
+    unsigned long evictions = 0;
+    if (total_size > cache->max_size)
+    {
+        qsort(files, file_count, sizeof(CacheFile), compare_use);
+        for (int i = 0; i < file_count && total_size > cache->max_size; i++)
+        {
+            // Another compiler may have removed it already
+            if (unlink(files[i].path) == 0)
+            {
+                evictions++;
+            }
+            total_size -= files[i].size;
+        }
+    }
+    for (int i = 0; i < file_count; i++)
+    {
+        free(files[i].path);
+    }
+    free(files);
+    if (evictions > 0)
+    {
+        CacheStatistics change = {0, 0, evictions, 0, 0};
+        add_to_statistics(cache, &change);
+    }
+}
+
+/**
+ * Writes all bytes to a file descriptor
+ */
+static bool write_all(int file, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(file, data, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * Writes the entry of a key to a temporary file renamed to the entry. mkstemp creates
+ * the file readable only by its owner, the entry gets the mode of the cache.
+ */
+static void write_entry(const Cache *cache, const char *key, const CacheEntry *entry)
+{
+    if (!create_directory(cache))
+    {
+        return;
+    }
+    char *path = cache_path(cache, key, ENTRY_EXTENSION);
+    char *temporary_path = cache_path(cache, ".tmp-", "XXXXXX");
+    int file = path != NULL && temporary_path != NULL ? mkstemp(temporary_path) : -1;
+    if (file < 0)
+    {
+        free(path);
+        free(temporary_path);
+        return;
+    }
+
+    char header[128];
+    size_t code_length = entry->result == ERR_OK ? entry->code_length : 0;
+    int header_length = snprintf(header, sizeof(header), "%s %d %zu %zu\n", ENTRY_MAGIC, entry->result, code_length,
+                                 entry->diagnostics_length);
+    bool written = write_all(file, header, header_length) && write_all(file, entry->code, code_length) &&
+                   write_all(file, entry->diagnostics, entry->diagnostics_length);
+    written = written && fchmod(file, cache->mode) == 0;
+    if (close(file) != 0 || !written || rename(temporary_path, path) != 0)
+    {
+        unlink(temporary_path);
+    }
+    free(path);
+    free(temporary_path);
+}
+
+/**
+ * Stores the entry of a key and evicts the least recently used entries
+ */
+void cache_store(const Cache *cache, const char *key, const CacheEntry *entry)
+{
+    write_entry(cache, key, entry);
+    evict(cache);
+}
+
+/**
+ * Stores the code of a function as an entry without diagnostics
+ */
+void cache_store_function(const Cache *cache, const char *key, const char *code, size_t length)
+{
+    CacheEntry entry = {ERR_OK, (char *)code, length, "", 0};
+    write_entry(cache, key, &entry);
+}
+
+/**
+ * Counts the functions of one compilation found and not found, the functions not found were stored
+ */
+void cache_count_functions(const Cache *cache, unsigned long hits, unsigned long misses)
+{
+    CacheStatistics change = {0, 0, 0, hits, misses};
+    add_to_statistics(cache, &change);
+    if (misses > 0)
+    {
+        evict(cache);
+    }
+}
+
+/**
+ * Frees the buffers of an entry
+ */
+void cache_free_entry(CacheEntry *entry)
+{
+    free(entry->code);
+    free(entry->diagnostics);
+    entry->code = NULL;
+    entry->diagnostics = NULL;
+}
+
+/**
+ * Prints the counters and the size of the cache
+ */
+void cache_print_statistics(const Cache *cache, FILE *output)
+{
+    CacheStatistics statistics = {0, 0, 0, 0, 0};
+    char *path = cache_path(cache, STATISTICS_FILE, "");
+    FILE *file = path != NULL ? fopen(path, "r") : NULL;
+    if (file != NULL)
+    {
+        char text[256];
+        size_t length = fread(text, 1, sizeof(text) - 1, file);
+        text[length] = '\0';
+        read_statistics(text, &statistics);
+        fclose(file);
+    }
+    free(path);
+
+    CacheFile *files;
+    size_t total_size = 0;
+    int file_count = list_entries(cache, &files, &total_size);
+    for (int i = 0; i < file_count; i++)
+    {
+        free(files[i].path);
+    }
+    if (file_count >= 0)
+    {
+        free(files);
+    }
+
+    unsigned long lookups = statistics.hits + statistics.misses;
+    fprintf(output, "Cache %s\n", cache->directory);
+    fprintf(output, "  entries:   %d (%zu of %zu bytes)\n", file_count > 0 ? file_count : 0, total_size, cache->max_size);
+    fprintf(output, "  hits:      %lu (%.1f %%)\n", statistics.hits, lookups > 0 ? 100.0 * statistics.hits / lookups : 0.0);
+    fprintf(output, "  misses:    %lu\n", statistics.misses);
+    fprintf(output, "  evictions: %lu\n", statistics.evictions);
+    unsigned long function_lookups = statistics.function_hits + statistics.function_misses;
+    fprintf(output, "  functions: %lu hits of %lu (%.1f %%)\n", statistics.function_hits, function_lookups,
+            function_lookups > 0 ? 100.0 * statistics.function_hits / function_lookups : 0.0);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file cache.h
+ *
+ * Header file for the compile cache.
+ * The cache is a directory of entries named by the SHA-256 hash of the
+ * compiler version, the options changing the generated code and the source.
+ * An entry holds the exit code, the code and the diagnostics of a compilation,
+ * so a program compiled before is answered without scanning it. Entries are
+ * written to a temporary file and renamed, so concurrent compilers never see
+ * a partial one, and the least recently used entries are removed once the
+ * entries take more than the size of the cache.
+ * A compilation missing the cache keeps the code of each of its functions
+ * as well, keyed by the tokens of the body, the signatures of all functions
+ * and the bodies of the functions it calls (their bodies may be inlined),
+ * so changing a function generates only it and its callers again.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include "callgraph.h"
+#include "compiler.h"
+#include "sha256.h"
+
+/** Length of a key, the hash in hexadecimal digits */
+#define CACHE_KEY_LENGTH (2 * SHA256_SIZE)
+
+/** Size of a cache in megabytes unless given by --cache-size */
+#define CACHE_DEFAULT_SIZE_MB 64
+
+/**
+ * Cache directory
+ */
+typedef struct Cache {
+    const char *directory;
+    size_t max_size; // Bytes of the entries kept when evicting
+    mode_t mode;     // Permissions of the entries, readable by the other users sharing the directory
+} Cache;
+
+/**
+ * Outcome of a compilation stored in the cache, the buffers are freed with free()
+ */
+typedef struct {
+    int result;
+    char *code; // Only when result is ERR_OK
+    size_t code_length;
+    char *diagnostics;
+    size_t diagnostics_length;
+} CacheEntry;
+
+// Returns 0644 without the bits of the umask. Changes the umask for a moment, so it is called before any thread starts.
+mode_t cache_entry_mode();
+
+// Computes the key of a source compiled with the options and passes of the context
+void cache_key(const CompilerContext *context, const char *source, size_t length, char key[CACHE_KEY_LENGTH + 1]);
+
+// Reads the entry of a key, counting a hit or a miss. Returns false on a miss.
+bool cache_lookup(const Cache *cache, const char *key, CacheEntry *entry);
+
+// Stores the entry of a key and evicts the least recently used entries over the size of the cache
+void cache_store(const Cache *cache, const char *key, const CacheEntry *entry);
+
+// Computes the key of the code of a function, returns false if the bodies of the program were not hashed
+bool cache_function_key(const CompilerContext *context, ASTNode *program_node, CallGraph *graph, ASTNode *function,
+                        char key[CACHE_KEY_LENGTH + 1]);
+
+// Reads the code of a function, counted by cache_count_functions. Returns false on a miss.
+bool cache_lookup_function(const Cache *cache, const char *key, CacheEntry *entry);
+
+// Stores the code of a function, evicting is left to cache_count_functions
+void cache_store_function(const Cache *cache, const char *key, const char *code, size_t length);
+
+// Counts the functions of one compilation found and not found, evicts if some were stored
+void cache_count_functions(const Cache *cache, unsigned long hits, unsigned long misses);
+
+// Frees the buffers of an entry
+void cache_free_entry(CacheEntry *entry);
+
+// Prints the counters and the size of the cache
+void cache_print_statistics(const Cache *cache, FILE *output);
+
+#endif // CACHE_H
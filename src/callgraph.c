@@ -0,0 +1,307 @@
+/**
+ * @file callgraph.c
+ *
+ * Implementation of the whole-program call graph.
+ * Used for unused function elimination and recursion detection.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "callgraph.h"
+#include "utils.h"
+#include <string.h>
+
+/**
+ * Finds the graph node of a function by its name
+ */
+CallGraphNode *callgraph_find(CallGraph *graph, const char *function_name)
+{
+    if (graph == NULL || function_name == NULL)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < graph->count; i++)
+    {
+        if (strcmp(graph->nodes[i].function->name, function_name) == 0)
+        {
+            return &graph->nodes[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Adds a call site to the edge between caller and callee
+ */
+static void add_call_edge(CallGraphNode *caller, CallGraphNode *callee)
+{
+    for (CallEdge *edge = caller->edges; edge != NULL; edge = edge->next)
+    {
+        if (edge->callee == callee)
+        {
+            edge->call_count++;
+            return;
+        }
+    }
+    CallEdge *edge = (CallEdge *)safe_malloc(sizeof(CallEdge));
+    edge->callee = callee;
+    edge->call_count = 1;
+    edge->next = NULL;
+
+    // Keep edges in order of the first call site
+    if (caller->edges == NULL)
+    {
+        caller->edges = edge;
+        return;
+    }
+    CallEdge *last = caller->edges;
+    while (last->next != NULL)
+    {
+        last = last->next;
+    }
+    last->next = edge;
+}
+
+/**
+ * Collects call sites from a subtree of a function body
+ */
+static void collect_call_edges(CallGraph *graph, CallGraphNode *caller, ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        CallGraphNode *callee = callgraph_find(graph, node->name);
+        if (callee != NULL)
+        {
+            add_call_edge(caller, callee);
+        }
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            collect_call_edges(graph, caller, node->arguments[i]);
+        }
+    }
+
+    collect_call_edges(graph, caller, node->condition);
+    collect_call_edges(graph, caller, node->left);
+    collect_call_edges(graph, caller, node->right);
+    collect_call_edges(graph, caller, node->body);
+    collect_call_edges(graph, caller, node->next);
+}
+
+/**
+ * Counts AST nodes of a subtree, used as the size estimate of a function
+ */
+static int count_nodes(ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return 0;
+    }
+    int count = 1;
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            count += count_nodes(node->arguments[i]);
+        }
+    }
+    return count + count_nodes(node->condition) + count_nodes(node->left) + count_nodes(node->right) +
+           count_nodes(node->body) + count_nodes(node->next);
+}
+
+/**
+ * Marks all functions transitively called from a node
+ */
+static void mark_reachable(CallGraphNode *node)
+{
+    if (node->is_reachable)
+    {
+        return;
+    }
+    node->is_reachable = true;
+    for (CallEdge *edge = node->edges; edge != NULL; edge = edge->next)
+    {
+        mark_reachable(edge->callee);
+    }
+}
+
+/**
+ * Tarjan's strongly connected components algorithm
+ */
+static void strong_connect(CallGraph *graph, CallGraphNode *node, CallGraphNode **stack, int *stack_top, int *index)
+{
+    node->index = node->lowlink = (*index)++;
+    stack[(*stack_top)++] = node;
+    node->on_stack = true;
+
+    for (CallEdge *edge = node->edges; edge != NULL; edge = edge->next)
+    {
+        CallGraphNode *callee = edge->callee;
+        if (callee->index < 0)
+        {
+            strong_connect(graph, callee, stack, stack_top, index);
+            if (callee->lowlink < node->lowlink)
+            {
+                node->lowlink = callee->lowlink;
+            }
+        }
+        else if (callee->on_stack && callee->index < node->lowlink)
+        {
+            node->lowlink = callee->index;
+        }
+        if (callee == node)
+        {
+            node->is_recursive = true;
+        }
+    }
+
+    if (node->lowlink == node->index)
+    {
+        int scc_id = graph->scc_count++;
+        int scc_size = 0;
+        CallGraphNode *member;
+        do
+        {
+            member = stack[--(*stack_top)];
+            member->on_stack = false;
+            member->scc_id = scc_id;
+            scc_size++;
+        } while (member != node);
+
+        // Every member of a component with more functions is mutually recursive
+        if (scc_size > 1)
+        {
+            for (int i = 0; i < graph->count; i++)
+            {
+                if (graph->nodes[i].scc_id == scc_id)
+                {
+                    graph->nodes[i].is_recursive = true;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Builds the call graph of the program.
+ * Reachability is computed from main, SCCs over all functions.
+ */
+CallGraph *callgraph_build(ASTNode *program_node)
+{
+    CallGraph *graph = (CallGraph *)safe_malloc(sizeof(CallGraph));
+    graph->count = 0;
+    graph->scc_count = 0;
+    graph->nodes = NULL;
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION)
+        {
+            graph->count++;
+        }
+    }
+    if (graph->count == 0)
+    {
+        return graph;
+    }
+
+    graph->nodes = (CallGraphNode *)safe_malloc(sizeof(CallGraphNode) * graph->count);
+    int i = 0;
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION)
+        {
+            CallGraphNode *node = &graph->nodes[i++];
+            node->function = function;
+            node->edges = NULL;
+            node->is_reachable = false;
+            node->is_recursive = false;
+            node->scc_id = -1;
+            node->size = count_nodes(function->body);
+            node->index = -1;
+            node->lowlink = -1;
+            node->on_stack = false;
+        }
+    }
+
+    for (i = 0; i < graph->count; i++)
+    {
+        if (graph->nodes[i].function->body != NULL)
+        {
+            collect_call_edges(graph, &graph->nodes[i], graph->nodes[i].function->body->body);
+        }
+    }
+
+    CallGraphNode *main_node = callgraph_find(graph, "main");
+    if (main_node != NULL)
+    {
+        mark_reachable(main_node);
+    }
+
+    CallGraphNode **stack = (CallGraphNode **)safe_malloc(sizeof(CallGraphNode *) * graph->count);
+    int stack_top = 0;
+    int index = 0;
+    for (i = 0; i < graph->count; i++)
+    {
+        if (graph->nodes[i].index < 0)
+        {
+            strong_connect(graph, &graph->nodes[i], stack, &stack_top, &index);
+        }
+    }
+    safe_free(stack);
+
+    return graph;
+}
+
+/**
+ * Checks if a function is transitively called from main
+ */
+bool callgraph_is_reachable(CallGraph *graph, const char *function_name)
+{
+    CallGraphNode *node = callgraph_find(graph, function_name);
+    return node != NULL && node->is_reachable;
+}
+
+/**
+ * Checks if a function can call itself (directly or through other functions)
+ */
+bool callgraph_is_recursive(CallGraph *graph, const char *function_name)
+{
+    CallGraphNode *node = callgraph_find(graph, function_name);
+    return node != NULL && node->is_recursive;
+}
+
+/**
+ * Writes the call graph in DOT format.
+ * Unreachable functions are dashed, recursive ones are drawn as double circles.
+ */
+void callgraph_dump(CallGraph *graph, FILE *output)
+{
+    fprintf(output, "digraph callgraph {\n");
+    for (int i = 0; i < graph->count; i++)
+    {
+        CallGraphNode *node = &graph->nodes[i];
+        fprintf(output, "    \"%s\" [label=\"%s\\nscc %d\"%s%s];\n",
+                node->function->name, node->function->name, node->scc_id,
+                node->is_reachable ? "" : ", style=dashed",
+                node->is_recursive ? ", shape=doublecircle" : "");
+    }
+    for (int i = 0; i < graph->count; i++)
+    {
+        CallGraphNode *node = &graph->nodes[i];
+        for (CallEdge *edge = node->edges; edge != NULL; edge = edge->next)
+        {
+            fprintf(output, "    \"%s\" -> \"%s\" [label=\"%d\"];\n",
+                    node->function->name, edge->callee->function->name, edge->call_count);
+        }
+    }
+    fprintf(output, "}\n");
+}
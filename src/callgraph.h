@@ -0,0 +1,70 @@
+/**
+ * @file callgraph.h
+ *
+ * Header file for the whole-program call graph.
+ * Nodes are user-defined functions, edges are call sites (built-in
+ * ifj functions are not part of the graph).
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "ast.h"
+
+struct CallGraphNode;
+
+/**
+ * Edge between caller and callee, counts all call sites of the callee in the caller
+ */
+typedef struct CallEdge {
+    struct CallGraphNode *callee;
+    int call_count;
+    struct CallEdge *next;
+} CallEdge;
+
+/**
+ * Node of the call graph (one user-defined function)
+ */
+typedef struct CallGraphNode {
+    ASTNode *function;
+    CallEdge *edges;
+    bool is_reachable;  // Transitively called from main
+    bool is_recursive;  // Part of a cycle, including a direct self call
+    int scc_id;         // Strongly connected component, numbered in reverse topological order
+    int size;           // Number of AST nodes in the body
+
+    // Tarjan's algorithm state
+    int index;
+    int lowlink;
+    bool on_stack;
+} CallGraphNode;
+
+/**
+ * Call graph of the whole program
+ */
+typedef struct {
+    CallGraphNode *nodes;
+    int count;
+    int scc_count;
+} CallGraph;
+
+// Builds the call graph, computes reachability from main and SCCs
+CallGraph *callgraph_build(ASTNode *program_node);
+
+// Graph queries
+CallGraphNode *callgraph_find(CallGraph *graph, const char *function_name);
+bool callgraph_is_reachable(CallGraph *graph, const char *function_name);
+bool callgraph_is_recursive(CallGraph *graph, const char *function_name);
+
+// Writes the graph in DOT format with call site counts on edges
+void callgraph_dump(CallGraph *graph, FILE *output);
+
+#endif // CALLGRAPH_H
@@ -0,0 +1,141 @@
+/**
+ * @file client.c
+ *
+ * Client of the compile server, used like the compiler itself:
+ * sends the source to a server started with --server and writes the code
+ * and the diagnostics it gets back, exiting with the code of the compilation.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "error.h"
+#include "protocol.h"
+
+/**
+ * Reads a whole stream into memory, returns NULL if there is no memory
+ */
+static char *read_source(FILE *source_file, size_t *length) {
+    size_t capacity = 4096;
+    char *source = malloc(capacity);
+    *length = 0;
+    while (source != NULL) {
+        *length += fread(source + *length, 1, capacity - *length, source_file);
+        if (*length < capacity) {
+            return source;
+        }
+        capacity *= 2;
+        char *larger = realloc(source, capacity);
+        if (!larger) {
+            free(source);
+        }
+        source = larger;
+    }
+    return NULL;
+}
+
+/**
+ * Connects to the socket of the server, returns -1 on failure
+ */
+static int connect_to_server(const char *socket_path) {
+    struct sockaddr_un address;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", socket_path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", socket_path, strerror(errno));
+        if (connection >= 0) {
+            close(connection);
+        }
+        return -1;
+    }
+    return connection;
+}
+
+/**
+ * Main function of the client.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "Usage: %s socket [source_file] [output_file]\n", argv[0]);
+        return ERR_INTERNAL;
+    }
+
+    // Read the source file or the standard input
+    FILE *source_file = stdin;
+    if (argc > 2) {
+        source_file = fopen(argv[2], "r");
+        if (!source_file) {
+            fprintf(stderr, "Error opening file: %s\n", argv[2]);
+            return ERR_INTERNAL;
+        }
+    }
+    size_t source_length;
+    char *source = read_source(source_file, &source_length);
+    if (source_file != stdin) {
+        fclose(source_file);
+    }
+    if (!source) {
+        fprintf(stderr, "Failed to read the source\n");
+        return ERR_INTERNAL;
+    }
+
+    // Let the server compile it (protocol.c)
+    int connection = connect_to_server(argv[1]);
+    if (connection < 0) {
+        free(source);
+        return ERR_INTERNAL;
+    }
+    int result = ERR_INTERNAL;
+    char *code = NULL;
+    size_t code_length = 0;
+    char *diagnostics = NULL;
+    size_t diagnostics_length = 0;
+    if (!protocol_send_request(connection, source, source_length) ||
+        !protocol_receive_response(connection, &result, &code, &code_length, &diagnostics, &diagnostics_length)) {
+        fprintf(stderr, "No response from the server\n");
+        result = ERR_INTERNAL;
+    }
+    close(connection);
+    free(source);
+
+    // Write the diagnostics, and the code when the program compiled
+    if (diagnostics_length > 0) {
+        fwrite(diagnostics, 1, diagnostics_length, stderr);
+    }
+    if (result == ERR_OK) {
+        FILE *output_file = argc > 3 ? fopen(argv[3], "w") : stdout;
+        if (!output_file) {
+            fprintf(stderr, "Error: Cannot open output file %s for writing.\n", argv[3]);
+            result = ERR_INTERNAL;
+        } else {
+            fwrite(code, 1, code_length, output_file);
+            if (output_file != stdout) {
+                fclose(output_file);
+            }
+        }
+    }
+    free(code);
+    free(diagnostics);
+
+    return result;
+}
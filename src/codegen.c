@@ -11,37 +11,59 @@
  *   <xkovin00> Viktoriia Kovin
  *   <xshmon00> Gleb Shmonin
  */
+#define _POSIX_C_SOURCE 200809L
 
 #include "codegen.h"
 #include "ast.h"
+#include "cache.h"
+#include "callgraph.h"
+#include "compiler.h"
+#include "optimizer.h"
+#include "gvn.h"
+#include "nullness.h"
 #include "parser.h"
+#include "range.h"
 #include "utils.h"
 #include "error.h"
+#include <pthread.h>
+#include <setjmp.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static TempVarMapEntry *temp_var_map = NULL;
-static int unique_var_counter = 0;
-static int temp_var_counter = 0;
-static BuiltinFunctionUsage builtin_function_usage = {false, false, false};
+static void codegen_generate_inlined_body(FILE *output, ASTNode *call, ASTNode *function);
+static void reset_hoisted_expressions();
 
-DeclaredVar *declared_vars = NULL;
-TempVar *temp_vars = NULL;
+/**
+ * Returns the state of the code generator in the current compiler context.
+ */
+static CodegenState *codegen_state() {
+    return &compiler_context_current()->codegen;
+}
 
-/** Global variable for storing the output file */
-static FILE *output_file;
+/**
+ * Initializes the state of the code generator of a new compiler context.
+ * All optimizations are enabled unless the pass manager turns them off.
+ */
+void codegen_state_init(CodegenState *state) {
+    CodegenOptions all_enabled = {true, true, true, true, true, true, true,
+                                  true, true, true, true, true, true, true};
+    state->options = all_enabled;
+    state->inline_threshold = DEFAULT_INLINE_THRESHOLD;
+    state->inline_end_label = -1;
+}
 
 int get_next_temp_var() {
-    return temp_var_counter++;
+    return codegen_state()->temp_var_counter++;
 }
 
 /**
  * Adds a temporary variable to the list if not already added.
  */
 void add_temp_var(const char *var_name) {
-    TempVar *current = temp_vars;
+    CodegenState *state = codegen_state();
+    TempVar *current = state->temp_vars;
     while (current) {
         if (strcmp(current->name, var_name) == 0) {
             return; // Variable already added
@@ -51,29 +73,29 @@ void add_temp_var(const char *var_name) {
 
     TempVar *new_var = safe_malloc(sizeof(TempVar));
     new_var->name = string_duplicate(var_name);
-    new_var->next = temp_vars;
-    temp_vars = new_var;
+    new_var->next = state->temp_vars;
+    state->temp_vars = new_var;
 }
 
 /**
  * Resets the list of temporary variables.
  */
 void reset_temp_vars() {
-    TempVar *current = temp_vars;
+    TempVar *current = codegen_state()->temp_vars;
     while (current) {
         TempVar *next = current->next;
         safe_free(current->name);
         safe_free(current);
         current = next;
     }
-    temp_vars = NULL;
+    codegen_state()->temp_vars = NULL;
 }
 
 /**
  * Checks if a variable is already declared.
  */
 bool is_variable_declared(const char *var_name) {
-    DeclaredVar *current = declared_vars;
+    DeclaredVar *current = codegen_state()->declared_vars;
     while (current) {
         if (strcmp(current->var_name, var_name) == 0) {
             return true;
@@ -93,15 +115,15 @@ void add_declared_variable(const char *var_name) {
     }
     DeclaredVar *new_var = safe_malloc(sizeof(DeclaredVar));
     new_var->var_name = string_duplicate(var_name);
-    new_var->next = declared_vars;
-    declared_vars = new_var;
+    new_var->next = codegen_state()->declared_vars;
+    codegen_state()->declared_vars = new_var;
 }
 
 /**
  * Resets the temporary variable map.
  */
 void reset_temp_var_map() {
-    TempVarMapEntry *entry = temp_var_map;
+    TempVarMapEntry *entry = codegen_state()->temp_var_map;
     while (entry != NULL) {
         TempVarMapEntry *next = entry->next;
         safe_free(entry->var_name);
@@ -109,21 +131,21 @@ void reset_temp_var_map() {
         safe_free(entry);
         entry = next;
     }
-    temp_var_map = NULL;
+    codegen_state()->temp_var_map = NULL;
 }
 
 /**
  * Resets the list of declared variables.
  */
 void reset_declared_variables() {
-    DeclaredVar *current = declared_vars;
+    DeclaredVar *current = codegen_state()->declared_vars;
     while (current) {
         DeclaredVar *next = current->next;
         safe_free(current->var_name);
         safe_free(current);
         current = next;
     }
-    declared_vars = NULL;
+    codegen_state()->declared_vars = NULL;
 }
 
 /**
@@ -131,8 +153,9 @@ void reset_declared_variables() {
  * Optionally maps the variable name to an AST node and key.
  */
 char *generate_unique_var_name(const char *base_name, ASTNode *node, const char *key) {
+    CodegenState *state = codegen_state();
     char *var_name = safe_malloc(64);
-    snprintf(var_name, 64, "%%%s_%d", base_name, unique_var_counter++);
+    snprintf(var_name, 64, "%%%s_%d", base_name, state->unique_var_counter++);
     add_temp_var(var_name); // Add to temp variable list
 
     if (node != NULL && key != NULL) {
@@ -141,125 +164,42 @@ char *generate_unique_var_name(const char *base_name, ASTNode *node, const char
         new_entry->node = node;
         new_entry->key = string_duplicate(key);
         new_entry->var_name = var_name;
-        new_entry->next = temp_var_map;
-        temp_var_map = new_entry;
+        new_entry->inline_id = state->current_inline_id;
+        new_entry->next = state->temp_var_map;
+        state->temp_var_map = new_entry;
     }
 
     return var_name;
 }
 
 /**
- * Retrieves the temporary variable name associated with a given AST node and key.
+ * Finds the temporary variable mapped to an AST node and key, NULL if there is none.
  */
-char *get_temp_var_name_for_node(ASTNode *node, const char *key) {
-    TempVarMapEntry *entry = temp_var_map;
-    while (entry != NULL) {
-        if (entry->node == node && strcmp(entry->key, key) == 0) {
+static char *find_temp_var_name_for_node(ASTNode *node, const char *key) {
+    for (TempVarMapEntry *entry = codegen_state()->temp_var_map; entry != NULL; entry = entry->next) {
+        if (entry->node == node && entry->inline_id == codegen_state()->current_inline_id && strcmp(entry->key, key) == 0) {
             return entry->var_name;
         }
-        entry = entry->next;
     }
-    error_exit(ERR_INTERNAL, "Error: Temporary variable for node not found.\n");
     return NULL;
 }
 
 /**
- * Collects usage information of built-in functions in the AST.
+ * Retrieves the temporary variable name associated with a given AST node and key.
  */
-void collect_builtin_function_usage(ASTNode *node) {
-    if (!node)
-        return;
-
-    switch (node->type)
-    {
-    case NODE_PROGRAM:
-
-        for (ASTNode *func = node->body; func != NULL; func = func->next)
-        {
-            collect_builtin_function_usage(func);
-        }
-        break;
-
-    case NODE_FUNCTION:
-
-        collect_builtin_function_usage(node->body);
-        break;
-
-    case NODE_BLOCK:
-
-        for (ASTNode *stmt = node->body; stmt != NULL; stmt = stmt->next)
-        {
-            collect_builtin_function_usage(stmt);
-        }
-        break;
-
-    case NODE_FUNCTION_CALL:
-        if (strcmp(node->name, "ifj.substring") == 0)
-        {
-            builtin_function_usage.uses_substring = true;
-        }
-        else if (strcmp(node->name, "ifj.strcmp") == 0)
-        {
-            builtin_function_usage.uses_strcmp = true;
-        }
-        else if (strcmp(node->name, "ifj.string") == 0)
-        {
-            builtin_function_usage.uses_string = true;
-        }
-
-        for (int i = 0; i < node->arg_count; ++i)
-        {
-            collect_builtin_function_usage(node->arguments[i]);
-        }
-        break;
-
-    case NODE_BINARY_OPERATION:
-        collect_builtin_function_usage(node->left);
-        collect_builtin_function_usage(node->right);
-        break;
-
-    case NODE_VARIABLE_DECLARATION:
-    case NODE_ASSIGNMENT:
-        collect_builtin_function_usage(node->left);
-        break;
-
-    case NODE_IF:
-        collect_builtin_function_usage(node->condition);
-        collect_builtin_function_usage(node->body);
-        if (node->left)
-        {
-            collect_builtin_function_usage(node->left);
-        }
-        break;
-
-    case NODE_WHILE:
-        collect_builtin_function_usage(node->condition);
-        collect_builtin_function_usage(node->body);
-        break;
-
-    case NODE_RETURN:
-        if (node->left)
-        {
-            collect_builtin_function_usage(node->left);
-        }
-        break;
-
-    case NODE_LITERAL:
-    case NODE_IDENTIFIER:
-
-        break;
-
-    default:
-        error_exit(ERR_INTERNAL, "Unsupported node type in collect_builtin_function_usage: %d\n", node->type);
-        break;
+char *get_temp_var_name_for_node(ASTNode *node, const char *key) {
+    char *var_name = find_temp_var_name_for_node(node, key);
+    if (var_name == NULL) {
+        error_exit(ERR_INTERNAL, "Error: Temporary variable for node not found.\n");
     }
+    return var_name;
 }
 
 /**
  * Generates the built-in 'substring' function code if used.
  */
 void codegen_generate_substring_function() {
-    fprintf(output_file,
+    fprintf(codegen_state()->output_file,
             "LABEL ifj-substring\n"
             "CREATEFRAME\n"
             "PUSHFRAME\n"
@@ -321,7 +261,7 @@ void codegen_generate_substring_function() {
  * Generates the built-in 'strcmp' function code if used.
  */
 void codegen_generate_strcmp_function() {
-    fprintf(output_file,
+    fprintf(codegen_state()->output_file,
             "LABEL ifj-strcmp\n"
             "CREATEFRAME\n"
             "PUSHFRAME\n"
@@ -378,7 +318,7 @@ void codegen_generate_strcmp_function() {
  * Generates the built-in 'string' function code if used.
  */
 void codegen_generate_ifj_string_function() {
-    fprintf(output_file,
+    fprintf(codegen_state()->output_file,
             "LABEL ifj-string\n"
             "CREATEFRAME\n"
             "PUSHFRAME\n"
@@ -393,28 +333,76 @@ void codegen_generate_ifj_string_function() {
  * Generates code for all used built-in functions.
  */
 void codegen_generate_builtin_functions() {
-    if (builtin_function_usage.uses_substring) {
+    CodegenState *state = codegen_state();
+    if (state->builtin_function_usage.uses_substring) {
         codegen_generate_substring_function();
     }
-    if (builtin_function_usage.uses_strcmp) {
+    if (state->builtin_function_usage.uses_strcmp) {
         codegen_generate_strcmp_function();
     }
-    if (builtin_function_usage.uses_string) {
+    if (state->builtin_function_usage.uses_string) {
         codegen_generate_ifj_string_function();
     }
 }
 
+/**
+ * Returns the occurrence of an expression sharing its value with equivalent ones, or NULL.
+ * Built-in functions called as helper functions leave no temporary to share.
+ */
+static GvnOccurrence *find_gvn_occurrence(ASTNode *node) {
+    if (node->type == NODE_FUNCTION_CALL && strcmp(node->name, "ifj.strcmp") == 0 && !codegen_state()->options.inline_strcmp) {
+        return NULL;
+    }
+    return gvn_find(codegen_state()->gvn_info, node);
+}
+
+/**
+ * Returns the temporary of the value shared by an expression computed earlier, or NULL.
+ */
+static char *find_shared_value(ASTNode *node) {
+    GvnOccurrence *occurrence = find_gvn_occurrence(node);
+    if (occurrence == NULL || occurrence->is_leader) {
+        return NULL;
+    }
+    return get_temp_var_name_for_node(occurrence->value, "gvn_var");
+}
+
+/**
+ * Generates the result temporary of an expression. Leaders of a shared value
+ * all compute it into the same temporary, read by the later occurrences.
+ */
+static char *generate_result_var_name(const char *base_name, ASTNode *node, const char *key) {
+    CodegenState *state = codegen_state();
+    GvnOccurrence *occurrence = find_gvn_occurrence(node);
+    if (occurrence == NULL || !occurrence->is_leader) {
+        return generate_unique_var_name(base_name, node, key);
+    }
+    char *var_name = find_temp_var_name_for_node(occurrence->value, "gvn_var");
+    if (var_name == NULL) {
+        var_name = generate_unique_var_name("gvn", occurrence->value, "gvn_var");
+    }
+
+    TempVarMapEntry *new_entry = safe_malloc(sizeof(TempVarMapEntry));
+    new_entry->node = node;
+    new_entry->key = string_duplicate(key);
+    new_entry->var_name = string_duplicate(var_name);
+    new_entry->inline_id = state->current_inline_id;
+    new_entry->next = state->temp_var_map;
+    state->temp_var_map = new_entry;
+    return new_entry->var_name;
+}
+
 /**
  * Removes the first prefix and replaces the second dot with a hyphen.
  */
 const char *remove_last_prefix(const char *name) {
-    static char buffer[1024];
+    char *buffer = codegen_state()->variable_name_buffer;
     if (!name) {
         return NULL;
     }
 
     size_t name_len = strlen(name);
-    if (name_len >= sizeof(buffer)) {
+    if (name_len >= sizeof(codegen_state()->variable_name_buffer)) {
         error_exit(ERR_INTERNAL, "Error: Buffer overflow in remove_last_prefix.\n");
     }
 
@@ -438,39 +426,368 @@ const char *remove_last_prefix(const char *name) {
     return buffer;
 }
 
+/**
+ * Returns the frame name of a variable.
+ * Variables of an inlined function get the suffix of its call site.
+ */
+static const char *get_frame_variable_name(const char *name) {
+    CodegenState *state = codegen_state();
+    const char *var_name = remove_last_prefix(name);
+    if (state->current_inline_id == 0 || var_name == NULL) {
+        return var_name;
+    }
+    snprintf(state->frame_name_buffer, sizeof(state->frame_name_buffer), "%s$%d", var_name, state->current_inline_id);
+    return state->frame_name_buffer;
+}
 
-char *escape_ifj24_string(const char *input);
+/**
+ * Resets the list of inlined call sites.
+ */
+static void reset_inline_sites() {
+    CodegenState *state = codegen_state();
+    InlineSite *current = state->inline_sites;
+    while (current) {
+        InlineSite *next = current->next;
+        safe_free(current);
+        current = next;
+    }
+    state->inline_sites = NULL;
+    state->inline_site_counter = 0;
+    state->current_inline_id = 0;
+}
 
-static int label_counter = 0;
+/**
+ * Returns the id of a call site inlined in the current context.
+ * A call inside an inlined body gets a different id for every copy of the body.
+ */
+static int get_inline_site_id(ASTNode *call) {
+    CodegenState *state = codegen_state();
+    for (InlineSite *site = state->inline_sites; site != NULL; site = site->next) {
+        if (site->call == call && site->parent_id == state->current_inline_id) {
+            return site->id;
+        }
+    }
+    InlineSite *site = safe_malloc(sizeof(InlineSite));
+    site->call = call;
+    site->parent_id = state->current_inline_id;
+    site->id = ++state->inline_site_counter;
+    site->next = state->inline_sites;
+    state->inline_sites = site;
+    return site->id;
+}
 
 /**
- * Generates a unique label number.
+ * Computes the size of a function after inlining its callees.
  */
-int generate_unique_label() {
-    return label_counter++;
+static int get_inlined_size(CallGraphNode *node) {
+    CodegenState *state = codegen_state();
+    int index = (int)(node - state->call_graph->nodes);
+    if (state->inline_sizes[index] < 0) {
+        int size = node->size;
+        for (CallEdge *edge = node->edges; edge != NULL; edge = edge->next) {
+            if (!edge->callee->is_recursive && strcmp(edge->callee->function->name, "main") != 0) {
+                size += edge->call_count * get_inlined_size(edge->callee);
+            }
+        }
+        state->inline_sizes[index] = size;
+    }
+    return state->inline_sizes[index];
 }
 
 /**
- * Initializes the code generator with the specified output file.
+ * Returns the function to be inlined at a call site, or NULL for a regular call.
+ * Only non-recursive functions fitting the size budget are inlined.
  */
-void codegen_init(const char *filename) {
-    if (filename) {
-        output_file = fopen(filename, "w");
-        if (!output_file) {
-            error_exit(ERR_INTERNAL, "Error: Cannot open output file %s for writing.\n", filename);
+static ASTNode *get_inlined_function(const char *function_name) {
+    CodegenState *state = codegen_state();
+    if (!state->options.inlining || state->call_graph == NULL || state->inline_threshold <= 0 || strcmp(function_name, "main") == 0) {
+        return NULL;
+    }
+    CallGraphNode *node = callgraph_find(state->call_graph, function_name);
+    if (node == NULL || node->is_recursive || get_inlined_size(node) > state->inline_threshold) {
+        return NULL;
+    }
+    return node->function;
+}
+
+/**
+ * Forgets values of ifj.i2f computed so far. Called at every point where
+ * variables may have changed or control flow may join (statements, conditions).
+ */
+static void reset_i2f_cache() {
+    CodegenState *state = codegen_state();
+    for (int i = 0; i < state->i2f_cache_count; i++) {
+        safe_free(state->i2f_cache_variables[i]);
+    }
+    state->i2f_cache_count = 0;
+}
+
+/**
+ * Returns the temporary holding ifj.i2f of a variable computed earlier in the statement, or NULL.
+ */
+static char *find_i2f_value(const char *var_name) {
+    CodegenState *state = codegen_state();
+    for (int i = 0; i < state->i2f_cache_count; i++) {
+        if (strcmp(state->i2f_cache_variables[i], var_name) == 0) {
+            return state->i2f_cache_values[i];
         }
-    } else {
-        output_file = stdout;
     }
+    return NULL;
+}
+
+/**
+ * Generates a label number unique in the function being generated.
+ */
+int generate_unique_label() {
+    return codegen_state()->label_counter++;
+}
+
+/**
+ * Checks if each function is generated on its own, with -j (any number of threads) or with
+ * the cache of functions. Its temporaries and labels then do not depend on the functions before it,
+ * so the code is the same for every number of threads.
+ */
+bool codegen_separate_functions() {
+    CompilerContext *context = compiler_context_current();
+    return context->function_cache != NULL || context->options.codegen_threads > 0;
+}
+
+/**
+ * Returns the first part of the labels of the function being generated.
+ */
+static const char *label_scope() {
+    return codegen_state()->label_prefix;
+}
+
+/**
+ * Initializes the code generator writing to the given stream.
+ */
+void codegen_init(FILE *output) {
+    codegen_state()->output_file = output;
+}
+
+/**
+ * Returns the file the code is written to.
+ */
+FILE *codegen_get_output() {
+    return codegen_state()->output_file;
 }
 
 /**
- * Finalizes the code generator and closes the output file.
+ * Finalizes the code generator, the output stream stays open for its owner.
  */
 void codegen_finalize() {
-    if (output_file) {
-        fclose(output_file);
-        output_file = NULL;
+    CodegenState *state = codegen_state();
+    fflush(state->output_file);
+    state->output_file = NULL;
+}
+
+/**
+ * Records the helper functions called by the code of a function taken from the cache.
+ */
+static void record_builtin_calls(const char *code) {
+    BuiltinFunctionUsage *usage = &codegen_state()->builtin_function_usage;
+    usage->uses_substring |= strstr(code, "CALL ifj-substring\n") != NULL;
+    usage->uses_strcmp |= strstr(code, "CALL ifj-strcmp\n") != NULL;
+    usage->uses_string |= strstr(code, "CALL ifj-string\n") != NULL;
+}
+
+/**
+ * Generates a function, or copies its code from the cache of functions if neither it
+ * nor the functions it depends on changed. Code generated anew is stored in the cache.
+ */
+static void codegen_generate_cached_function(ASTNode *program_node, ASTNode *function) {
+    CompilerContext *context = compiler_context_current();
+    CodegenState *state = &context->codegen;
+    char key[CACHE_KEY_LENGTH + 1];
+    if (context->function_cache == NULL || !cache_function_key(context, program_node, state->call_graph, function, key)) {
+        codegen_generate_function(function);
+        return;
+    }
+
+    CacheEntry entry;
+    if (cache_lookup_function(context->function_cache, key, &entry)) {
+        fwrite(entry.code, 1, entry.code_length, state->output_file);
+        record_builtin_calls(entry.code);
+        cache_free_entry(&entry);
+        state->function_cache_hits++;
+        return;
+    }
+
+    // Generated into memory first to be stored
+    FILE *output = state->output_file;
+    char *code = NULL;
+    size_t length = 0;
+    state->output_file = open_memstream(&code, &length);
+    if (state->output_file == NULL) {
+        state->output_file = output;
+        codegen_generate_function(function);
+        return;
+    }
+    codegen_generate_function(function);
+    fclose(state->output_file);
+    state->output_file = output;
+    fwrite(code, 1, length, output);
+    cache_store_function(context->function_cache, key, code, length);
+    free(code);
+    state->function_cache_misses++;
+}
+
+/**
+ * Functions of a program generated by several threads, each function into its own buffer
+ */
+typedef struct {
+    CompilerContext *program;   // Context of the program, read by the threads
+    CodegenState codegen;       // State of the code generator when the threads start, copied by each
+    ASTNode *program_node;
+    ASTNode **functions;        // Functions to generate in the order of the source
+    char **code;                // Code of each function
+    size_t *code_lengths;
+    int count;
+    int next;                   // First function not taken by a thread
+    int error_code;             // Code of the first error in a thread, ERR_OK if none
+    BuiltinFunctionUsage builtin_function_usage; // Helper functions called by the code of all threads
+    int function_cache_hits;
+    int function_cache_misses;
+    pthread_mutex_t lock;
+} ParallelCodegen;
+
+/**
+ * Thread generating functions until none is left. It has a context of its own sharing
+ * the read-only AST, call graph and analyses of the program, so its temporaries, labels
+ * and allocations do not depend on the other threads.
+ */
+static void *codegen_worker(void *argument) {
+    ParallelCodegen *work = argument;
+    CompilerContext *context = compiler_context_create();
+    if (context == NULL) {
+        pthread_mutex_lock(&work->lock);
+        work->error_code = work->error_code != ERR_OK ? work->error_code : ERR_INTERNAL;
+        pthread_mutex_unlock(&work->lock);
+        return NULL;
+    }
+    CompilerContext *program = work->program;
+    context->options = program->options;
+    context->diagnostics = program->diagnostics;
+    context->parser = program->parser;
+    context->passes = program->passes;
+    context->codegen = work->codegen;
+    context->function_cache = program->function_cache;
+    memset(&context->codegen.builtin_function_usage, 0, sizeof(BuiltinFunctionUsage));
+    context->codegen.function_cache_hits = 0;
+    context->codegen.function_cache_misses = 0;
+
+    // An error in a function stops all threads, its message is already in the diagnostics
+    FILE *volatile output = NULL;
+    jmp_buf error_jump;
+    if (setjmp(error_jump) != 0) {
+        if (output != NULL) {
+            fclose(output);
+        }
+        pthread_mutex_lock(&work->lock);
+        work->error_code = work->error_code != ERR_OK ? work->error_code : context->error_code;
+        pthread_mutex_unlock(&work->lock);
+        compiler_context_destroy(context);
+        return NULL;
+    }
+    context->error_jump = &error_jump;
+
+    while (true) {
+        pthread_mutex_lock(&work->lock);
+        int index = work->error_code == ERR_OK && work->next < work->count ? work->next++ : -1;
+        pthread_mutex_unlock(&work->lock);
+        if (index < 0) {
+            break;
+        }
+        output = open_memstream(&work->code[index], &work->code_lengths[index]);
+        if (output == NULL) {
+            error_exit(ERR_INTERNAL, "Cannot allocate the code of function %s.", work->functions[index]->name);
+        }
+        context->codegen.output_file = output;
+        codegen_generate_cached_function(work->program_node, work->functions[index]);
+        fclose(output);
+        output = NULL;
+    }
+
+    // Helper functions and cache counters are collected for the program once all threads end
+    pthread_mutex_lock(&work->lock);
+    BuiltinFunctionUsage *usage = &work->builtin_function_usage;
+    usage->uses_substring |= context->codegen.builtin_function_usage.uses_substring;
+    usage->uses_strcmp |= context->codegen.builtin_function_usage.uses_strcmp;
+    usage->uses_string |= context->codegen.builtin_function_usage.uses_string;
+    work->function_cache_hits += context->codegen.function_cache_hits;
+    work->function_cache_misses += context->codegen.function_cache_misses;
+    pthread_mutex_unlock(&work->lock);
+    compiler_context_destroy(context);
+    return NULL;
+}
+
+/**
+ * Generates the functions on several threads and writes their code in the order of the source,
+ * so the output is the same as generated by one thread.
+ */
+static void codegen_generate_parallel(ASTNode *program_node, ASTNode **functions, int count, int thread_count) {
+    CompilerContext *context = compiler_context_current();
+    CodegenState *state = &context->codegen;
+
+    // Sizes of inlined functions are computed once here instead of by every thread
+    for (int i = 0; i < state->call_graph->count; i++) {
+        if (!state->call_graph->nodes[i].is_recursive) {
+            get_inlined_size(&state->call_graph->nodes[i]);
+        }
+    }
+
+    ParallelCodegen work;
+    work.program = context;
+    work.codegen = *state;
+    work.program_node = program_node;
+    work.functions = functions;
+    work.code = safe_malloc(sizeof(char *) * count);
+    work.code_lengths = safe_malloc(sizeof(size_t) * count);
+    for (int i = 0; i < count; i++) {
+        work.code[i] = NULL;
+        work.code_lengths[i] = 0;
+    }
+    work.count = count;
+    work.next = 0;
+    work.error_code = ERR_OK;
+    memset(&work.builtin_function_usage, 0, sizeof(BuiltinFunctionUsage));
+    work.function_cache_hits = 0;
+    work.function_cache_misses = 0;
+    pthread_mutex_init(&work.lock, NULL);
+
+    thread_count = thread_count < count ? thread_count : count;
+    pthread_t *threads = safe_malloc(sizeof(pthread_t) * thread_count);
+    int started = 0;
+    while (started < thread_count && pthread_create(&threads[started], NULL, codegen_worker, &work) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        // No thread could be started, the calling thread generates the functions
+        codegen_worker(&work);
+        compiler_context_set_current(context);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&work.lock);
+    state->builtin_function_usage.uses_substring |= work.builtin_function_usage.uses_substring;
+    state->builtin_function_usage.uses_strcmp |= work.builtin_function_usage.uses_strcmp;
+    state->builtin_function_usage.uses_string |= work.builtin_function_usage.uses_string;
+    state->function_cache_hits += work.function_cache_hits;
+    state->function_cache_misses += work.function_cache_misses;
+
+    for (int i = 0; i < count; i++) {
+        if (work.error_code == ERR_OK) {
+            fwrite(work.code[i], 1, work.code_lengths[i], state->output_file);
+        }
+        free(work.code[i]);
+    }
+    safe_free(work.code);
+    safe_free(work.code_lengths);
+    safe_free(threads);
+    if (work.error_code != ERR_OK) {
+        error_return(work.error_code);
     }
 }
 
@@ -478,26 +795,57 @@ void codegen_finalize() {
  * Generates code for the entire program.
  */
 void codegen_generate_program(ASTNode *program_node) {
+    CodegenState *state = codegen_state();
     if (!program_node || program_node->type != NODE_PROGRAM) {
         return;
     }
 
-    collect_builtin_function_usage(program_node);
+    // Functions never transitively called from main are not generated
+    state->call_graph = callgraph_build(program_node);
+    state->range_info = state->options.range_checks ? range_analyze(program_node) : NULL;
+    state->nullness_info = state->options.null_checks ? nullness_analyze(program_node) : NULL;
+    state->gvn_info = state->options.value_numbering ? gvn_analyze(program_node) : NULL;
+    if (state->call_graph->count > 0) {
+        state->inline_sizes = safe_malloc(sizeof(int) * state->call_graph->count);
+        for (int i = 0; i < state->call_graph->count; i++) {
+            state->inline_sizes[i] = -1;
+        }
+    }
 
-    fprintf(output_file, ".IFJcode24\n");
+    fprintf(state->output_file, ".IFJcode24\n");
 
-    fprintf(output_file, "CALL main\n");
-    fprintf(output_file, "EXIT int@0\n");
+    fprintf(state->output_file, "CALL main\n");
+    fprintf(state->output_file, "EXIT int@0\n");
 
+    ASTNode **functions = safe_malloc(sizeof(ASTNode *) * (state->call_graph->count + 1));
+    int count = 0;
     ASTNode *current_function = program_node->body;
-
     while (current_function) {
-        if (current_function->type == NODE_FUNCTION) {
-            codegen_generate_function(current_function);
+        // Every call of an inlined function is replaced by its body
+        if (current_function->type == NODE_FUNCTION &&
+            (!state->options.reachable_only || callgraph_is_reachable(state->call_graph, current_function->name)) &&
+            get_inlined_function(current_function->name) == NULL) {
+            functions[count++] = current_function;
         }
         current_function = current_function->next;
     }
 
+    // Functions do not share temporaries or labels, so they can be generated in any order
+    int thread_count = compiler_context_current()->options.codegen_threads;
+    if (thread_count > 1 && count > 1) {
+        codegen_generate_parallel(program_node, functions, count, thread_count);
+    } else {
+        for (int i = 0; i < count; i++) {
+            codegen_generate_cached_function(program_node, functions[i]);
+        }
+    }
+    safe_free(functions);
+    if (compiler_context_current()->function_cache != NULL) {
+        cache_count_functions(compiler_context_current()->function_cache, state->function_cache_hits,
+                              state->function_cache_misses);
+    }
+
+    // Built-in functions not expanded inline are called as helper functions
     codegen_generate_builtin_functions();
 }
 
@@ -513,39 +861,83 @@ bool is_function_parameter(ASTNode *function, const char *var_name) {
     return false;
 }
 
+/**
+ * Checks if a return statement is a self-call in tail position (return f(...)).
+ */
+static bool is_tail_self_call(ASTNode *return_node) {
+    CodegenState *state = codegen_state();
+    ASTNode *value = return_node->left;
+    return state->options.tail_calls && state->current_function_node != NULL && state->current_inline_id == 0 && value != NULL &&
+           value->type == NODE_FUNCTION_CALL && strcmp(value->name, state->current_function_node->name) == 0;
+}
+
+/**
+ * Checks if a list of statements contains a tail self-call.
+ */
+static bool contains_tail_self_call(ASTNode *statement) {
+    for (; statement != NULL; statement = statement->next) {
+        if (statement->type == NODE_RETURN && is_tail_self_call(statement)) {
+            return true;
+        }
+        if ((statement->type == NODE_IF || statement->type == NODE_WHILE) &&
+            contains_tail_self_call(statement->body->body)) {
+            return true;
+        }
+        if (statement->type == NODE_IF && statement->left != NULL && contains_tail_self_call(statement->left->body)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Generates code for a function.
  */
 void codegen_generate_function(ASTNode *function) {
+    CodegenState *state = codegen_state();
     reset_temp_var_map();
     reset_declared_variables();
     reset_temp_vars(); // Reset temporary variables
+    reset_inline_sites();
+    reset_hoisted_expressions();
+
+    // Temporaries live in the frame of the function and labels start with its name,
+    // so the code of a function generated on its own does not depend on the functions before it.
+    // Function names contain no '-', so labels of different functions never clash.
+    state->label_prefix[0] = '\0';
+    if (codegen_separate_functions()) {
+        state->unique_var_counter = 0;
+        state->temp_var_counter = 0;
+        state->label_counter = 0;
+        state->if_label_count = 0;
+        snprintf(state->label_prefix, sizeof(state->label_prefix), "%s-", function->name);
+    }
 
-    fprintf(output_file, "LABEL %s\n", function->name);
-    fprintf(output_file, "CREATEFRAME\n");
-    fprintf(output_file, "PUSHFRAME\n");
+    fprintf(state->output_file, "LABEL %s\n", function->name);
+    fprintf(state->output_file, "CREATEFRAME\n");
+    fprintf(state->output_file, "PUSHFRAME\n");
 
     // Declare function parameters
     for (int i = 0; i < function->param_count; i++) {
         const char *param_name = remove_last_prefix(function->parameters[i]->name);
-        fprintf(output_file, "DEFVAR LF@%s\n", param_name);
-        fprintf(output_file, "POPS LF@%s\n", param_name);
+        fprintf(state->output_file, "DEFVAR LF@%s\n", param_name);
+        fprintf(state->output_file, "POPS LF@%s\n", param_name);
         add_declared_variable(param_name);
     }
 
     // Declare standard temporary variables
-    fprintf(output_file, "DEFVAR LF@%%tmp_type\n");
+    fprintf(state->output_file, "DEFVAR LF@%%tmp_type\n");
     add_declared_variable("%%tmp_type");
-    fprintf(output_file, "DEFVAR LF@%%tmp_var\n");
+    fprintf(state->output_file, "DEFVAR LF@%%tmp_var\n");
     add_declared_variable("%%tmp_var");
-    fprintf(output_file, "DEFVAR LF@%%tmp_bool\n");
+    fprintf(state->output_file, "DEFVAR LF@%%tmp_bool\n");
     add_declared_variable("%%tmp_bool");
 
     // First Pass: Collect variables (including temporary ones)
     collect_variables_in_block(function->body);
 
     // Declare all variables collected (excluding parameters and standard temporary variables)
-    DeclaredVar *current_declared_var = declared_vars;
+    DeclaredVar *current_declared_var = state->declared_vars;
     while (current_declared_var) {
         const char *var_name = current_declared_var->var_name;
         // Skip parameters and standard temporary variables
@@ -553,24 +945,370 @@ void codegen_generate_function(ASTNode *function) {
             strcmp(var_name, "%%tmp_var") != 0 &&
             strcmp(var_name, "%%tmp_bool") != 0 &&
             !is_function_parameter(function, var_name)) {
-            fprintf(output_file, "DEFVAR LF@%s\n", var_name);
+            fprintf(state->output_file, "DEFVAR LF@%s\n", var_name);
+        }
+        current_declared_var = current_declared_var->next;
+    }
+
+    // Declare all temporary variables collected
+    TempVar *current_temp_var = state->temp_vars;
+    while (current_temp_var) {
+        const char *var_name = current_temp_var->name;
+        fprintf(state->output_file, "DEFVAR LF@%s\n", var_name);
+        current_temp_var = current_temp_var->next;
+    }
+
+    // Tail self-calls jump here after reassigning the parameters, the frame is reused
+    state->current_function_node = function;
+    if (contains_tail_self_call(function->body->body)) {
+        fprintf(state->output_file, "LABEL $%s_tail\n", function->name);
+    }
+
+    // Second Pass: Generate code
+    codegen_generate_block(state->output_file, function->body, function->name);
+    state->current_function_node = NULL;
+
+    // Implicit return is unreachable if every path already returned
+    if (!state->options.skip_unreachable || !block_terminates(function->body)) {
+        fprintf(state->output_file, "POPFRAME\n");
+        fprintf(state->output_file, "RETURN\n");
+    }
+}
+
+/**
+ * Resets the list of hoisted loop-invariant expressions.
+ */
+static void reset_hoisted_expressions() {
+    CodegenState *state = codegen_state();
+    HoistedExpression *current = state->hoisted_expressions;
+    while (current) {
+        HoistedExpression *next = current->next;
+        safe_free(current);
+        current = next;
+    }
+    state->hoisted_expressions = NULL;
+    state->current_loop_scope = NULL;
+    state->hoisting_expression = NULL;
+}
+
+/**
+ * Records a variable assigned inside the loop being collected.
+ */
+static void record_loop_assignment(LoopScope *scope, const char *var_name) {
+    if (scope == NULL) {
+        return;
+    }
+    for (DeclaredVar *var = scope->assigned; var != NULL; var = var->next) {
+        if (strcmp(var->var_name, var_name) == 0) {
+            return;
+        }
+    }
+    DeclaredVar *new_var = safe_malloc(sizeof(DeclaredVar));
+    new_var->var_name = string_duplicate(var_name);
+    new_var->next = scope->assigned;
+    scope->assigned = new_var;
+}
+
+/**
+ * Checks if a variable is assigned inside a loop.
+ */
+static bool is_assigned_in_loop(LoopScope *scope, const char *var_name) {
+    for (DeclaredVar *var = scope->assigned; var != NULL; var = var->next) {
+        if (strcmp(var->var_name, var_name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if a call is ifj.i2f or ifj.f2i of a literal, which is converted at compile time.
+ * Floats out of the integer range keep the runtime conversion and its error.
+ */
+static bool is_folded_conversion(ASTNode *node) {
+    if (!codegen_state()->options.inline_string || node->type != NODE_FUNCTION_CALL || node->arg_count != 1 ||
+        node->arguments[0]->type != NODE_LITERAL) {
+        return false;
+    }
+    if (strcmp(node->name, "ifj.i2f") == 0) {
+        return true;
+    }
+    if (strcmp(node->name, "ifj.f2i") == 0) {
+        double value = atof(node->arguments[0]->value);
+        return value > -9.2e18 && value < 9.2e18;
+    }
+    return false;
+}
+
+/**
+ * Checks if a built-in function only computes a value from its arguments.
+ */
+static bool is_pure_builtin(const char *function_name) {
+    static const char *pure_builtins[] = {
+        "ifj.length", "ifj.i2f", "ifj.f2i", "ifj.chr", "ifj.ord",
+        "ifj.concat", "ifj.substring", "ifj.strcmp", "ifj.string"};
+    for (size_t i = 0; i < sizeof(pure_builtins) / sizeof(pure_builtins[0]); i++) {
+        if (strcmp(function_name, pure_builtins[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if an expression calls a user function or does input/output.
+ */
+static bool has_side_effects(ASTNode *node) {
+    if (node == NULL) {
+        return false;
+    }
+    if (node->type == NODE_FUNCTION_CALL) {
+        if (!is_pure_builtin(node->name)) {
+            return true;
+        }
+        for (int i = 0; i < node->arg_count; i++) {
+            if (has_side_effects(node->arguments[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return has_side_effects(node->left) || has_side_effects(node->right);
+}
+
+/**
+ * Checks if evaluating an expression can stop the program with a runtime error
+ * (division by a non-constant or zero, f2i and chr of values out of range,
+ * ord without bounds checks).
+ */
+static bool can_fail(ASTNode *node) {
+    if (node == NULL) {
+        return false;
+    }
+    if (node->type == NODE_FUNCTION_CALL) {
+        if (strcmp(node->name, "ifj.f2i") == 0 || strcmp(node->name, "ifj.chr") == 0) {
+            return true;
+        }
+        // Without its checks, ifj.ord is only safe where its index was proven in bounds
+        if (range_is_ord_in_bounds(codegen_state()->range_info, node)) {
+            return true;
+        }
+        for (int i = 0; i < node->arg_count; i++) {
+            if (can_fail(node->arguments[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (node->type == NODE_BINARY_OPERATION && strcmp(node->name, "/") == 0 &&
+        (node->right->type != NODE_LITERAL || atof(node->right->value) == 0.0)) {
+        return true;
+    }
+    return can_fail(node->left) || can_fail(node->right);
+}
+
+/**
+ * Checks if an expression has the same value in every iteration of a loop.
+ */
+static bool is_loop_invariant(ASTNode *node, LoopScope *scope) {
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+        return true;
+
+    case NODE_IDENTIFIER:
+        return !is_assigned_in_loop(scope, get_frame_variable_name(node->name));
+
+    case NODE_BINARY_OPERATION:
+        return is_loop_invariant(node->left, scope) && is_loop_invariant(node->right, scope);
+
+    case NODE_FUNCTION_CALL:
+        if (!is_pure_builtin(node->name)) {
+            return false;
+        }
+        for (int i = 0; i < node->arg_count; i++) {
+            if (!is_loop_invariant(node->arguments[i], scope)) {
+                return false;
+            }
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Returns the preheader temporary of a hoisted expression, or NULL if it is evaluated in place.
+ */
+static char *find_hoisted_expression(ASTNode *node) {
+    CodegenState *state = codegen_state();
+    if (node == state->hoisting_expression) {
+        return NULL;
+    }
+    for (HoistedExpression *hoisted = state->hoisted_expressions; hoisted != NULL; hoisted = hoisted->next) {
+        if (hoisted->expression == node && hoisted->inline_id == state->current_inline_id) {
+            return hoisted->var_name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Drops expressions hoisted to inner loops that are part of an expression hoisted further out.
+ */
+static void remove_hoisted_subexpressions(ASTNode *node) {
+    if (node == NULL) {
+        return;
+    }
+    HoistedExpression **link = &codegen_state()->hoisted_expressions;
+    while (*link != NULL) {
+        HoistedExpression *hoisted = *link;
+        if (hoisted->expression == node && hoisted->inline_id == codegen_state()->current_inline_id) {
+            *link = hoisted->next;
+            safe_free(hoisted);
+        } else {
+            link = &hoisted->next;
+        }
+    }
+    remove_hoisted_subexpressions(node->left);
+    remove_hoisted_subexpressions(node->right);
+    if (node->type == NODE_FUNCTION_CALL) {
+        for (int i = 0; i < node->arg_count; i++) {
+            remove_hoisted_subexpressions(node->arguments[i]);
+        }
+    }
+}
+
+/**
+ * Hoists the largest loop-invariant subexpressions of an expression into the loop preheader.
+ * Expressions that can fail are only hoisted if they are evaluated before the first iteration anyway.
+ */
+static void hoist_invariant_expression(ASTNode *loop, ASTNode *node, bool in_condition, bool allow_failing) {
+    CodegenState *state = codegen_state();
+    if (node == NULL) {
+        return;
+    }
+    // Builtins compiled to a single push are not worth a preheader temporary
+    if (node->type == NODE_FUNCTION_CALL &&
+        (is_folded_conversion(node) || (state->options.inline_string && strcmp(node->name, "ifj.string") == 0 &&
+                                        node->arguments[0]->type == NODE_LITERAL))) {
+        return;
+    }
+    // Read from the temporary of an equivalent expression computed earlier
+    GvnOccurrence *occurrence = find_gvn_occurrence(node);
+    if (occurrence != NULL && !occurrence->is_leader) {
+        return;
+    }
+    if ((node->type == NODE_BINARY_OPERATION || node->type == NODE_FUNCTION_CALL) &&
+        is_loop_invariant(node, state->current_loop_scope) && (allow_failing || !can_fail(node))) {
+        remove_hoisted_subexpressions(node);
+
+        HoistedExpression *hoisted = safe_malloc(sizeof(HoistedExpression));
+        hoisted->loop = loop;
+        hoisted->expression = node;
+        hoisted->inline_id = state->current_inline_id;
+        hoisted->in_condition = in_condition;
+        // A shared value is computed into its own temporary, its readers follow in the loop
+        hoisted->var_name = occurrence != NULL ? get_temp_var_name_for_node(occurrence->value, "gvn_var")
+                                               : generate_unique_var_name("licm", NULL, NULL);
+        hoisted->next = NULL;
+
+        // Keep the source order, the preheader evaluates expressions in it
+        HoistedExpression **link = &state->hoisted_expressions;
+        while (*link != NULL) {
+            link = &(*link)->next;
+        }
+        *link = hoisted;
+        return;
+    }
+
+    if (node->type == NODE_BINARY_OPERATION) {
+        hoist_invariant_expression(loop, node->left, in_condition, allow_failing);
+        hoist_invariant_expression(loop, node->right, in_condition, allow_failing);
+    } else if (node->type == NODE_FUNCTION_CALL) {
+        for (int i = 0; i < node->arg_count; i++) {
+            hoist_invariant_expression(loop, node->arguments[i], in_condition, allow_failing);
         }
-        current_declared_var = current_declared_var->next;
     }
+}
 
-    // Declare all temporary variables collected
-    TempVar *current_temp_var = temp_vars;
-    while (current_temp_var) {
-        const char *var_name = current_temp_var->name;
-        fprintf(output_file, "DEFVAR LF@%s\n", var_name);
-        current_temp_var = current_temp_var->next;
+/**
+ * Hoists loop-invariant operands of an if/while condition.
+ * The comparison itself stays in place as it is lowered to a conditional jump.
+ */
+static void hoist_invariant_condition(ASTNode *loop, ASTNode *condition, bool in_condition, bool allow_failing) {
+    if (condition->type == NODE_BINARY_OPERATION) {
+        hoist_invariant_expression(loop, condition->left, in_condition, allow_failing);
+        hoist_invariant_expression(loop, condition->right, in_condition, allow_failing);
     }
+}
 
-    // Second Pass: Generate code
-    codegen_generate_block(output_file, function->body, function->name);
+/**
+ * Hoists loop-invariant expressions from a list of statements of a loop body.
+ */
+static void hoist_invariant_statements(ASTNode *loop, ASTNode *statement) {
+    for (; statement != NULL; statement = statement->next) {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+        case NODE_RETURN:
+            hoist_invariant_expression(loop, statement->left, false, false);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            hoist_invariant_expression(loop, statement, false, false);
+            break;
+
+        case NODE_IF:
+            hoist_invariant_condition(loop, statement->condition, false, false);
+            hoist_invariant_statements(loop, statement->body->body);
+            if (statement->left != NULL) {
+                hoist_invariant_statements(loop, statement->left->body);
+            }
+            break;
+
+        case NODE_WHILE:
+            hoist_invariant_condition(loop, statement->condition, false, false);
+            hoist_invariant_statements(loop, statement->body->body);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
 
-    fprintf(output_file, "POPFRAME\n");
-    fprintf(output_file, "RETURN\n");
+/**
+ * Collects variables of a while loop and selects its loop-invariant expressions.
+ * Invariance is proven from the variables the collection finds assigned in the loop.
+ */
+static void collect_variables_in_while(ASTNode *while_node) {
+    CodegenState *state = codegen_state();
+    LoopScope scope = {NULL, state->current_loop_scope};
+    state->current_loop_scope = &scope;
+
+    collect_variables_in_condition(while_node->condition);
+    collect_variables_in_block(while_node->body);
+
+    // The condition is evaluated by the loop guard, so it may fail in the preheader too.
+    // Without the guard of a rotated loop there is no place for the preheader.
+    if (state->options.licm && state->options.loop_rotation) {
+        hoist_invariant_condition(while_node, while_node->condition, true, !has_side_effects(while_node->condition));
+        hoist_invariant_statements(while_node, while_node->body->body);
+    }
+
+    // Variables assigned in this loop are assigned in the enclosing loops as well
+    state->current_loop_scope = scope.parent;
+    DeclaredVar *var = scope.assigned;
+    while (var != NULL) {
+        DeclaredVar *next = var->next;
+        record_loop_assignment(state->current_loop_scope, var->var_name);
+        safe_free(var->var_name);
+        safe_free(var);
+        var = next;
+    }
 }
 
 /**
@@ -595,7 +1333,8 @@ void collect_variables_in_statement(ASTNode *node) {
     switch (node->type)
     {
     case NODE_VARIABLE_DECLARATION:
-        add_declared_variable(remove_last_prefix(node->name));
+        add_declared_variable(get_frame_variable_name(node->name));
+        record_loop_assignment(codegen_state()->current_loop_scope, get_frame_variable_name(node->name));
         if (node->left != NULL)
         {
             collect_variables_in_expression(node->left);
@@ -603,7 +1342,8 @@ void collect_variables_in_statement(ASTNode *node) {
         break;
 
     case NODE_ASSIGNMENT:
-        add_declared_variable(remove_last_prefix(node->name));
+        add_declared_variable(get_frame_variable_name(node->name));
+        record_loop_assignment(codegen_state()->current_loop_scope, get_frame_variable_name(node->name));
         collect_variables_in_expression(node->left);
         break;
 
@@ -615,7 +1355,7 @@ void collect_variables_in_statement(ASTNode *node) {
         break;
 
     case NODE_IF:
-        collect_variables_in_expression(node->condition);
+        collect_variables_in_condition(node->condition);
         collect_variables_in_block(node->body);
         if (node->left)
         {
@@ -624,8 +1364,7 @@ void collect_variables_in_statement(ASTNode *node) {
         break;
 
     case NODE_WHILE:
-        collect_variables_in_expression(node->condition);
-        collect_variables_in_block(node->body);
+        collect_variables_in_while(node);
         break;
 
     case NODE_FUNCTION_CALL:
@@ -638,10 +1377,75 @@ void collect_variables_in_statement(ASTNode *node) {
     }
 }
 
+/**
+ * Reads the value of an integer literal, returns false for other nodes.
+ */
+static bool get_int_literal(ASTNode *node, long long *value) {
+    if (node->type != NODE_LITERAL || node->data_type != TYPE_INT) {
+        return false;
+    }
+    *value = strtoll(node->value, NULL, 10);
+    return true;
+}
+
+/**
+ * Checks if two expressions are the same variable.
+ */
+static bool is_same_variable(ASTNode *first, ASTNode *second) {
+    return first->type == NODE_IDENTIFIER && second->type == NODE_IDENTIFIER &&
+           strcmp(first->name, second->name) == 0;
+}
+
+/**
+ * Recognizes the form of an ifj.substring call from its arguments.
+ */
+static SubstringShape get_substring_shape(ASTNode *call) {
+    ASTNode *string_arg = call->arguments[0];
+    ASTNode *start_arg = call->arguments[1];
+    ASTNode *end_arg = call->arguments[2];
+    long long start = 0;
+    long long end = 0;
+    bool constant_start = get_int_literal(start_arg, &start);
+    bool constant_end = get_int_literal(end_arg, &end);
+
+    if ((constant_start && start < 0) || (constant_end && end < 0) ||
+        (constant_start && constant_end && start > end)) {
+        return SUBSTRING_NULL;
+    }
+    if (constant_start && constant_end) {
+        return end == start ? SUBSTRING_EMPTY : end == start + 1 ? SUBSTRING_CHAR : SUBSTRING_RANGE;
+    }
+    if (is_same_variable(start_arg, end_arg)) {
+        return SUBSTRING_EMPTY;
+    }
+    long long step = 0;
+    if (end_arg->type == NODE_BINARY_OPERATION && strcmp(end_arg->name, "+") == 0 &&
+        ((is_same_variable(end_arg->left, start_arg) && get_int_literal(end_arg->right, &step)) ||
+         (is_same_variable(end_arg->right, start_arg) && get_int_literal(end_arg->left, &step))) &&
+        step == 1) {
+        return SUBSTRING_CHAR;
+    }
+    if (constant_start && start == 0 && end_arg->type == NODE_FUNCTION_CALL &&
+        strcmp(end_arg->name, "ifj.length") == 0 && is_same_variable(end_arg->arguments[0], string_arg)) {
+        return SUBSTRING_WHOLE;
+    }
+    return SUBSTRING_RANGE;
+}
+
+/**
+ * Checks if the end argument of an ifj.substring call is evaluated,
+ * the specialized forms derive it from the other arguments.
+ */
+static bool is_substring_end_evaluated(ASTNode *call, SubstringShape shape) {
+    long long end = 0;
+    return (shape == SUBSTRING_NULL || shape == SUBSTRING_RANGE) && !get_int_literal(call->arguments[2], &end);
+}
+
 /**
  * Collects variables used in a function call.
  */
 void collect_variables_in_function_call(ASTNode *node) {
+    CodegenState *state = codegen_state();
     if (node == NULL || node->type != NODE_FUNCTION_CALL) {
         error_exit(ERR_INTERNAL, "Invalid function call node for variable collection\n");
     }
@@ -653,7 +1457,7 @@ void collect_variables_in_function_call(ASTNode *node) {
         // Associate temp_var_name with 'arg' using key "temp_var"
         generate_unique_var_name("temp", arg, "temp_var");
 
-        if (is_nullable(arg->data_type)) {
+        if (is_nullable(arg->data_type) && (arg->type != NODE_IDENTIFIER || !state->options.null_checks)) {
             // Associate temp_type_name with 'arg' using key "temp_type"
             generate_unique_var_name("tmp_type", arg, "temp_type");
         }
@@ -669,7 +1473,7 @@ void collect_variables_in_function_call(ASTNode *node) {
         generate_unique_var_name("tmp_str", node->arguments[0], "tmp_str_var");
 
         // Associate retval_var with 'node' using key "retval_var"
-        generate_unique_var_name("retval", node, "retval_var");
+        generate_result_var_name("retval", node, "retval_var");
     } else if (strcmp(node->name, "ifj.concat") == 0) {
         collect_variables_in_expression(node->arguments[0]);
         collect_variables_in_expression(node->arguments[1]);
@@ -679,7 +1483,9 @@ void collect_variables_in_function_call(ASTNode *node) {
         generate_unique_var_name("tmp_str2", node->arguments[1], "tmp_str2_var");
 
         // Associate retval_var with 'node' using key "retval_var"
-        generate_unique_var_name("retval", node, "retval_var");
+        generate_result_var_name("retval", node, "retval_var");
+    } else if (is_folded_conversion(node)) {
+        // Converted at compile time, no temporaries are needed
     } else if (strcmp(node->name, "ifj.i2f") == 0 ||
                strcmp(node->name, "ifj.f2i") == 0) {
         collect_variables_in_expression(node->arguments[0]);
@@ -688,14 +1494,57 @@ void collect_variables_in_function_call(ASTNode *node) {
         generate_unique_var_name("tmp_var", node->arguments[0], "tmp_var");
 
         // Associate retval_var with 'node' using key "retval_var"
-        generate_unique_var_name("retval", node, "retval_var");
+        generate_result_var_name("retval", node, "retval_var");
+    } else if (strcmp(node->name, "ifj.strcmp") == 0 && state->options.inline_strcmp) {
+        collect_variables_in_expression(node->arguments[0]);
+        collect_variables_in_expression(node->arguments[1]);
+
+        // Associate variables with 'node' using unique keys
+        generate_unique_var_name("str1", node, "str1_var");
+        generate_unique_var_name("str2", node, "str2_var");
+        generate_unique_var_name("tmp_bool", node, "tmp_bool_var");
+        generate_result_var_name("retval", node, "retval_var");
+    } else if (strcmp(node->name, "ifj.substring") == 0 && state->options.inline_substring) {
+        SubstringShape shape = get_substring_shape(node);
+        long long constant = 0;
+        bool evaluate_start = !get_int_literal(node->arguments[1], &constant);
+        bool evaluate_end = is_substring_end_evaluated(node, shape);
+
+        // Must stay in sync with codegen_generate_substring
+        collect_variables_in_expression(node->arguments[0]);
+        generate_unique_var_name("str", node, "str_var");
+        if (evaluate_start) {
+            collect_variables_in_expression(node->arguments[1]);
+        }
+        if (evaluate_start || shape == SUBSTRING_RANGE) {
+            generate_unique_var_name("start", node, "start_var");
+        }
+        if (evaluate_end) {
+            collect_variables_in_expression(node->arguments[2]);
+            generate_unique_var_name("end", node, "end_var");
+        }
+        if (shape != SUBSTRING_NULL) {
+            generate_unique_var_name("length", node, "length_var");
+            generate_unique_var_name("retval", node, "retval_var");
+        }
+        if (shape == SUBSTRING_RANGE || (shape != SUBSTRING_NULL && (evaluate_start || constant != 0))) {
+            generate_unique_var_name("tmp_bool", node, "tmp_bool_var");
+        }
+        if (shape == SUBSTRING_RANGE) {
+            generate_unique_var_name("tmp_char", node, "tmp_char_var");
+            generate_unique_var_name("piece", node, "piece_var");
+            generate_unique_var_name("half", node, "half_var");
+            generate_unique_var_name("tmp_int", node, "tmp_int_var");
+        }
+    } else if (strcmp(node->name, "ifj.string") == 0 && state->options.inline_string) {
+        collect_variables_in_expression(node->arguments[0]);
     } else if (strcmp(node->name, "ifj.substring") == 0 ||
                strcmp(node->name, "ifj.strcmp") == 0 ||
                strcmp(node->name, "ifj.string") == 0) {
         for (int i = 0; i < node->arg_count; ++i) {
             collect_variables_in_expression(node->arguments[i]);
         }
-        // The built-in function handles variables internally
+        // The helper function handles variables internally
     } else if (strcmp(node->name, "ifj.chr") == 0) {
         collect_variables_in_expression(node->arguments[0]);
 
@@ -703,8 +1552,10 @@ void collect_variables_in_function_call(ASTNode *node) {
         generate_unique_var_name("tmp_int", node->arguments[0], "tmp_int_var");
 
         // Associate tmp_temp_var and retval_var with 'node' using unique keys
-        generate_unique_var_name("tmp_temp", node, "tmp_temp_var");
-        generate_unique_var_name("retval", node, "retval_var");
+        if (!range_is_chr_byte(state->range_info, node)) {
+            generate_unique_var_name("tmp_temp", node, "tmp_temp_var");
+        }
+        generate_result_var_name("retval", node, "retval_var");
     } else if (strcmp(node->name, "ifj.ord") == 0) {
         collect_variables_in_expression(node->arguments[0]); // String argument
         collect_variables_in_expression(node->arguments[1]); // Index argument
@@ -712,16 +1563,37 @@ void collect_variables_in_function_call(ASTNode *node) {
         // Associate variables with 'node' using unique keys
         generate_unique_var_name("str", node, "str_var");
         generate_unique_var_name("idx", node, "idx_var");
-        generate_unique_var_name("strlen", node, "strlen_var");
-        generate_unique_var_name("tmp_bool", node, "tmp_bool_var");
+        if (!range_is_ord_in_bounds(state->range_info, node)) {
+            generate_unique_var_name("strlen", node, "strlen_var");
+            generate_unique_var_name("tmp_bool", node, "tmp_bool_var");
+        }
         generate_unique_var_name("retval", node, "retval_var");
     } else {
-        // User-defined function call
-        for (int i = 0; i < node->arg_count; ++i) {
-            collect_variables_in_expression(node->arguments[i]);
+        // User-defined function call. Arguments are generated from the last one, value numbering
+        // needs them collected in the same order, otherwise the temporaries keep their old numbers
+        if (state->options.value_numbering) {
+            for (int i = node->arg_count - 1; i >= 0; i--) {
+                collect_variables_in_expression(node->arguments[i]);
+            }
+        } else {
+            for (int i = 0; i < node->arg_count; ++i) {
+                collect_variables_in_expression(node->arguments[i]);
+            }
+        }
+        ASTNode *function = get_inlined_function(node->name);
+        if (function != NULL) {
+            // Parameters and locals of the callee live in the caller's frame
+            int parent_id = state->current_inline_id;
+            state->current_inline_id = get_inline_site_id(node);
+            for (int i = 0; i < function->param_count; i++) {
+                add_declared_variable(get_frame_variable_name(function->parameters[i]->name));
+            }
+            collect_variables_in_block(function->body);
+            state->current_inline_id = parent_id;
         }
         if (node->left) {
-            add_declared_variable(remove_last_prefix(node->left->name));
+            add_declared_variable(get_frame_variable_name(node->left->name));
+            record_loop_assignment(state->current_loop_scope, get_frame_variable_name(node->left->name));
         }
     }
 }
@@ -730,7 +1602,7 @@ void collect_variables_in_function_call(ASTNode *node) {
  * Collects variables used in an expression.
  */
 void collect_variables_in_expression(ASTNode *node) {
-    if (node == NULL) {
+    if (node == NULL || find_shared_value(node) != NULL) {
         return;
     }
 
@@ -742,7 +1614,7 @@ void collect_variables_in_expression(ASTNode *node) {
 
     case NODE_IDENTIFIER:
         // Ensure variable is declared
-        add_declared_variable(remove_last_prefix(node->name));
+        add_declared_variable(get_frame_variable_name(node->name));
         break;
 
     case NODE_BINARY_OPERATION:
@@ -753,7 +1625,7 @@ void collect_variables_in_expression(ASTNode *node) {
         collect_variables_in_expression(node->right);
         generate_unique_var_name("temp", node->right, "temp_var");
 
-        generate_unique_var_name("result", node, "result_var");
+        generate_result_var_name("result", node, "result_var");
         break;
     }
 
@@ -766,6 +1638,133 @@ void collect_variables_in_expression(ASTNode *node) {
     }
 }
 
+/**
+ * Checks if an operand can be used directly as an instruction symbol
+ * (non-nullable variable or numeric literal), so it needs no evaluation.
+ */
+static bool is_simple_operand(ASTNode *node) {
+    if (node->type == NODE_LITERAL) {
+        return node->data_type == TYPE_INT || node->data_type == TYPE_FLOAT;
+    }
+    if (node->type == NODE_IDENTIFIER) {
+        return (node->data_type == TYPE_INT || node->data_type == TYPE_FLOAT) &&
+               strcmp(node->name, "true") != 0 && strcmp(node->name, "false") != 0 &&
+               strcmp(node->name, "nil") != 0;
+    }
+    return false;
+}
+
+/**
+ * Checks if a condition is a comparison that can be lowered directly
+ * into a conditional jump on its operands.
+ */
+static bool is_fused_comparison(ASTNode *condition) {
+    if (!codegen_state()->options.condition_jumps || condition->type != NODE_BINARY_OPERATION) {
+        return false;
+    }
+    const char *op = condition->name;
+    if (strcmp(op, "<") != 0 && strcmp(op, ">") != 0 && strcmp(op, "<=") != 0 &&
+        strcmp(op, ">=") != 0 && strcmp(op, "==") != 0 && strcmp(op, "!=") != 0) {
+        return false;
+    }
+    // Nullable operands and null literals keep the generic evaluation
+    DataType left_type = condition->left->data_type;
+    DataType right_type = condition->right->data_type;
+    return (left_type == TYPE_INT || left_type == TYPE_FLOAT) &&
+           (right_type == TYPE_INT || right_type == TYPE_FLOAT);
+}
+
+/**
+ * Collects variables used in a condition of if/while statement.
+ * Must stay in sync with codegen_generate_condition_jump.
+ */
+void collect_variables_in_condition(ASTNode *condition) {
+    if (!is_fused_comparison(condition)) {
+        collect_variables_in_expression(condition);
+        return;
+    }
+    if (!is_simple_operand(condition->left) && find_shared_value(condition->left) == NULL) {
+        collect_variables_in_expression(condition->left);
+        generate_unique_var_name("temp", condition->left, "temp_var");
+    }
+    if (!is_simple_operand(condition->right) && find_shared_value(condition->right) == NULL) {
+        collect_variables_in_expression(condition->right);
+        generate_unique_var_name("temp", condition->right, "temp_var");
+    }
+}
+
+/**
+ * Returns the instruction symbol holding the value of a comparison operand.
+ * Complex operands are evaluated into their temporary variable first.
+ */
+static char *codegen_comparison_operand(FILE *output, ASTNode *node, const char *current_function) {
+    char *symbol = safe_malloc(1024);
+    if (node->type == NODE_LITERAL && node->data_type == TYPE_INT) {
+        snprintf(symbol, 1024, "int@%s", node->value);
+    } else if (node->type == NODE_LITERAL) {
+        snprintf(symbol, 1024, "float@%.13a", atof(node->value));
+    } else if (node->type == NODE_IDENTIFIER) {
+        snprintf(symbol, 1024, "LF@%s", get_frame_variable_name(node->name));
+    } else if (find_hoisted_expression(node) != NULL) {
+        snprintf(symbol, 1024, "LF@%s", find_hoisted_expression(node));
+    } else if (find_shared_value(node) != NULL) {
+        snprintf(symbol, 1024, "LF@%s", find_shared_value(node));
+    } else {
+        codegen_generate_expression(output, node, current_function);
+        char *temp_var = get_temp_var_name_for_node(node, "temp_var");
+        fprintf(output, "POPS LF@%s\n", temp_var);
+        snprintf(symbol, 1024, "LF@%s", temp_var);
+    }
+    return symbol;
+}
+
+/**
+ * Generates a jump to label taken when the condition evaluates to jump_when.
+ * Comparisons jump directly on their operands, negated operators (<=, >=, !=)
+ * are folded into the polarity of the jump instead of emitting NOT.
+ */
+void codegen_generate_condition_jump(FILE *output, ASTNode *condition, const char *label, bool jump_when) {
+    reset_i2f_cache();
+    if (condition->type == NODE_IDENTIFIER && is_nullable(condition->data_type)) {
+        // Condition with |id| is true when the value is not null
+        Nullness state = nullness_of(codegen_state()->nullness_info, condition);
+        if (state != NULLNESS_UNKNOWN) {
+            if ((state == NULLNESS_NON_NULL) == jump_when) {
+                fprintf(output, "JUMP %s\n", label);
+            }
+            return;
+        }
+        fprintf(output, "TYPE LF@%%tmp_type LF@%s\n", get_frame_variable_name(condition->name));
+        fprintf(output, "%s %s LF@%%tmp_type string@nil\n", jump_when ? "JUMPIFNEQ" : "JUMPIFEQ", label);
+        return;
+    }
+
+    if (!is_fused_comparison(condition)) {
+        codegen_generate_expression(output, condition, NULL);
+        fprintf(output, "PUSHS bool@%s\n", jump_when ? "true" : "false");
+        fprintf(output, "JUMPIFEQS %s\n", label);
+        return;
+    }
+
+    char *left = codegen_comparison_operand(output, condition->left, NULL);
+    char *right = codegen_comparison_operand(output, condition->right, NULL);
+    const char *op = condition->name;
+
+    if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0) {
+        bool jump_if_equal = (strcmp(op, "==") == 0) == jump_when;
+        fprintf(output, "%s %s %s %s\n", jump_if_equal ? "JUMPIFEQ" : "JUMPIFNEQ", label, left, right);
+    } else {
+        // a <= b is not (a > b), a >= b is not (a < b)
+        bool is_negated = strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0;
+        const char *instruction = (strcmp(op, "<") == 0 || strcmp(op, ">=") == 0) ? "LT" : "GT";
+        fprintf(output, "%s LF@%%tmp_bool %s %s\n", instruction, left, right);
+        fprintf(output, "JUMPIFEQ %s LF@%%tmp_bool bool@%s\n", label, (jump_when != is_negated) ? "true" : "false");
+    }
+
+    safe_free(left);
+    safe_free(right);
+}
+
 /**
  * Generates code for a block of statements.
  */
@@ -781,10 +1780,25 @@ void codegen_generate_block(FILE *output, ASTNode *block_node, const char *curre
  * Generates code for an expression.
  */
 void codegen_generate_expression(FILE *output, ASTNode *node, const char *current_function) {
+    CodegenState *state = codegen_state();
     if (node == NULL) {
         return;
     }
 
+    // Loop-invariant value computed in the loop preheader
+    char *hoisted_var = find_hoisted_expression(node);
+    if (hoisted_var != NULL) {
+        fprintf(output, "PUSHS LF@%s\n", hoisted_var);
+        return;
+    }
+
+    // Value computed earlier by an equivalent expression
+    char *shared_var = find_shared_value(node);
+    if (shared_var != NULL) {
+        fprintf(output, "PUSHS LF@%s\n", shared_var);
+        return;
+    }
+
     switch (node->type)
     {
     case NODE_LITERAL:
@@ -821,9 +1835,15 @@ void codegen_generate_expression(FILE *output, ASTNode *node, const char *curren
             fprintf(output, "EQS\n");
             fprintf(output, "NOTS\n");
         }
+        else if (is_nullable(node->data_type) && state->hoisting_expression == NULL &&
+                 nullness_of(state->nullness_info, node) != NULLNESS_UNKNOWN)
+        {
+            // The variable is known to be null or not null here
+            fprintf(output, "PUSHS bool@%s\n", nullness_of(state->nullness_info, node) == NULLNESS_NON_NULL ? "true" : "false");
+        }
         else if (is_nullable(node->data_type))
         {
-            fprintf(output, "TYPE LF@%%tmp_type LF@%s\n", remove_last_prefix(node->name));
+            fprintf(output, "TYPE LF@%%tmp_type LF@%s\n", get_frame_variable_name(node->name));
             fprintf(output, "PUSHS LF@%%tmp_type\n");
             fprintf(output, "PUSHS string@nil\n");
             fprintf(output, "EQS\n");
@@ -839,7 +1859,7 @@ void codegen_generate_expression(FILE *output, ASTNode *node, const char *curren
         }
         else
         {
-            fprintf(output, "PUSHS LF@%s\n", remove_last_prefix(node->name));
+            fprintf(output, "PUSHS LF@%s\n", get_frame_variable_name(node->name));
         }
     }
     break;
@@ -939,10 +1959,200 @@ void codegen_generate_expression(FILE *output, ASTNode *node, const char *curren
     }
 }
 
+/**
+ * Generates the loop copying a general range of ifj.substring into retval.
+ * The bounds are already checked, the result is not empty unless both bounds are variables.
+ * Short results are appended char by char, long ones are built by doubling a buffer
+ * of the first char, which is then overwritten in place, so the copying stays linear.
+ */
+static void codegen_generate_substring_copy(FILE *output, ASTNode *node, const char *start_symbol,
+                                            const char *end_symbol, int label_num) {
+    char *str_var = get_temp_var_name_for_node(node, "str_var");
+    char *start_var = get_temp_var_name_for_node(node, "start_var");
+    char *length_var = get_temp_var_name_for_node(node, "length_var");
+    char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
+    char *retval_var = get_temp_var_name_for_node(node, "retval_var");
+    char *tmp_char_var = get_temp_var_name_for_node(node, "tmp_char_var");
+    char *piece_var = get_temp_var_name_for_node(node, "piece_var");
+    char *half_var = get_temp_var_name_for_node(node, "half_var");
+    char *tmp_int_var = get_temp_var_name_for_node(node, "tmp_int_var");
+    long long start = 0;
+    long long end = 0;
+    bool constant_start = get_int_literal(node->arguments[1], &start);
+    bool constant_bounds = constant_start && get_int_literal(node->arguments[2], &end);
+
+    // The whole string is not copied
+    if (!constant_start || start == 0) {
+        if (!constant_start) {
+            fprintf(output, "JUMPIFNEQ $%ssubstring_copy_%d %s int@0\n", label_scope(), label_num, start_symbol);
+        }
+        fprintf(output, "JUMPIFNEQ $%ssubstring_copy_%d %s LF@%s\n", label_scope(), label_num, end_symbol, length_var);
+        fprintf(output, "MOVE LF@%s LF@%s\n", retval_var, str_var);
+        fprintf(output, "JUMP $%ssubstring_end_%d\n", label_scope(), label_num);
+        fprintf(output, "LABEL $%ssubstring_copy_%d\n", label_scope(), label_num);
+    }
+    fprintf(output, "SUB LF@%s %s %s\n", length_var, end_symbol, start_symbol);
+    fprintf(output, "MOVE LF@%s string@\n", retval_var);
+    if (!constant_bounds) {
+        fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s int@0\n", label_scope(), label_num, length_var);
+    }
+    fprintf(output, "GETCHAR LF@%s LF@%s %s\n", tmp_char_var, str_var, start_symbol);
+    if (constant_start) {
+        fprintf(output, "MOVE LF@%s int@%lld\n", start_var, start + 1);
+    } else {
+        fprintf(output, "ADD LF@%s LF@%s int@1\n", start_var, start_var);
+    }
+
+    bool emit_long = !constant_bounds || end - start >= SUBSTRING_DOUBLING_LENGTH;
+    bool emit_short = !constant_bounds || end - start < SUBSTRING_DOUBLING_LENGTH;
+    if (emit_long && emit_short) {
+        fprintf(output, "LT LF@%s LF@%s int@%d\n", tmp_bool_var, length_var, SUBSTRING_DOUBLING_LENGTH);
+        fprintf(output, "JUMPIFEQ $%ssubstring_short_%d LF@%s bool@true\n", label_scope(), label_num, tmp_bool_var);
+    }
+    if (emit_long) {
+        // Concatenate powers of two copies of the first char, one for each bit of the length
+        fprintf(output, "MOVE LF@%s LF@%s\n", piece_var, tmp_char_var);
+        fprintf(output, "LABEL $%ssubstring_double_%d\n", label_scope(), label_num);
+        fprintf(output, "IDIV LF@%s LF@%s int@2\n", half_var, length_var);
+        fprintf(output, "ADD LF@%s LF@%s LF@%s\n", tmp_int_var, half_var, half_var);
+        fprintf(output, "JUMPIFEQ $%ssubstring_even_%d LF@%s LF@%s\n", label_scope(), label_num, tmp_int_var, length_var);
+        fprintf(output, "CONCAT LF@%s LF@%s LF@%s\n", retval_var, retval_var, piece_var);
+        fprintf(output, "LABEL $%ssubstring_even_%d\n", label_scope(), label_num);
+        fprintf(output, "JUMPIFEQ $%ssubstring_fill_%d LF@%s int@0\n", label_scope(), label_num, half_var);
+        fprintf(output, "CONCAT LF@%s LF@%s LF@%s\n", piece_var, piece_var, piece_var);
+        fprintf(output, "MOVE LF@%s LF@%s\n", length_var, half_var);
+        fprintf(output, "JUMP $%ssubstring_double_%d\n", label_scope(), label_num);
+        fprintf(output, "LABEL $%ssubstring_fill_%d\n", label_scope(), label_num);
+
+        // Overwrite the buffer, a prefix has the same positions in both strings
+        const char *target_var = start_var;
+        if (!constant_start || start != 0) {
+            target_var = half_var;
+            fprintf(output, "MOVE LF@%s int@1\n", half_var);
+        }
+        fprintf(output, "LABEL $%ssubstring_fill_loop_%d\n", label_scope(), label_num);
+        fprintf(output, "GETCHAR LF@%s LF@%s LF@%s\n", tmp_char_var, str_var, start_var);
+        fprintf(output, "SETCHAR LF@%s LF@%s LF@%s\n", retval_var, target_var, tmp_char_var);
+        fprintf(output, "ADD LF@%s LF@%s int@1\n", start_var, start_var);
+        if (target_var != start_var) {
+            fprintf(output, "ADD LF@%s LF@%s int@1\n", target_var, target_var);
+        }
+        fprintf(output, "JUMPIFNEQ $%ssubstring_fill_loop_%d LF@%s %s\n", label_scope(), label_num, start_var, end_symbol);
+        if (emit_short) {
+            fprintf(output, "JUMP $%ssubstring_end_%d\n", label_scope(), label_num);
+        }
+    }
+    if (emit_short) {
+        fprintf(output, "LABEL $%ssubstring_short_%d\n", label_scope(), label_num);
+        fprintf(output, "MOVE LF@%s LF@%s\n", retval_var, tmp_char_var);
+        if (!constant_bounds) {
+            fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s %s\n", label_scope(), label_num, start_var, end_symbol);
+        }
+        fprintf(output, "LABEL $%ssubstring_short_loop_%d\n", label_scope(), label_num);
+        fprintf(output, "GETCHAR LF@%s LF@%s LF@%s\n", tmp_char_var, str_var, start_var);
+        fprintf(output, "CONCAT LF@%s LF@%s LF@%s\n", retval_var, retval_var, tmp_char_var);
+        fprintf(output, "ADD LF@%s LF@%s int@1\n", start_var, start_var);
+        fprintf(output, "JUMPIFNEQ $%ssubstring_short_loop_%d LF@%s %s\n", label_scope(), label_num, start_var, end_symbol);
+    }
+}
+
+/**
+ * Generates ifj.substring inline. Bounds given by literals or derived from the other
+ * arguments are not evaluated, empty, single char and whole string results need no loop.
+ */
+static void codegen_generate_substring(FILE *output, ASTNode *node, const char *current_function) {
+    SubstringShape shape = get_substring_shape(node);
+    long long start = 0;
+    long long end = 0;
+    bool constant_start = get_int_literal(node->arguments[1], &start);
+    bool constant_end = get_int_literal(node->arguments[2], &end);
+    bool evaluate_end = is_substring_end_evaluated(node, shape);
+
+    codegen_generate_expression(output, node->arguments[0], current_function);
+    if (!constant_start) {
+        codegen_generate_expression(output, node->arguments[1], current_function);
+    }
+    if (evaluate_end) {
+        codegen_generate_expression(output, node->arguments[2], current_function);
+        fprintf(output, "POPS LF@%s\n", get_temp_var_name_for_node(node, "end_var"));
+    }
+    if (!constant_start) {
+        fprintf(output, "POPS LF@%s\n", get_temp_var_name_for_node(node, "start_var"));
+    }
+    char *str_var = get_temp_var_name_for_node(node, "str_var");
+    fprintf(output, "POPS LF@%s\n", str_var);
+    if (shape == SUBSTRING_NULL) {
+        fprintf(output, "PUSHS nil@nil\n");
+        return;
+    }
+
+    char start_symbol[96];
+    char end_symbol[96];
+    if (constant_start) {
+        snprintf(start_symbol, sizeof(start_symbol), "int@%lld", start);
+    } else {
+        snprintf(start_symbol, sizeof(start_symbol), "LF@%s", get_temp_var_name_for_node(node, "start_var"));
+    }
+    if (constant_end) {
+        snprintf(end_symbol, sizeof(end_symbol), "int@%lld", end);
+    } else if (evaluate_end) {
+        snprintf(end_symbol, sizeof(end_symbol), "LF@%s", get_temp_var_name_for_node(node, "end_var"));
+    }
+    char *length_var = get_temp_var_name_for_node(node, "length_var");
+    char *retval_var = get_temp_var_name_for_node(node, "retval_var");
+    int label_num = generate_unique_label();
+
+    // Out of range bounds give null: start < 0, start > end, start >= length, end > length
+    fprintf(output, "STRLEN LF@%s LF@%s\n", length_var, str_var);
+    fprintf(output, "MOVE LF@%s nil@nil\n", retval_var);
+    if (constant_start && start == 0) {
+        fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s int@0\n", label_scope(), label_num, length_var);
+    } else {
+        char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
+        if (!constant_start) {
+            fprintf(output, "LT LF@%s %s int@0\n", tmp_bool_var, start_symbol);
+            fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s bool@true\n", label_scope(), label_num, tmp_bool_var);
+        }
+        fprintf(output, "LT LF@%s %s LF@%s\n", tmp_bool_var, start_symbol, length_var);
+        fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s bool@false\n", label_scope(), label_num, tmp_bool_var);
+    }
+    if (shape == SUBSTRING_RANGE) {
+        char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
+        if (!constant_start || !constant_end) {
+            fprintf(output, "GT LF@%s %s %s\n", tmp_bool_var, start_symbol, end_symbol);
+            fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s bool@true\n", label_scope(), label_num, tmp_bool_var);
+        }
+        fprintf(output, "GT LF@%s %s LF@%s\n", tmp_bool_var, end_symbol, length_var);
+        fprintf(output, "JUMPIFEQ $%ssubstring_end_%d LF@%s bool@true\n", label_scope(), label_num, tmp_bool_var);
+    }
+
+    switch (shape)
+    {
+    case SUBSTRING_EMPTY:
+        fprintf(output, "MOVE LF@%s string@\n", retval_var);
+        break;
+
+    case SUBSTRING_CHAR:
+        fprintf(output, "GETCHAR LF@%s LF@%s %s\n", retval_var, str_var, start_symbol);
+        break;
+
+    case SUBSTRING_WHOLE:
+        fprintf(output, "MOVE LF@%s LF@%s\n", retval_var, str_var);
+        break;
+
+    default:
+        codegen_generate_substring_copy(output, node, start_symbol, end_symbol, label_num);
+        break;
+    }
+    fprintf(output, "LABEL $%ssubstring_end_%d\n", label_scope(), label_num);
+    fprintf(output, "PUSHS LF@%s\n", retval_var);
+}
+
 /**
  * Generates code for a function call.
  */
 void codegen_generate_function_call(FILE *output, ASTNode *node, const char *current_function) {
+    CodegenState *state = codegen_state();
     if (node == NULL || node->type != NODE_FUNCTION_CALL) {
         error_exit(ERR_INTERNAL, "Invalid function call node for code generation\n");
     }
@@ -954,19 +2164,20 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         char *temp_var_name = get_temp_var_name_for_node(arg, "temp_var");
         fprintf(output, "POPS LF@%s\n", temp_var_name);
 
-        if (is_nullable(arg->data_type)) {
+        // A nullable variable is read as whether it is not null, only calls can give null
+        if (is_nullable(arg->data_type) && (arg->type != NODE_IDENTIFIER || !state->options.null_checks)) {
             char *temp_type_name = get_temp_var_name_for_node(arg, "temp_type");
             int label_num = generate_unique_label();
 
             fprintf(output, "TYPE LF@%s LF@%s\n", temp_type_name, temp_var_name);
-            fprintf(output, "JUMPIFEQ $write_null_%d LF@%s string@nil\n", label_num, temp_type_name);
+            fprintf(output, "JUMPIFEQ $%swrite_null_%d LF@%s string@nil\n", label_scope(), label_num, temp_type_name);
 
             fprintf(output, "WRITE LF@%s\n", temp_var_name);
-            fprintf(output, "JUMP $write_end_%d\n", label_num);
+            fprintf(output, "JUMP $%swrite_end_%d\n", label_scope(), label_num);
 
-            fprintf(output, "LABEL $write_null_%d\n", label_num);
+            fprintf(output, "LABEL $%swrite_null_%d\n", label_scope(), label_num);
             fprintf(output, "WRITE string@null\n");
-            fprintf(output, "LABEL $write_end_%d\n", label_num);
+            fprintf(output, "LABEL $%swrite_end_%d\n", label_scope(), label_num);
         } else {
             fprintf(output, "WRITE LF@%s\n", temp_var_name);
         }
@@ -1004,15 +2215,45 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         fprintf(output, "CONCAT LF@%s LF@%s LF@%s\n", retval_var, tmp_str1_var, tmp_str2_var);
         fprintf(output, "PUSHS LF@%s\n", retval_var);
     }
+    else if (is_folded_conversion(node))
+    {
+        double value = atof(node->arguments[0]->value);
+        if (strcmp(node->name, "ifj.i2f") == 0)
+        {
+            fprintf(output, "PUSHS float@%.13a\n", value);
+        }
+        else
+        {
+            fprintf(output, "PUSHS int@%lld\n", (long long)value);
+        }
+    }
     else if (strcmp(node->name, "ifj.i2f") == 0)
     {
-        codegen_generate_expression(output, node->arguments[0], current_function);
-        char *tmp_var = get_temp_var_name_for_node(node->arguments[0], "tmp_var");
+        // A variable cannot change within a statement, its conversion is reused
+        ASTNode *arg = node->arguments[0];
+        bool is_variable = state->options.i2f_reuse && arg->type == NODE_IDENTIFIER && arg->data_type == TYPE_INT;
+        // A leader of a shared value must compute it into its own temporary
+        bool is_leader = find_gvn_occurrence(node) != NULL;
+        char *cached_var = is_variable && !is_leader ? find_i2f_value(get_frame_variable_name(arg->name)) : NULL;
+        if (cached_var != NULL)
+        {
+            fprintf(output, "PUSHS LF@%s\n", cached_var);
+            return;
+        }
+
+        codegen_generate_expression(output, arg, current_function);
+        char *tmp_var = get_temp_var_name_for_node(arg, "tmp_var");
         char *retval_var = get_temp_var_name_for_node(node, "retval_var");
 
         fprintf(output, "POPS LF@%s\n", tmp_var);
         fprintf(output, "INT2FLOAT LF@%s LF@%s\n", retval_var, tmp_var);
         fprintf(output, "PUSHS LF@%s\n", retval_var);
+
+        if (is_variable && state->i2f_cache_count < I2F_CACHE_SIZE)
+        {
+            state->i2f_cache_variables[state->i2f_cache_count] = string_duplicate(get_frame_variable_name(arg->name));
+            state->i2f_cache_values[state->i2f_cache_count++] = retval_var;
+        }
     }
     else if (strcmp(node->name, "ifj.f2i") == 0)
     {
@@ -1024,11 +2265,43 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         fprintf(output, "FLOAT2INT LF@%s LF@%s\n", retval_var, tmp_var);
         fprintf(output, "PUSHS LF@%s\n", retval_var);
     }
+    else if (strcmp(node->name, "ifj.strcmp") == 0 && state->options.inline_strcmp)
+    {
+        codegen_generate_expression(output, node->arguments[0], current_function);
+        codegen_generate_expression(output, node->arguments[1], current_function);
+
+        char *str1_var = get_temp_var_name_for_node(node, "str1_var");
+        char *str2_var = get_temp_var_name_for_node(node, "str2_var");
+        char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
+        char *retval_var = get_temp_var_name_for_node(node, "retval_var");
+        int label_num = generate_unique_label();
+
+        // Strings are compared lexicographically by EQ and LT, no helper call is needed
+        fprintf(output, "POPS LF@%s\n", str2_var);
+        fprintf(output, "POPS LF@%s\n", str1_var);
+        fprintf(output, "MOVE LF@%s int@0\n", retval_var);
+        fprintf(output, "JUMPIFEQ $%sstrcmp_end_%d LF@%s LF@%s\n", label_scope(), label_num, str1_var, str2_var);
+        fprintf(output, "LT LF@%s LF@%s LF@%s\n", tmp_bool_var, str1_var, str2_var);
+        fprintf(output, "MOVE LF@%s int@1\n", retval_var);
+        fprintf(output, "JUMPIFEQ $%sstrcmp_end_%d LF@%s bool@false\n", label_scope(), label_num, tmp_bool_var);
+        fprintf(output, "MOVE LF@%s int@-1\n", retval_var);
+        fprintf(output, "LABEL $%sstrcmp_end_%d\n", label_scope(), label_num);
+        fprintf(output, "PUSHS LF@%s\n", retval_var);
+    }
+    else if (strcmp(node->name, "ifj.substring") == 0 && state->options.inline_substring)
+    {
+        codegen_generate_substring(output, node, current_function);
+    }
+    else if (strcmp(node->name, "ifj.string") == 0 && state->options.inline_string)
+    {
+        // The identity needs no call, the string is left on the stack
+        codegen_generate_expression(output, node->arguments[0], current_function);
+    }
     else if (strcmp(node->name, "ifj.substring") == 0 ||
              strcmp(node->name, "ifj.strcmp") == 0 ||
              strcmp(node->name, "ifj.string") == 0)
     {
-        // Handle substring, strcmp, and string functions
+        // Handle substring, strcmp, and string functions by their helper functions
         for (int i = 0; i < node->arg_count; ++i)
         {
             codegen_generate_expression(output, node->arguments[i], current_function);
@@ -1036,24 +2309,34 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         if (strcmp(node->name, "ifj.string") == 0)
         {
             fprintf(output, "CALL ifj-string\n");
+            state->builtin_function_usage.uses_string = true;
         }
         else if (strcmp(node->name, "ifj.strcmp") == 0)
         {
             fprintf(output, "CALL ifj-strcmp\n");
+            state->builtin_function_usage.uses_strcmp = true;
         }
         else
         {
             fprintf(output, "CALL ifj-substring\n");
+            state->builtin_function_usage.uses_substring = true;
         }
     }
     else if (strcmp(node->name, "ifj.chr") == 0)
     {
         codegen_generate_expression(output, node->arguments[0], current_function);
         char *tmp_int_var = get_temp_var_name_for_node(node->arguments[0], "tmp_int_var");
-        char *tmp_temp_var = get_temp_var_name_for_node(node, "tmp_temp_var");
         char *retval_var = get_temp_var_name_for_node(node, "retval_var");
 
         fprintf(output, "POPS LF@%s\n", tmp_int_var);
+        if (range_is_chr_byte(state->range_info, node))
+        {
+            // The argument is proven to be a byte, no modulo needed
+            fprintf(output, "INT2CHAR LF@%s LF@%s\n", retval_var, tmp_int_var);
+            fprintf(output, "PUSHS LF@%s\n", retval_var);
+            return;
+        }
+        char *tmp_temp_var = get_temp_var_name_for_node(node, "tmp_temp_var");
         // Ensure the integer is within valid range (0-255)
         fprintf(output, "IDIV LF@%s LF@%s int@256\n", tmp_temp_var, tmp_int_var);
         fprintf(output, "MUL LF@%s LF@%s int@256\n", tmp_temp_var, tmp_temp_var);
@@ -1069,25 +2352,33 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         // Retrieve variable names using the same keys
         char *str_var = get_temp_var_name_for_node(node, "str_var");
         char *idx_var = get_temp_var_name_for_node(node, "idx_var");
-        char *strlen_var = get_temp_var_name_for_node(node, "strlen_var");
-        char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
         char *retval_var = get_temp_var_name_for_node(node, "retval_var");
 
         fprintf(output, "POPS LF@%s\n", idx_var);
         fprintf(output, "POPS LF@%s\n", str_var);
+        if (range_is_ord_in_bounds(state->range_info, node))
+        {
+            // The index is proven to be in bounds of the string
+            fprintf(output, "STRI2INT LF@%s LF@%s LF@%s\n", retval_var, str_var, idx_var);
+            fprintf(output, "PUSHS LF@%s\n", retval_var);
+            return;
+        }
+        char *strlen_var = get_temp_var_name_for_node(node, "strlen_var");
+        char *tmp_bool_var = get_temp_var_name_for_node(node, "tmp_bool_var");
+
         fprintf(output, "STRLEN LF@%s LF@%s\n", strlen_var, str_var);
         fprintf(output, "LT LF@%s LF@%s int@0\n", tmp_bool_var, idx_var);
-        fprintf(output, "JUMPIFEQ $ord_error_%d LF@%s bool@true\n", label_counter, tmp_bool_var);
+        fprintf(output, "JUMPIFEQ $%sord_error_%d LF@%s bool@true\n", label_scope(), state->label_counter, tmp_bool_var);
         fprintf(output, "SUB LF@%s LF@%s int@1\n", strlen_var, strlen_var);
         fprintf(output, "GT LF@%s LF@%s LF@%s\n", tmp_bool_var, idx_var, strlen_var);
-        fprintf(output, "JUMPIFEQ $ord_error_%d LF@%s bool@true\n", label_counter, tmp_bool_var);
+        fprintf(output, "JUMPIFEQ $%sord_error_%d LF@%s bool@true\n", label_scope(), state->label_counter, tmp_bool_var);
         fprintf(output, "STRI2INT LF@%s LF@%s LF@%s\n", retval_var, str_var, idx_var);
         fprintf(output, "PUSHS LF@%s\n", retval_var);
-        fprintf(output, "JUMP $ord_end_%d\n", label_counter);
-        fprintf(output, "LABEL $ord_error_%d\n", label_counter);
+        fprintf(output, "JUMP $%sord_end_%d\n", label_scope(), state->label_counter);
+        fprintf(output, "LABEL $%sord_error_%d\n", label_scope(), state->label_counter);
         fprintf(output, "PUSHS int@0\n");
-        fprintf(output, "LABEL $ord_end_%d\n", label_counter);
-        label_counter++;
+        fprintf(output, "LABEL $%sord_end_%d\n", label_scope(), state->label_counter);
+        state->label_counter++;
     }
     else
     {
@@ -1097,14 +2388,58 @@ void codegen_generate_function_call(FILE *output, ASTNode *node, const char *cur
         {
             codegen_generate_expression(output, node->arguments[i], current_function);
         }
-        // Call the function
-        fprintf(output, "CALL %s\n", node->name);
+        ASTNode *function = get_inlined_function(node->name);
+        if (function != NULL)
+        {
+            codegen_generate_inlined_body(output, node, function);
+        }
+        else
+        {
+            // Call the function
+            fprintf(output, "CALL %s\n", node->name);
+        }
         // If the function returns a value and it's assigned to a variable
         if (node->left)
         {
-            fprintf(output, "POPS LF@%s\n", remove_last_prefix(node->left->name));
+            fprintf(output, "POPS LF@%s\n", get_frame_variable_name(node->left->name));
+        }
+    }
+}
+
+/**
+ * Generates the body of an inlined function in place of its call.
+ * Arguments are already on the stack, the return value is left there as after CALL.
+ */
+static void codegen_generate_inlined_body(FILE *output, ASTNode *call, ASTNode *function) {
+    CodegenState *state = codegen_state();
+    int parent_id = state->current_inline_id;
+    int parent_end_label = state->inline_end_label;
+    bool parent_end_used = state->inline_end_used;
+    state->current_inline_id = get_inline_site_id(call);
+    reset_i2f_cache();
+    state->inline_end_label = generate_unique_label();
+    state->inline_end_used = false;
+
+    for (int i = 0; i < function->param_count; i++) {
+        fprintf(output, "POPS LF@%s\n", get_frame_variable_name(function->parameters[i]->name));
+    }
+
+    for (ASTNode *statement = function->body->body; statement != NULL; statement = statement->next) {
+        if (statement->next == NULL && statement->type == NODE_RETURN) {
+            // Final return falls through to the code after the call
+            codegen_generate_expression(output, statement->left, function->name);
+        } else {
+            codegen_generate_statement(output, statement, function->name);
         }
     }
+    if (state->inline_end_used) {
+        fprintf(output, "LABEL $%sinline_end_%d\n", label_scope(), state->inline_end_label);
+    }
+
+    reset_i2f_cache();
+    state->current_inline_id = parent_id;
+    state->inline_end_label = parent_end_label;
+    state->inline_end_used = parent_end_used;
 }
 
 /**
@@ -1130,7 +2465,7 @@ void codegen_declare_variables_in_statement(FILE *output, ASTNode *node) {
     {
     case NODE_VARIABLE_DECLARATION:
     {
-        const char *var_name = remove_last_prefix(node->name);
+        const char *var_name = get_frame_variable_name(node->name);
         if (!is_variable_declared(var_name))
         {
             fprintf(output, "DEFVAR LF@%s\n", var_name);
@@ -1188,6 +2523,7 @@ void codegen_generate_statement(FILE *output, ASTNode *node, const char *current
     if (node == NULL) {
         error_exit(ERR_INTERNAL, "Invalid statement node for code generation\n");
     }
+    reset_i2f_cache();
 
     switch (node->type)
     {
@@ -1195,7 +2531,7 @@ void codegen_generate_statement(FILE *output, ASTNode *node, const char *current
         if (node->left != NULL)
         {
             codegen_generate_expression(output, node->left, current_function);
-            const char *var_name = remove_last_prefix(node->name);
+            const char *var_name = get_frame_variable_name(node->name);
             if (var_name == NULL)
             {
                 error_exit(ERR_INTERNAL, "Error: Variable name is NULL in VARIABLE_DECLARATION.\n");
@@ -1206,7 +2542,7 @@ void codegen_generate_statement(FILE *output, ASTNode *node, const char *current
 
     case NODE_ASSIGNMENT:
         codegen_generate_expression(output, node->left, current_function);
-        fprintf(output, "POPS LF@%s\n", remove_last_prefix(node->name));
+        fprintf(output, "POPS LF@%s\n", get_frame_variable_name(node->name));
         break;
 
     case NODE_RETURN:
@@ -1242,7 +2578,7 @@ void codegen_generate_variable_declaration(FILE *output, ASTNode *declaration_no
     if (declaration_node->left)
     {
         codegen_generate_expression(output, declaration_node->left, NULL);
-        fprintf(output, "POPS LF@%s\n", remove_last_prefix(declaration_node->name));
+        fprintf(output, "POPS LF@%s\n", get_frame_variable_name(declaration_node->name));
     }
 }
 
@@ -1251,17 +2587,36 @@ void codegen_generate_variable_declaration(FILE *output, ASTNode *declaration_no
  */
 void codegen_generate_assignment(FILE *output, ASTNode *assignment_node) {
     codegen_generate_expression(output, assignment_node->left, assignment_node->name);
-    fprintf(output, "POPS LF@%s\n", remove_last_prefix(assignment_node->name));
+    fprintf(output, "POPS LF@%s\n", get_frame_variable_name(assignment_node->name));
 }
 
 /**
  * Generates code for a return statement.
  */
 void codegen_generate_return(FILE *output, ASTNode *return_node, const char *current_function) {
+    CodegenState *state = codegen_state();
+    if (is_tail_self_call(return_node)) {
+        // Arguments are all evaluated before the parameters are overwritten
+        ASTNode *call = return_node->left;
+        for (int i = call->arg_count - 1; i >= 0; i--) {
+            codegen_generate_expression(output, call->arguments[i], current_function);
+        }
+        for (int i = 0; i < state->current_function_node->param_count; i++) {
+            fprintf(output, "POPS LF@%s\n", remove_last_prefix(state->current_function_node->parameters[i]->name));
+        }
+        fprintf(output, "JUMP $%s_tail\n", state->current_function_node->name);
+        return;
+    }
     if (return_node->left) {
         codegen_generate_expression(output, return_node->left, current_function);
         // The return value is now on the stack
     }
+    if (state->current_inline_id != 0) {
+        // Return from an inlined body continues after its call
+        fprintf(output, "JUMP $%sinline_end_%d\n", label_scope(), state->inline_end_label);
+        state->inline_end_used = true;
+        return;
+    }
     fprintf(output, "POPFRAME\n");
     fprintf(output, "RETURN\n");
 }
@@ -1270,50 +2625,90 @@ void codegen_generate_return(FILE *output, ASTNode *return_node, const char *cur
  * Generates code for an if statement.
  */
 void codegen_generate_if(FILE *output, ASTNode *if_node) {
-    static int if_label_count = 0;
-
-    int current_label = if_label_count++;
-
-    if (if_node->condition->type == NODE_IDENTIFIER && is_nullable(if_node->condition->data_type))
-    {
-        fprintf(output, "TYPE LF@%%tmp_type LF@%s\n", remove_last_prefix(if_node->condition->name));
-        fprintf(output, "JUMPIFEQ $else_%d LF@%%tmp_type string@nil\n", current_label);
-    }
-    else
-    {
-        codegen_generate_expression(output, if_node->condition, if_node->name);
+    int current_label = codegen_state()->if_label_count++;
 
-        fprintf(output, "PUSHS bool@false\n");
-        fprintf(output, "JUMPIFEQS $else_%d\n", current_label);
-    }
+    char else_label[LABEL_SIZE];
+    snprintf(else_label, sizeof(else_label), "$%selse_%d", label_scope(), current_label);
+    codegen_generate_condition_jump(output, if_node->condition, else_label, false);
 
     codegen_generate_block(output, if_node->body, if_node->name);
-    fprintf(output, "JUMP $endif_%d\n", current_label);
+    if (!codegen_state()->options.skip_unreachable || !block_terminates(if_node->body)) {
+        fprintf(output, "JUMP $%sendif_%d\n", label_scope(), current_label);
+    }
 
-    fprintf(output, "LABEL $else_%d\n", current_label);
+    fprintf(output, "LABEL $%selse_%d\n", label_scope(), current_label);
     if (if_node->left != NULL) {
         codegen_generate_block(output, if_node->left, if_node->name);
     }
 
-    fprintf(output, "LABEL $endif_%d\n", current_label);
+    fprintf(output, "LABEL $%sendif_%d\n", label_scope(), current_label);
+}
+
+/**
+ * Evaluates hoisted loop-invariant expressions of a loop into their temporaries.
+ */
+static void codegen_generate_preheader(FILE *output, ASTNode *while_node, bool in_condition) {
+    CodegenState *state = codegen_state();
+    for (HoistedExpression *hoisted = state->hoisted_expressions; hoisted != NULL; hoisted = hoisted->next) {
+        if (hoisted->loop == while_node && hoisted->inline_id == state->current_inline_id &&
+            hoisted->in_condition == in_condition) {
+            reset_i2f_cache();
+            state->hoisting_expression = hoisted->expression;
+            codegen_generate_expression(output, hoisted->expression, NULL);
+            state->hoisting_expression = NULL;
+            fprintf(output, "POPS LF@%s\n", hoisted->var_name);
+        }
+    }
 }
 
 /**
  * Generates code for a while loop.
+ * The loop is rotated into a guard and a do-while: the condition is tested
+ * once before the loop and then at the bottom, where it jumps back to the body,
+ * so an iteration does not execute an extra unconditional jump.
  */
 void codegen_generate_while(FILE *output, ASTNode *while_node) {
+    CodegenState *state = codegen_state();
     int label_num = generate_unique_label();
-    fprintf(output, "LABEL $while_start_%d\n", label_num);
 
-    codegen_generate_expression(output, while_node->condition, while_node->name);
+    char start_label[LABEL_SIZE];
+    char end_label[LABEL_SIZE];
+    snprintf(start_label, sizeof(start_label), "$%swhile_start_%d", label_scope(), label_num);
+    snprintf(end_label, sizeof(end_label), "$%swhile_end_%d", label_scope(), label_num);
+
+    if (!state->options.loop_rotation) {
+        // The condition is tested at the top of every iteration
+        fprintf(output, "LABEL %s\n", start_label);
+        if (state->options.condition_jumps) {
+            codegen_generate_condition_jump(output, while_node->condition, end_label, false);
+        } else {
+            codegen_generate_expression(output, while_node->condition, while_node->name);
+            fprintf(output, "PUSHS bool@false\n");
+            fprintf(output, "JUMPIFEQS %s\n", end_label);
+        }
+        codegen_generate_block(output, while_node->body, while_node->name);
+        fprintf(output, "JUMP %s\n", start_label);
+        fprintf(output, "LABEL %s\n", end_label);
+        return;
+    }
+
+    // Loop-invariant parts of the condition are evaluated once, before the guard
+    codegen_generate_preheader(output, while_node, true);
 
-    fprintf(output, "PUSHS bool@false\n");
-    fprintf(output, "JUMPIFEQS $while_end_%d\n", label_num);
+    // Guard: skip the loop if the condition does not hold on entry
+    codegen_generate_condition_jump(output, while_node->condition, end_label, false);
+
+    // Preheader: loop-invariant expressions of the body, only if the loop is entered
+    codegen_generate_preheader(output, while_node, false);
+    fprintf(output, "LABEL %s\n", start_label);
 
     codegen_generate_block(output, while_node->body, while_node->name);
 
-    fprintf(output, "JUMP $while_start_%d\n", label_num);
-    fprintf(output, "LABEL $while_end_%d\n", label_num);
+    // Back-edge jumps on the condition directly
+    if (!state->options.skip_unreachable || !block_terminates(while_node->body)) {
+        codegen_generate_condition_jump(output, while_node->condition, start_label, true);
+    }
+    fprintf(output, "LABEL %s\n", end_label);
 }
 
 /**
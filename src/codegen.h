@@ -15,40 +15,163 @@
 #define CODEGEN_H
 
 #include "ast.h"
+#include "callgraph.h"
+#include "gvn.h"
+#include "nullness.h"
+#include "range.h"
 #include <stdio.h>
 
-/** Structure to track usage of built-in functions */
+/** Optimizations done while generating code, switched on and off by the pass manager */
+typedef struct {
+    bool skip_unreachable;  // No jumps and returns after blocks that always return
+    bool reachable_only;    // Generate only functions reachable from main
+    bool condition_jumps;   // Comparisons in conditions jump directly on their operands
+    bool loop_rotation;     // While loops as a guard and a do-while
+    bool inlining;          // Inline small non-recursive functions
+    bool tail_calls;        // Tail self-calls reuse the frame
+    bool licm;              // Hoist loop-invariant expressions (needs loop_rotation)
+    bool inline_string;     // ifj.string and conversions of literals without a call
+    bool inline_strcmp;     // ifj.strcmp by EQ and LT instead of a helper function
+    bool inline_substring;  // ifj.substring expanded inline instead of a helper function
+    bool i2f_reuse;         // Reuse ifj.i2f of a variable within a statement
+    bool range_checks;      // Drop checks of ifj.chr and ifj.ord proven in range
+    bool null_checks;       // Drop null tests of variables with a known state
+    bool value_numbering;   // Reuse values of equivalent pure expressions
+} CodegenOptions;
+
+/** Structure to track usage of built-in functions generated as helper functions */
 typedef struct {
     bool uses_substring;
     bool uses_strcmp;
     bool uses_string;
 } BuiltinFunctionUsage;
 
+/** Default maximal size (in AST nodes) of a function inlined into its callers */
+#define DEFAULT_INLINE_THRESHOLD 60
+
+/** Minimal length of a substring built by doubling a buffer and overwriting it with SETCHAR */
+#define SUBSTRING_DOUBLING_LENGTH 64
+
+/** Size of a label: '$', a function name of at most 255 chars, '-', the kind and the number */
+#define LABEL_SIZE 320
+
+/** Forms of ifj.substring calls expanded inline */
+typedef enum {
+    SUBSTRING_NULL,  // Constant bounds out of range, the result is always null
+    SUBSTRING_EMPTY, // Equal bounds
+    SUBSTRING_CHAR,  // Bounds i and i + 1
+    SUBSTRING_WHOLE, // Bounds 0 and ifj.length of the string itself
+    SUBSTRING_RANGE  // General bounds, the result is copied by a loop
+} SubstringShape;
+
 /** Entry for mapping temporary variables to AST nodes */
 typedef struct TempVarMapEntry {
     ASTNode *node;
     char *key;      // Key identifier
     char *var_name; // Generated variable name
+    int inline_id;  // Inlined call site the node was generated in (0 if none)
     struct TempVarMapEntry *next;
 } TempVarMapEntry;
 
+/** Call site inlined into the current function */
+typedef struct InlineSite {
+    ASTNode *call;
+    int parent_id;  // Inlined call site containing this one (0 if none)
+    int id;         // Suffix of the renamed callee variables
+    struct InlineSite *next;
+} InlineSite;
+
 /** Structure to keep track of declared variables */
 typedef struct DeclaredVar {
     char *var_name;
     struct DeclaredVar *next;
 } DeclaredVar;
 
+/** Variables assigned inside a while loop being collected (innermost loop first) */
+typedef struct LoopScope {
+    DeclaredVar *assigned;
+    struct LoopScope *parent;
+} LoopScope;
+
+/** Loop-invariant expression evaluated once in the preheader of its loop */
+typedef struct HoistedExpression {
+    ASTNode *loop;
+    ASTNode *expression;
+    int inline_id;  // Inlined call site the loop was generated in (0 if none)
+    bool in_condition; // Used by the loop condition, so evaluated before the guard
+    char *var_name; // Preheader temporary holding the value
+    struct HoistedExpression *next;
+} HoistedExpression;
+
 /** Structure to keep track of temporary variables */
 typedef struct TempVar {
     char *name;
     struct TempVar *next;
 } TempVar;
 
+/** Number of ifj.i2f(variable) values reused within a statement */
+#define I2F_CACHE_SIZE 8
+
+/**
+ * State of the code generator in one compilation
+ */
+typedef struct {
+    CodegenOptions options;
+    FILE *output_file;
+    TempVarMapEntry *temp_var_map;
+    int unique_var_counter; // Counters of temporaries and labels restart in every function generated on its own
+    int temp_var_counter;
+    int label_counter;
+    int if_label_count;
+    BuiltinFunctionUsage builtin_function_usage;
+    DeclaredVar *declared_vars;
+    TempVar *temp_vars;
+
+    // Inlining: call graph of the program, inlined call sites of the current function
+    CallGraph *call_graph;
+    int *inline_sizes;
+    int inline_threshold;
+    InlineSite *inline_sites;
+    int inline_site_counter;
+    int current_inline_id;
+    int inline_end_label;
+    bool inline_end_used;
+
+    ASTNode *current_function_node; // Function being generated, target of tail self-calls
+    char label_prefix[LABEL_SIZE];  // Function name and '-' starting its labels, empty unless generated on its own
+
+    // Loop-invariant code motion
+    LoopScope *current_loop_scope;
+    HoistedExpression *hoisted_expressions;
+    ASTNode *hoisting_expression;
+
+    RangeInfo *range_info;       // Calls of ifj.ord and ifj.chr whose arguments are proven in range
+    NullnessInfo *nullness_info; // Reads of nullable variables known to be null or not null
+    GvnInfo *gvn_info;           // Occurrences of pure expressions sharing the value of an equivalent one
+
+    // Functions whose code was taken from the cache of functions and generated anew
+    int function_cache_hits;
+    int function_cache_misses;
+
+    // Values of ifj.i2f(variable) already computed in the current statement
+    char *i2f_cache_variables[I2F_CACHE_SIZE];
+    char *i2f_cache_values[I2F_CACHE_SIZE];
+    int i2f_cache_count;
+
+    char variable_name_buffer[1024]; // Result of remove_last_prefix
+    char frame_name_buffer[1100];    // Result of get_frame_variable_name
+} CodegenState;
+
+// Initializes the state of the code generator of a new compiler context
+void codegen_state_init(CodegenState *state);
+
 /**
  * Functions to initialize and finalize code generation
  */
-void codegen_init(const char *filename);
+void codegen_init(FILE *output);
 void codegen_finalize();
+bool codegen_separate_functions(); // Each function is generated on its own (threads or the cache of functions)
+FILE *codegen_get_output();
 
 /**
  * Functions to generate code for different AST nodes
@@ -64,6 +187,7 @@ void codegen_generate_assignment(FILE *output, ASTNode *assignment_node);
 void codegen_generate_return(FILE *output, ASTNode *return_node, const char *current_function);
 void codegen_generate_if(FILE *output, ASTNode *if_node);
 void codegen_generate_while(FILE *output, ASTNode *while_node);
+void codegen_generate_condition_jump(FILE *output, ASTNode *condition, const char *label, bool jump_when);
 
 /**
  * Functions to generate and declare variables
@@ -75,11 +199,13 @@ void collect_variables_in_statement(ASTNode *node);
 void collect_variables_in_block(ASTNode *node);
 void collect_variables_in_function_call(ASTNode *node);
 void collect_variables_in_expression(ASTNode *node);
+void collect_variables_in_condition(ASTNode *condition);
 
 /**
  * Utility functions
  */
 int generate_unique_label();
+char *escape_ifj24_string(const char *input);
 const char *get_function_name_from_variable(const char *var_name);
 bool is_function_parameter(ASTNode *function, const char *var_name);
 
@@ -0,0 +1,157 @@
+/**
+ * @file compiler.c
+ *
+ * Implementation of the compiler context and of the compilation pipeline.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "compiler.h"
+#include "callgraph.h"
+#include "error.h"
+#include "ir.h"
+#include "lowering.h"
+#include "scanner.h"
+#include <stdlib.h>
+
+/** Initial capacity of the pointer storage of a context */
+#define INITIAL_STORAGE_CAPACITY 64
+
+/** Context of the compilation running in this thread */
+static __thread CompilerContext *current_context = NULL;
+
+/**
+ * Creates a context with the passes of the default optimization level and makes it current
+ */
+CompilerContext *compiler_context_create()
+{
+    CompilerContext *context = calloc(1, sizeof(CompilerContext));
+    if (context == NULL)
+    {
+        return NULL;
+    }
+    if (!init_pointers_storage(&context->storage, INITIAL_STORAGE_CAPACITY))
+    {
+        free(context);
+        return NULL;
+    }
+    current_context = context;
+    context->diagnostics = stderr;
+    parser_state_init(&context->parser);
+    codegen_state_init(&context->codegen);
+    passes_set_level(context, DEFAULT_OPT_LEVEL);
+    return context;
+}
+
+/**
+ * Frees all memory of a context
+ */
+void compiler_context_destroy(CompilerContext *context)
+{
+    if (context == NULL)
+    {
+        return;
+    }
+    cleanup_pointers_storage(&context->storage);
+    if (current_context == context)
+    {
+        current_context = NULL;
+    }
+    free(context);
+}
+
+/**
+ * Makes a context the current one of the calling thread
+ */
+void compiler_context_set_current(CompilerContext *context)
+{
+    current_context = context;
+}
+
+/**
+ * Returns the context of the compilation running in the calling thread
+ */
+CompilerContext *compiler_context_current()
+{
+    return current_context;
+}
+
+/**
+ * Compiles the source into the output stream.
+ * An error_exit during the compilation jumps back here and its code is returned,
+ * the messages are written to the diagnostics of the context.
+ */
+int compiler_compile(CompilerContext *context, FILE *source_file, FILE *output_file)
+{
+    compiler_context_set_current(context);
+
+    jmp_buf error_jump;
+    if (setjmp(error_jump) != 0)
+    {
+        context->error_jump = NULL;
+        return context->error_code;
+    }
+    context->error_jump = &error_jump;
+
+    // Initialize scanner (scanner.c)
+    Scanner scanner;
+    scanner_init(source_file, &scanner);
+
+    // Initialize parser (parser.c)
+    parser_init(&scanner);
+
+    // Parse the source file and generate an abstract syntax tree (AST) (ast.c)
+    double start_time = passes_clock();
+    ASTNode *ast_root = parse_program(&scanner);
+    double frontend_seconds = passes_clock() - start_time;
+
+    // Run the enabled optimization passes on the AST, the semantic checks are already done (passes.c)
+    passes_run_ast(context, ast_root);
+
+    // Dump the call graph with call site counts (callgraph.c)
+    if (context->options.dump_callgraph)
+    {
+        callgraph_dump(callgraph_build(ast_root), context->diagnostics);
+    }
+
+    // Build the SSA form of the functions and run the enabled IR passes on it (ir.c, passes.c)
+    IrProgram *ir_program = NULL;
+    if (context->options.dump_ir || context->options.ir_codegen)
+    {
+        ir_program = ir_build_program(ast_root);
+        passes_run_ir(context, ir_program);
+    }
+    if (context->options.dump_ir)
+    {
+        ir_dump(ir_program, context->diagnostics);
+    }
+
+    // Initialize code generator (codegen.c)
+    start_time = passes_clock();
+    codegen_init(output_file);
+
+    if (context->options.ir_codegen)
+    {
+        // Generate code from the SSA IR (lowering.c)
+        lowering_generate_program(ir_program, codegen_get_output());
+    }
+    else
+    {
+        // Generate code from the AST (codegen.c)
+        codegen_generate_program(ast_root);
+    }
+
+    // Finalize code generation (codegen.c)
+    codegen_finalize();
+
+    if (context->options.time_passes)
+    {
+        passes_print_timing(context, context->diagnostics, frontend_seconds, passes_clock() - start_time);
+    }
+    context->error_jump = NULL;
+    return ERR_OK;
+}
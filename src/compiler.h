@@ -0,0 +1,74 @@
+/**
+ * @file compiler.h
+ *
+ * Header file for the compiler context.
+ * All state of one compilation lives in a CompilerContext, so several
+ * programs can be compiled in one process, one after another or in
+ * different threads. The modules reach the context of the compilation
+ * running in the calling thread through compiler_context_current().
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "codegen.h"
+#include "parser.h"
+#include "passes.h"
+#include "utils.h"
+
+/** Version of the compiler, to be raised with every change of the generated code (keys of cache.c) */
+#define COMPILER_VERSION "2024.51"
+
+struct Cache;
+
+/** Options of a compilation besides the selected passes */
+typedef struct {
+    bool dump_callgraph; // Print the call graph to the diagnostics
+    bool dump_ir;        // Print the SSA IR to the diagnostics
+    bool ir_codegen;     // Generate code from the SSA IR instead of the AST
+    bool time_passes;    // Print the time spent in each pass to the diagnostics
+    int codegen_threads; // Threads generating the functions, 0 (no -j) generates them in the calling thread
+} CompilerOptions;
+
+/**
+ * State of one compilation
+ */
+typedef struct CompilerContext {
+    CompilerOptions options;
+    FILE *diagnostics;              // Error messages and dumps, stderr unless redirected
+    jmp_buf *error_jump;            // Where error_exit returns to while compiling, or NULL to exit
+    int error_code;                 // Code of the error that ended the compilation
+    PointerStorage storage;         // Memory allocated by safe_malloc, freed with the context
+    ParserState parser;
+    PassState passes;
+    CodegenState codegen;
+    int induction_variable_counter; // Names of induction variables derived by the optimizer
+    int lowering_label_counter;     // Labels of the function generated from the SSA form
+    const struct Cache *function_cache; // Code of unchanged functions is taken from it, or NULL
+} CompilerContext;
+
+// Creates a context with the passes of the default optimization level and makes it current, NULL if there is no memory
+CompilerContext *compiler_context_create();
+
+// Frees all memory of a context
+void compiler_context_destroy(CompilerContext *context);
+
+// Makes a context the current one of the calling thread
+void compiler_context_set_current(CompilerContext *context);
+
+// Returns the context of the compilation running in the calling thread, or NULL
+CompilerContext *compiler_context_current();
+
+// Compiles the source into the output stream, returns ERR_OK or the code of the first error
+int compiler_compile(CompilerContext *context, FILE *source_file, FILE *output_file);
+
+#endif // COMPILER_H
@@ -13,17 +13,33 @@
 
 #include "error.h"
 #include "utils.h"
+#include "compiler.h"
 
 /**
  * Print an error message and exit the program with the given error code.
+ * While a compilation runs, it is ended instead and the code is returned by compiler_compile.
  */
 void error_exit(int error_code, const char *format, ...) {
+    CompilerContext *context = compiler_context_current();
+    FILE *diagnostics = context != NULL ? context->diagnostics : stderr;
     va_list args;
     va_start(args, format);
-    fprintf(stderr, "ERROR %i: ", error_code);
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    fprintf(diagnostics, "ERROR %i: ", error_code);
+    vfprintf(diagnostics, format, args);
+    fprintf(diagnostics, "\n");
     va_end(args);
-    cleanup_pointers_storage();
+    error_return(error_code);
+}
+
+/**
+ * Ends the compilation with an error whose message was already written.
+ */
+void error_return(int error_code) {
+    CompilerContext *context = compiler_context_current();
+    if (context != NULL && context->error_jump != NULL) {
+        context->error_code = error_code;
+        longjmp(*context->error_jump, 1);
+    }
+    compiler_context_destroy(context);
     exit(error_code);
 }
@@ -35,5 +35,6 @@
 
 // Functions for error handling
 void error_exit(int error_code, const char *format, ...);
+void error_return(int error_code); // The message was already written
 
 #endif // ERROR_H
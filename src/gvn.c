@@ -0,0 +1,857 @@
+/**
+ * @file gvn.c
+ *
+ * Implementation of the value numbering of pure expressions.
+ * Every variable has a version that changes with each assignment, an expression
+ * is numbered by its operator and the numbers of its operands, so two occurrences
+ * with the same number compute the same value. Values are available in the
+ * statements dominated by their computation: the rest of the block, nested blocks
+ * and, when both branches of an if compute them, the statements after the if.
+ * Variables assigned in a loop get new versions at its entry and exit.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "gvn.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Version of a variable at a point of a function body
+ */
+typedef struct GvnVersion
+{
+    const char *name;
+    int version;
+    struct GvnVersion *next;
+} GvnVersion;
+
+/**
+ * Value computed by one or more leaders, leaders of both branches of an if
+ * computing the same value are merged into one
+ */
+typedef struct GvnValue
+{
+    char *key;
+    ASTNode *leader;
+    struct GvnValue *parent; // Value this one was merged into
+    bool is_read;            // Some occurrence reads the value
+    struct GvnValue *next;
+} GvnValue;
+
+/**
+ * Occurrence found in the function being analyzed
+ */
+typedef struct GvnPending
+{
+    ASTNode *node;
+    GvnValue *value;
+    bool is_leader;
+    struct GvnPending *next;
+} GvnPending;
+
+/**
+ * State of the analysis of one function
+ */
+typedef struct
+{
+    GvnVersion *versions;
+    int version_counter;
+    GvnValue **available; // Values computed on every path to the current statement
+    int available_count;
+    int available_capacity;
+    GvnValue *values;
+    GvnPending *pending;
+} GvnState;
+
+static void analyze_statements(GvnState *state, ASTNode *statement);
+
+/**
+ * Finds the version of a variable, variables not assigned yet have version 0
+ */
+static int get_version(GvnVersion *versions, const char *name)
+{
+    for (; versions != NULL; versions = versions->next)
+    {
+        if (strcmp(versions->name, name) == 0)
+        {
+            return versions->version;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sets the version of a variable
+ */
+static void set_version(GvnVersion **versions, const char *name, int version)
+{
+    for (GvnVersion *current = *versions; current != NULL; current = current->next)
+    {
+        if (strcmp(current->name, name) == 0)
+        {
+            current->version = version;
+            return;
+        }
+    }
+    GvnVersion *current = (GvnVersion *)safe_malloc(sizeof(GvnVersion));
+    current->name = name;
+    current->version = version;
+    current->next = *versions;
+    *versions = current;
+}
+
+/**
+ * Gives a variable a version not used before
+ */
+static void bump_version(GvnState *state, const char *name)
+{
+    set_version(&state->versions, name, ++state->version_counter);
+}
+
+/**
+ * Copies the versions for a branch of the program
+ */
+static GvnVersion *copy_versions(GvnVersion *versions)
+{
+    GvnVersion *copy = NULL;
+    for (; versions != NULL; versions = versions->next)
+    {
+        set_version(&copy, versions->name, versions->version);
+    }
+    return copy;
+}
+
+/**
+ * Frees the versions of a branch
+ */
+static void free_versions(GvnVersion *versions)
+{
+    while (versions != NULL)
+    {
+        GvnVersion *next = versions->next;
+        safe_free(versions);
+        versions = next;
+    }
+}
+
+/**
+ * Versions after either of two branches, a variable with different versions gets a new one
+ */
+static GvnVersion *join_versions(GvnState *state, GvnVersion *a, GvnVersion *b)
+{
+    GvnVersion *joined = copy_versions(a);
+    for (GvnVersion *current = joined; current != NULL; current = current->next)
+    {
+        if (get_version(b, current->name) != current->version)
+        {
+            current->version = ++state->version_counter;
+        }
+    }
+    for (; b != NULL; b = b->next)
+    {
+        if (get_version(joined, b->name) == 0 && b->version != 0)
+        {
+            set_version(&joined, b->name, ++state->version_counter);
+        }
+    }
+    return joined;
+}
+
+/**
+ * Follows merged values to the one standing for all of them
+ */
+static GvnValue *find_value(GvnValue *value)
+{
+    while (value->parent != NULL)
+    {
+        value = value->parent;
+    }
+    return value;
+}
+
+/**
+ * Makes a value available to the following statements
+ */
+static void push_available(GvnState *state, GvnValue *value)
+{
+    if (state->available_count == state->available_capacity)
+    {
+        state->available_capacity = state->available_capacity == 0 ? 16 : state->available_capacity * 2;
+        state->available = (GvnValue **)safe_realloc(state->available, sizeof(GvnValue *) * state->available_capacity);
+    }
+    state->available[state->available_count++] = value;
+}
+
+/**
+ * Finds an available value by its number
+ */
+static GvnValue *find_available(GvnState *state, const char *key)
+{
+    for (int i = state->available_count - 1; i >= 0; i--)
+    {
+        if (strcmp(state->available[i]->key, key) == 0)
+        {
+            return state->available[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Records an occurrence of a value
+ */
+static void add_pending(GvnState *state, ASTNode *node, GvnValue *value, bool is_leader)
+{
+    GvnPending *pending = (GvnPending *)safe_malloc(sizeof(GvnPending));
+    pending->node = node;
+    pending->value = value;
+    pending->is_leader = is_leader;
+    pending->next = state->pending;
+    state->pending = pending;
+}
+
+/**
+ * Checks if a built-in function only computes a value from its arguments
+ */
+static bool is_pure_call(ASTNode *node)
+{
+    static const char *pure_builtins[] = {
+        "ifj.length", "ifj.i2f", "ifj.f2i", "ifj.chr", "ifj.ord",
+        "ifj.concat", "ifj.substring", "ifj.strcmp", "ifj.string"};
+    for (size_t i = 0; i < sizeof(pure_builtins) / sizeof(pure_builtins[0]); i++)
+    {
+        if (strcmp(node->name, pure_builtins[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if an expression leaves its value in a temporary of its own, so other
+ * occurrences can read it. Other pure calls and conversions of literals only get
+ * a number as operands of larger expressions.
+ */
+static bool is_candidate(ASTNode *node)
+{
+    if (node->type == NODE_BINARY_OPERATION)
+    {
+        return strcmp(node->name, "+") == 0 || strcmp(node->name, "-") == 0 ||
+               strcmp(node->name, "*") == 0 || strcmp(node->name, "/") == 0;
+    }
+    if (node->type != NODE_FUNCTION_CALL)
+    {
+        return false;
+    }
+    if (strcmp(node->name, "ifj.i2f") == 0 || strcmp(node->name, "ifj.f2i") == 0)
+    {
+        return node->arguments[0]->type != NODE_LITERAL;
+    }
+    return strcmp(node->name, "ifj.length") == 0 || strcmp(node->name, "ifj.concat") == 0 ||
+           strcmp(node->name, "ifj.strcmp") == 0 || strcmp(node->name, "ifj.chr") == 0;
+}
+
+/**
+ * Appends text to a growing key
+ */
+static void append_key(char **key, size_t *length, const char *text)
+{
+    size_t text_length = strlen(text);
+    *key = (char *)safe_realloc(*key, *length + text_length + 1);
+    memcpy(*key + *length, text, text_length + 1);
+    *length += text_length;
+}
+
+/**
+ * Builds the number of an expression, NULL if it has no number
+ * (nullable values, impure calls, comparisons)
+ */
+static char *get_key(GvnState *state, ASTNode *node)
+{
+    char buffer[64];
+    char *key = NULL;
+    size_t length = 0;
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+        if (node->data_type != TYPE_INT && node->data_type != TYPE_FLOAT && node->data_type != TYPE_U8)
+        {
+            return NULL;
+        }
+        snprintf(buffer, sizeof(buffer), "%d:%zu:", (int)node->data_type, strlen(node->value));
+        append_key(&key, &length, buffer);
+        append_key(&key, &length, node->value);
+        return key;
+
+    case NODE_IDENTIFIER:
+        if (strcmp(node->name, "true") == 0 || strcmp(node->name, "false") == 0)
+        {
+            append_key(&key, &length, node->name);
+            return key;
+        }
+        if (strcmp(node->name, "nil") == 0 || is_nullable(node->data_type) || node->data_type == TYPE_UNKNOWN)
+        {
+            return NULL;
+        }
+        snprintf(buffer, sizeof(buffer), "v%zu:", strlen(node->name));
+        append_key(&key, &length, buffer);
+        append_key(&key, &length, node->name);
+        snprintf(buffer, sizeof(buffer), "#%d", get_version(state->versions, node->name));
+        append_key(&key, &length, buffer);
+        return key;
+
+    case NODE_BINARY_OPERATION:
+    {
+        if (!is_candidate(node))
+        {
+            return NULL;
+        }
+        char *left = get_key(state, node->left);
+        char *right = get_key(state, node->right);
+        if (left == NULL || right == NULL)
+        {
+            if (left != NULL)
+            {
+                safe_free(left);
+            }
+            if (right != NULL)
+            {
+                safe_free(right);
+            }
+            return NULL;
+        }
+        // Addition and multiplication of numbers do not depend on the order of operands
+        bool commutative = strcmp(node->name, "+") == 0 || strcmp(node->name, "*") == 0;
+        if (commutative && strcmp(left, right) > 0)
+        {
+            char *swap = left;
+            left = right;
+            right = swap;
+        }
+        append_key(&key, &length, "(");
+        append_key(&key, &length, node->name);
+        append_key(&key, &length, " ");
+        append_key(&key, &length, left);
+        append_key(&key, &length, " ");
+        append_key(&key, &length, right);
+        append_key(&key, &length, ")");
+        safe_free(left);
+        safe_free(right);
+        return key;
+    }
+
+    case NODE_FUNCTION_CALL:
+        if (!is_pure_call(node))
+        {
+            return NULL;
+        }
+        append_key(&key, &length, node->name);
+        append_key(&key, &length, "(");
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            char *argument = get_key(state, node->arguments[i]);
+            if (argument == NULL)
+            {
+                safe_free(key);
+                return NULL;
+            }
+            append_key(&key, &length, i > 0 ? " " : "");
+            append_key(&key, &length, argument);
+            safe_free(argument);
+        }
+        append_key(&key, &length, ")");
+        return key;
+
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * Numbers the expressions of an expression in the order of evaluation.
+ * Values computed when define is false (arguments that may not be evaluated)
+ * are not made available.
+ */
+static void analyze_expression(GvnState *state, ASTNode *node, bool define)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    char *key = is_candidate(node) ? get_key(state, node) : NULL;
+    if (key != NULL)
+    {
+        GvnValue *value = find_available(state, key);
+        if (value != NULL)
+        {
+            // Computed earlier, its operands are not evaluated at all
+            find_value(value)->is_read = true;
+            add_pending(state, node, value, false);
+            safe_free(key);
+            return;
+        }
+    }
+
+    if (node->type == NODE_BINARY_OPERATION)
+    {
+        analyze_expression(state, node->left, define);
+        analyze_expression(state, node->right, define);
+    }
+    else if (node->type == NODE_FUNCTION_CALL && strcmp(node->name, "ifj.substring") == 0)
+    {
+        // Bounds derived from the other arguments are not evaluated
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            analyze_expression(state, node->arguments[i], i == 0 && define);
+        }
+    }
+    else if (node->type == NODE_FUNCTION_CALL && is_pure_call(node))
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            analyze_expression(state, node->arguments[i], define);
+        }
+    }
+    else if (node->type == NODE_FUNCTION_CALL)
+    {
+        // Arguments of user functions are pushed from the last one
+        for (int i = node->arg_count - 1; i >= 0; i--)
+        {
+            analyze_expression(state, node->arguments[i], define);
+        }
+    }
+
+    if (key == NULL)
+    {
+        return;
+    }
+    if (!define)
+    {
+        safe_free(key);
+        return;
+    }
+    GvnValue *value = (GvnValue *)safe_malloc(sizeof(GvnValue));
+    value->key = key;
+    value->leader = node;
+    value->parent = NULL;
+    value->is_read = false;
+    value->next = state->values;
+    state->values = value;
+    push_available(state, value);
+    add_pending(state, node, value, true);
+}
+
+/**
+ * Gives new versions to the variables assigned in a list of statements
+ */
+static void bump_assigned(GvnState *state, ASTNode *statement)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            bump_version(state, statement->name);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (statement->left != NULL)
+            {
+                bump_version(state, statement->left->name);
+            }
+            break;
+
+        case NODE_IF:
+            bump_assigned(state, statement->body->body);
+            if (statement->left != NULL)
+            {
+                bump_assigned(state, statement->left->body);
+            }
+            break;
+
+        case NODE_WHILE:
+            bump_assigned(state, statement->body->body);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Analyzes one branch of an if, returns the values it made available
+ */
+static GvnValue **analyze_branch(GvnState *state, ASTNode *block, int *count)
+{
+    int mark = state->available_count;
+    if (block != NULL)
+    {
+        analyze_statements(state, block->body);
+    }
+    *count = state->available_count - mark;
+    GvnValue **values = NULL;
+    if (*count > 0)
+    {
+        values = (GvnValue **)safe_malloc(sizeof(GvnValue *) * *count);
+        memcpy(values, state->available + mark, sizeof(GvnValue *) * *count);
+    }
+    state->available_count = mark;
+    return values;
+}
+
+/**
+ * Analyzes an if, values computed by both branches stay available after it
+ */
+static void analyze_if(GvnState *state, ASTNode *statement)
+{
+    analyze_expression(state, statement->condition, true);
+
+    GvnVersion *before = copy_versions(state->versions);
+    int then_count = 0;
+    GvnValue **then_values = analyze_branch(state, statement->body, &then_count);
+    GvnVersion *then_versions = state->versions;
+
+    state->versions = before;
+    int else_count = 0;
+    GvnValue **else_values = analyze_branch(state, statement->left, &else_count);
+    GvnVersion *else_versions = state->versions;
+
+    // A branch that returns does not reach the next statement
+    bool then_returns = block_terminates(statement->body);
+    bool else_returns = statement->left != NULL && block_terminates(statement->left);
+    if (then_returns && !else_returns)
+    {
+        state->versions = else_versions;
+        free_versions(then_versions);
+        for (int i = 0; i < else_count; i++)
+        {
+            push_available(state, else_values[i]);
+        }
+    }
+    else if (else_returns && !then_returns)
+    {
+        state->versions = then_versions;
+        free_versions(else_versions);
+        for (int i = 0; i < then_count; i++)
+        {
+            push_available(state, then_values[i]);
+        }
+    }
+    else
+    {
+        state->versions = join_versions(state, then_versions, else_versions);
+        free_versions(then_versions);
+        free_versions(else_versions);
+        for (int i = 0; i < then_count; i++)
+        {
+            for (int j = 0; j < else_count; j++)
+            {
+                GvnValue *then_value = find_value(then_values[i]);
+                GvnValue *else_value = find_value(else_values[j]);
+                if (then_value != else_value && strcmp(then_value->key, else_value->key) == 0)
+                {
+                    // Both leaders write the same temporary
+                    else_value->parent = then_value;
+                    then_value->is_read = then_value->is_read || else_value->is_read;
+                    push_available(state, then_value);
+                }
+            }
+        }
+    }
+    if (then_values != NULL)
+    {
+        safe_free(then_values);
+    }
+    if (else_values != NULL)
+    {
+        safe_free(else_values);
+    }
+}
+
+/**
+ * Analyzes a while loop, values of the body are only available inside it
+ */
+static void analyze_while(GvnState *state, ASTNode *statement)
+{
+    bump_assigned(state, statement->body->body);
+
+    // The condition is evaluated before every iteration and before leaving the loop
+    analyze_expression(state, statement->condition, true);
+
+    int mark = state->available_count;
+    analyze_statements(state, statement->body->body);
+    state->available_count = mark;
+
+    bump_assigned(state, statement->body->body);
+}
+
+/**
+ * Analyzes a list of statements in order
+ */
+static void analyze_statements(GvnState *state, ASTNode *statement)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            analyze_expression(state, statement->left, true);
+            bump_version(state, statement->name);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            analyze_expression(state, statement, true);
+            if (statement->left != NULL)
+            {
+                bump_version(state, statement->left->name);
+            }
+            break;
+
+        case NODE_RETURN:
+            analyze_expression(state, statement->left, true);
+            break;
+
+        case NODE_IF:
+            analyze_if(state, statement);
+            break;
+
+        case NODE_WHILE:
+            analyze_while(state, statement);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Adds the occurrences of values read somewhere to the result
+ */
+static void add_occurrences(GvnInfo *info, GvnState *state)
+{
+    for (GvnPending *pending = state->pending; pending != NULL; pending = pending->next)
+    {
+        GvnValue *value = find_value(pending->value);
+        if (!value->is_read)
+        {
+            continue;
+        }
+        if (info->count == info->capacity)
+        {
+            info->capacity = info->capacity == 0 ? 16 : info->capacity * 2;
+            info->occurrences = (GvnOccurrence *)safe_realloc(info->occurrences, sizeof(GvnOccurrence) * info->capacity);
+        }
+        info->occurrences[info->count].node = pending->node;
+        info->occurrences[info->count].value = value->leader;
+        info->occurrences[info->count].is_leader = pending->is_leader;
+        info->count++;
+    }
+}
+
+/**
+ * Frees the state of an analyzed function
+ */
+static void free_state(GvnState *state)
+{
+    free_versions(state->versions);
+    while (state->values != NULL)
+    {
+        GvnValue *next = state->values->next;
+        safe_free(state->values->key);
+        safe_free(state->values);
+        state->values = next;
+    }
+    while (state->pending != NULL)
+    {
+        GvnPending *next = state->pending->next;
+        safe_free(state->pending);
+        state->pending = next;
+    }
+    if (state->available != NULL)
+    {
+        safe_free(state->available);
+    }
+}
+
+/**
+ * Numbers the values of pure expressions in all functions of the program
+ */
+GvnInfo *gvn_analyze(ASTNode *program_node)
+{
+    GvnInfo *info = (GvnInfo *)safe_malloc(sizeof(GvnInfo));
+    info->occurrences = NULL;
+    info->count = 0;
+    info->capacity = 0;
+    if (program_node == NULL)
+    {
+        return info;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            GvnState state = {NULL, 0, NULL, 0, 0, NULL, NULL};
+            analyze_statements(&state, function->body->body);
+            add_occurrences(info, &state);
+            free_state(&state);
+        }
+    }
+    return info;
+}
+
+/**
+ * Returns the occurrence of an expression with a shared value, or NULL
+ */
+GvnOccurrence *gvn_find(GvnInfo *info, ASTNode *node)
+{
+    if (info == NULL)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->occurrences[i].node == node)
+        {
+            return &info->occurrences[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Checks if an SSA instruction computes its result from its operands only
+ */
+static bool is_pure_instruction(IrValue *value)
+{
+    switch (value->opcode)
+    {
+    case IR_CONST:
+    case IR_BINARY:
+    case IR_NOT_NULL:
+    case IR_PHI:
+        return true;
+
+    case IR_CALL:
+        return strcmp(value->name, "ifj.length") == 0 || strcmp(value->name, "ifj.i2f") == 0 ||
+               strcmp(value->name, "ifj.f2i") == 0 || strcmp(value->name, "ifj.chr") == 0 ||
+               strcmp(value->name, "ifj.ord") == 0 || strcmp(value->name, "ifj.concat") == 0 ||
+               strcmp(value->name, "ifj.substring") == 0 || strcmp(value->name, "ifj.strcmp") == 0 ||
+               strcmp(value->name, "ifj.string") == 0;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Checks if two pure SSA instructions compute the same value
+ */
+static bool is_same_instruction(IrValue *a, IrValue *b)
+{
+    if (a->opcode != b->opcode || a->type != b->type || a->operand_count != b->operand_count)
+    {
+        return false;
+    }
+    if ((a->name == NULL) != (b->name == NULL) || (a->name != NULL && strcmp(a->name, b->name) != 0))
+    {
+        return false;
+    }
+    // Phis only merge the same values when they join the same predecessors
+    if (a->opcode == IR_PHI && a->block != b->block)
+    {
+        return false;
+    }
+    bool same = true;
+    for (int i = 0; i < a->operand_count && same; i++)
+    {
+        same = a->operands[i] == b->operands[i];
+    }
+    if (!same && a->opcode == IR_BINARY && (strcmp(a->name, "+") == 0 || strcmp(a->name, "*") == 0 ||
+                                            strcmp(a->name, "==") == 0 || strcmp(a->name, "!=") == 0))
+    {
+        same = a->operands[0] == b->operands[1] && a->operands[1] == b->operands[0];
+    }
+    return same;
+}
+
+/**
+ * Numbers the instructions of a block and the blocks it dominates,
+ * the available instructions are those of the dominating blocks
+ */
+static int number_block(IrBlock *block, IrValue ***available, int *count, int *capacity)
+{
+    int mark = *count;
+    int removed = 0;
+    IrValue *next;
+    for (IrValue *value = block->first; value != NULL; value = next)
+    {
+        next = value->next;
+        if (!is_pure_instruction(value))
+        {
+            continue;
+        }
+        IrValue *equivalent = NULL;
+        for (int i = *count - 1; i >= 0 && equivalent == NULL; i--)
+        {
+            if (is_same_instruction((*available)[i], value))
+            {
+                equivalent = (*available)[i];
+            }
+        }
+        if (equivalent != NULL)
+        {
+            ir_replace_uses(value, equivalent);
+            ir_remove_value(value);
+            removed++;
+            continue;
+        }
+        if (*count == *capacity)
+        {
+            *capacity = *capacity == 0 ? 32 : *capacity * 2;
+            *available = (IrValue **)safe_realloc(*available, sizeof(IrValue *) * *capacity);
+        }
+        (*available)[(*count)++] = value;
+    }
+    for (int i = 0; i < block->child_count; i++)
+    {
+        removed += number_block(block->children[i], available, count, capacity);
+    }
+    *count = mark;
+    return removed;
+}
+
+/**
+ * Replaces pure instructions of an SSA function by equivalent dominating ones, returns their count
+ */
+int gvn_optimize_function(IrFunction *function)
+{
+    if (function->block_count == 0)
+    {
+        return 0;
+    }
+    IrValue **available = NULL;
+    int count = 0;
+    int capacity = 0;
+    int removed = number_block(function->blocks[0], &available, &count, &capacity);
+    if (available != NULL)
+    {
+        safe_free(available);
+    }
+    return removed;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file gvn.h
+ *
+ * Header file for the value numbering of pure expressions.
+ * Finds occurrences of arithmetic and pure built-in calls computing a value
+ * already computed on every path reaching them, so the generated code can
+ * read the earlier result instead of evaluating the expression again.
+ * The same numbering is done on the SSA form along the dominator tree.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef GVN_H
+#define GVN_H
+
+#include <stdbool.h>
+#include "ast.h"
+#include "ir.h"
+
+/**
+ * Occurrence of an expression whose value is shared with equivalent occurrences
+ */
+typedef struct {
+    ASTNode *node;
+    ASTNode *value;   // Representative leader naming the shared value
+    bool is_leader;   // Computes the value, otherwise only reads it
+} GvnOccurrence;
+
+/**
+ * Shared values of all functions of the program
+ */
+typedef struct {
+    GvnOccurrence *occurrences;
+    int count;
+    int capacity;
+} GvnInfo;
+
+// Numbers the values of pure expressions in all functions of the program
+GvnInfo *gvn_analyze(ASTNode *program_node);
+
+// Returns the occurrence of an expression with a shared value, or NULL
+GvnOccurrence *gvn_find(GvnInfo *info, ASTNode *node);
+
+// Replaces pure instructions of an SSA function by equivalent dominating ones, returns their count
+int gvn_optimize_function(IrFunction *function);
+
+#endif // GVN_H
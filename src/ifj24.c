@@ -0,0 +1,208 @@
+/**
+ * @file ifj24.c
+ *
+ * Implementation of the libifj24 library interface.
+ * The source is read and the code written through memory streams, each
+ * compilation runs in its own compiler context.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "ifj24.h"
+#include "compiler.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Fills the options the compiler uses without command line options
+ */
+void ifj24_default_options(Ifj24Options *options)
+{
+    options->level = IFJ24_OPT_2;
+    options->enable_passes = NULL;
+    options->disable_passes = NULL;
+    options->inline_threshold = DEFAULT_INLINE_THRESHOLD;
+    options->ir_codegen = false;
+    options->dump_callgraph = false;
+    options->dump_ir = false;
+    options->time_passes = false;
+    options->codegen_threads = 0;
+}
+
+/**
+ * Returns the level of the pass manager for a level of the interface
+ */
+static OptimizationLevel optimization_level(Ifj24OptLevel level)
+{
+    switch (level)
+    {
+    case IFJ24_OPT_0:
+        return OPT_LEVEL_0;
+    case IFJ24_OPT_1:
+        return OPT_LEVEL_1;
+    case IFJ24_OPT_SIZE:
+        return OPT_LEVEL_SIZE;
+    default:
+        return OPT_LEVEL_2;
+    }
+}
+
+/**
+ * Enables or disables the listed passes, returns false at an unknown name
+ */
+static bool set_passes(CompilerContext *context, const char *const *names, bool enabled)
+{
+    for (int i = 0; names != NULL && names[i] != NULL; i++)
+    {
+        if (!passes_set_enabled(context, names[i], enabled))
+        {
+            fprintf(context->diagnostics, "Unknown pass: %s\n", names[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hands the contents of a memory stream to the caller or frees it
+ */
+static void give_buffer(Ifj24Buffer *buffer, char *data, size_t length, bool keep)
+{
+    if (buffer != NULL && keep)
+    {
+        buffer->data = data;
+        buffer->length = length;
+    }
+    else
+    {
+        free(data);
+    }
+}
+
+/**
+ * Compiles source held in memory into code in memory
+ */
+int ifj24_compile(const char *source, size_t length, const Ifj24Options *options,
+                  Ifj24Buffer *output, Ifj24Buffer *diagnostics)
+{
+    Ifj24Options default_options;
+    if (options == NULL)
+    {
+        ifj24_default_options(&default_options);
+        options = &default_options;
+    }
+    if (output != NULL)
+    {
+        output->data = NULL;
+        output->length = 0;
+    }
+    if (diagnostics != NULL)
+    {
+        diagnostics->data = NULL;
+        diagnostics->length = 0;
+    }
+
+    char *code = NULL;
+    size_t code_length = 0;
+    char *messages = NULL;
+    size_t messages_length = 0;
+    FILE *source_stream = fmemopen((void *)source, length, "r");
+    FILE *code_stream = open_memstream(&code, &code_length);
+    FILE *messages_stream = open_memstream(&messages, &messages_length);
+    CompilerContext *previous_context = compiler_context_current();
+    CompilerContext *context = NULL;
+    if (source_stream != NULL && code_stream != NULL && messages_stream != NULL)
+    {
+        context = compiler_context_create();
+    }
+
+    int result = IFJ24_ERR_INTERNAL;
+    if (context != NULL)
+    {
+        context->diagnostics = messages_stream;
+        context->options.ir_codegen = options->ir_codegen;
+        context->options.dump_callgraph = options->dump_callgraph;
+        context->options.dump_ir = options->dump_ir;
+        context->options.time_passes = options->time_passes;
+        context->options.codegen_threads = options->codegen_threads;
+        context->codegen.inline_threshold = options->inline_threshold;
+        passes_set_level(context, optimization_level(options->level));
+        if (set_passes(context, options->enable_passes, true) && set_passes(context, options->disable_passes, false))
+        {
+            result = compiler_compile(context, source_stream, code_stream);
+        }
+        compiler_context_destroy(context);
+    }
+    compiler_context_set_current(previous_context);
+
+    if (source_stream != NULL)
+    {
+        fclose(source_stream);
+    }
+    if (code_stream != NULL)
+    {
+        fclose(code_stream);
+    }
+    if (messages_stream != NULL)
+    {
+        fclose(messages_stream);
+    }
+    give_buffer(output, code, code_length, result == IFJ24_OK);
+    give_buffer(diagnostics, messages, messages_length, messages_length > 0);
+    return result;
+}
+
+/**
+ * Frees a buffer filled by ifj24_compile
+ */
+void ifj24_free_buffer(Ifj24Buffer *buffer)
+{
+    if (buffer == NULL)
+    {
+        return;
+    }
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+}
+
+/**
+ * Returns a short description of a result code
+ */
+const char *ifj24_error_message(int code)
+{
+    switch (code)
+    {
+    case IFJ24_OK:
+        return "success";
+    case IFJ24_ERR_LEXICAL:
+        return "lexical error";
+    case IFJ24_ERR_SYNTAX:
+        return "syntax error";
+    case IFJ24_ERR_UNDEFINED:
+        return "undefined function or variable";
+    case IFJ24_ERR_PARAMS:
+        return "function call parameter mismatch";
+    case IFJ24_ERR_REDEFINITION:
+        return "redefinition or assignment to a constant";
+    case IFJ24_ERR_RETURN:
+        return "missing or extra expression in return";
+    case IFJ24_ERR_TYPE:
+        return "type compatibility error";
+    case IFJ24_ERR_INFER:
+        return "type inference failure";
+    case IFJ24_ERR_UNUSED:
+        return "unused variable";
+    case IFJ24_ERR_SEMANTIC:
+        return "semantic error";
+    default:
+        return "internal compiler error";
+    }
+}
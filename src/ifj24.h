@@ -0,0 +1,81 @@
+/**
+ * @file ifj24.h
+ *
+ * Public interface of the libifj24 library.
+ * Compiles IFJ24 source held in memory to IFJcode24 in memory, without
+ * reading stdin, opening files or ending the process. Compilations are
+ * independent, so the library can be used from several threads at once.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef IFJ24_H
+#define IFJ24_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Results of a compilation, the exit codes of the compiler */
+#define IFJ24_OK 0                // Success
+#define IFJ24_ERR_LEXICAL 1       // Lexical error
+#define IFJ24_ERR_SYNTAX 2        // Syntax error
+#define IFJ24_ERR_UNDEFINED 3     // Undefined function or variable
+#define IFJ24_ERR_PARAMS 4        // Function call parameter mismatch
+#define IFJ24_ERR_REDEFINITION 5  // Redefinition, assignment to const
+#define IFJ24_ERR_RETURN 6        // Missing or extra expression in return
+#define IFJ24_ERR_TYPE 7          // Type compatibility
+#define IFJ24_ERR_INFER 8         // Type inference failure
+#define IFJ24_ERR_UNUSED 9        // Unused variable
+#define IFJ24_ERR_SEMANTIC 10     // Other semantic errors
+#define IFJ24_ERR_INTERNAL 99     // Internal error, invalid options or no memory
+
+/** Optimization levels, as -O0, -O1, -O2 and -Os of the compiler */
+typedef enum {
+    IFJ24_OPT_0,
+    IFJ24_OPT_1,
+    IFJ24_OPT_2,
+    IFJ24_OPT_SIZE
+} Ifj24OptLevel;
+
+/**
+ * Options of a compilation
+ */
+typedef struct {
+    Ifj24OptLevel level;
+    const char *const *enable_passes;  // NULL-terminated names of passes enabled after the level, or NULL
+    const char *const *disable_passes; // NULL-terminated names of passes disabled after that, or NULL
+    int inline_threshold;              // Maximal size of inlined functions, 0 disables inlining
+    bool ir_codegen;                   // Generate code from the SSA IR instead of the AST
+    bool dump_callgraph;               // Append the call graph to the diagnostics
+    bool dump_ir;                      // Append the SSA IR to the diagnostics
+    bool time_passes;                  // Append the time spent in each pass to the diagnostics
+    int codegen_threads;               // Threads generating the functions in parallel, 0 for none, the code is the same for any N > 0
+} Ifj24Options;
+
+/**
+ * Text produced by a compilation, allocated by the library
+ */
+typedef struct {
+    char *data;    // Terminated by '\0', NULL if nothing was produced
+    size_t length; // Length without the terminating '\0'
+} Ifj24Buffer;
+
+// Fills the options the compiler uses without command line options
+void ifj24_default_options(Ifj24Options *options);
+
+// Compiles source of the given length. The code is stored to output only on success,
+// error messages and requested dumps to diagnostics (both may be NULL). Returns IFJ24_OK or an error code.
+int ifj24_compile(const char *source, size_t length, const Ifj24Options *options,
+                  Ifj24Buffer *output, Ifj24Buffer *diagnostics);
+
+// Frees a buffer filled by ifj24_compile
+void ifj24_free_buffer(Ifj24Buffer *buffer);
+
+// Returns a short description of a result code
+const char *ifj24_error_message(int code);
+
+#endif // IFJ24_H
@@ -0,0 +1,1295 @@
+/**
+ * @file ir.c
+ *
+ * Implementation of the mid-level intermediate representation.
+ * Functions are first built into basic blocks with loads and stores of variables,
+ * the SSA form is then constructed by placing phi nodes on the iterated dominance
+ * frontiers of the stores and renaming along the dominator tree.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "ir.h"
+#include "parser.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Construction state of one function */
+typedef struct {
+    IrFunction *function;
+    IrBlock *current;           // Block receiving new instructions
+    char **variables;           // Variables of the function and their types
+    DataType *variable_types;
+    int variable_count;
+    int variable_capacity;
+    IrValue *undef;
+} IrBuilder;
+
+/** Definitions of one variable visible during renaming */
+typedef struct {
+    IrValue **values;
+    int count;
+    int capacity;
+} IrDefinitionStack;
+
+/**
+ * Appends a block to an array of blocks
+ */
+static void add_block_to(IrBlock ***array, int *count, int *capacity, IrBlock *block)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity == 0 ? 4 : *capacity * 2;
+        *array = (IrBlock **)safe_realloc(*array, sizeof(IrBlock *) * *capacity);
+    }
+    (*array)[(*count)++] = block;
+}
+
+/**
+ * Appends a value to an array of values
+ */
+static void add_value_to(IrValue ***array, int *count, int *capacity, IrValue *value)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity == 0 ? 4 : *capacity * 2;
+        *array = (IrValue **)safe_realloc(*array, sizeof(IrValue *) * *capacity);
+    }
+    (*array)[(*count)++] = value;
+}
+
+/**
+ * Checks if an instruction ends its block
+ */
+static bool is_terminator(IrOpcode opcode)
+{
+    return opcode == IR_JUMP || opcode == IR_BRANCH || opcode == IR_RETURN;
+}
+
+/**
+ * Creates an empty block of the function
+ */
+static IrBlock *new_block(IrFunction *function)
+{
+    IrBlock *block = (IrBlock *)safe_malloc(sizeof(IrBlock));
+    memset(block, 0, sizeof(IrBlock));
+    block->id = function->next_block_id++;
+    add_block_to(&function->blocks, &function->block_count, &function->block_capacity, block);
+    return block;
+}
+
+/**
+ * Creates an instruction not placed in any block
+ */
+static IrValue *new_value(IrFunction *function, IrOpcode opcode, DataType type, const char *name, ASTNode *origin)
+{
+    IrValue *value = (IrValue *)safe_malloc(sizeof(IrValue));
+    memset(value, 0, sizeof(IrValue));
+    value->id = function->next_value_id++;
+    value->opcode = opcode;
+    value->type = type;
+    value->name = name != NULL ? string_duplicate(name) : NULL;
+    value->origin = origin;
+    return value;
+}
+
+/**
+ * Adds an operand to an instruction
+ */
+static void add_operand(IrValue *value, IrValue *operand)
+{
+    add_value_to(&value->operands, &value->operand_count, &value->operand_capacity, operand);
+}
+
+/**
+ * Inserts an instruction into a block before another one (at the end if before is NULL)
+ */
+static void insert_value(IrBlock *block, IrValue *before, IrValue *value)
+{
+    value->block = block;
+    value->next = before;
+    value->prev = before != NULL ? before->prev : block->last;
+    if (value->prev != NULL)
+    {
+        value->prev->next = value;
+    }
+    else
+    {
+        block->first = value;
+    }
+    if (before != NULL)
+    {
+        before->prev = value;
+    }
+    else
+    {
+        block->last = value;
+    }
+}
+
+/**
+ * Removes an instruction from its block
+ */
+static void unlink_value(IrValue *value)
+{
+    IrBlock *block = value->block;
+    if (value->prev != NULL)
+    {
+        value->prev->next = value->next;
+    }
+    else
+    {
+        block->first = value->next;
+    }
+    if (value->next != NULL)
+    {
+        value->next->prev = value->prev;
+    }
+    else
+    {
+        block->last = value->prev;
+    }
+    value->prev = value->next = NULL;
+    value->block = NULL;
+}
+
+/**
+ * Adds a control flow edge
+ */
+static void add_edge(IrBlock *from, IrBlock *to)
+{
+    from->succs[from->succ_count++] = to;
+    add_block_to(&to->preds, &to->pred_count, &to->pred_capacity, from);
+}
+
+/**
+ * Appends an instruction to the current block
+ */
+static IrValue *emit(IrBuilder *builder, IrOpcode opcode, DataType type, const char *name, ASTNode *origin)
+{
+    IrValue *value = new_value(builder->function, opcode, type, name, origin);
+    insert_value(builder->current, NULL, value);
+    return value;
+}
+
+/**
+ * Ends the current block by a jump, instructions after it go to a new unreachable block
+ */
+static void emit_jump(IrBuilder *builder, IrBlock *target)
+{
+    emit(builder, IR_JUMP, TYPE_VOID, NULL, NULL);
+    add_edge(builder->current, target);
+}
+
+/**
+ * Ends the current block by a conditional branch
+ */
+static void emit_branch(IrBuilder *builder, IrValue *condition, IrBlock *if_true, IrBlock *if_false, ASTNode *origin)
+{
+    IrValue *branch = emit(builder, IR_BRANCH, TYPE_VOID, NULL, origin);
+    add_operand(branch, condition);
+    add_edge(builder->current, if_true);
+    add_edge(builder->current, if_false);
+}
+
+/**
+ * Records a variable of the function with its type
+ */
+static void add_variable(IrBuilder *builder, const char *name, DataType type)
+{
+    for (int i = 0; i < builder->variable_count; i++)
+    {
+        if (strcmp(builder->variables[i], name) == 0)
+        {
+            return;
+        }
+    }
+    if (builder->variable_count == builder->variable_capacity)
+    {
+        builder->variable_capacity = builder->variable_capacity == 0 ? 8 : builder->variable_capacity * 2;
+        builder->variables = (char **)safe_realloc(builder->variables, sizeof(char *) * builder->variable_capacity);
+        builder->variable_types = (DataType *)safe_realloc(builder->variable_types,
+                                                           sizeof(DataType) * builder->variable_capacity);
+    }
+    builder->variables[builder->variable_count] = string_duplicate(name);
+    builder->variable_types[builder->variable_count] = type;
+    builder->variable_count++;
+}
+
+/**
+ * Finds the index of a variable of the function, -1 if it is unknown
+ */
+static int find_variable(IrBuilder *builder, const char *name)
+{
+    for (int i = 0; i < builder->variable_count; i++)
+    {
+        if (strcmp(builder->variables[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Returns the declared type of a variable
+ */
+static DataType get_variable_type(IrBuilder *builder, const char *name)
+{
+    int index = find_variable(builder, name);
+    return index >= 0 ? builder->variable_types[index] : TYPE_UNKNOWN;
+}
+
+/**
+ * Checks if an identifier names a variable (not a keyword)
+ */
+static bool is_variable(ASTNode *node)
+{
+    return node->type == NODE_IDENTIFIER && strcmp(node->name, "true") != 0 &&
+           strcmp(node->name, "false") != 0 && strcmp(node->name, "nil") != 0;
+}
+
+/**
+ * Builds the instructions computing an expression
+ */
+static IrValue *build_expression(IrBuilder *builder, ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+        return emit(builder, IR_CONST, node->data_type, node->data_type == TYPE_NULL ? "null" : node->value, node);
+
+    case NODE_IDENTIFIER:
+    {
+        if (strcmp(node->name, "true") == 0 || strcmp(node->name, "false") == 0)
+        {
+            return emit(builder, IR_CONST, TYPE_BOOL, node->name, node);
+        }
+        if (strcmp(node->name, "nil") == 0)
+        {
+            return emit(builder, IR_CONST, TYPE_NULL, "null", node);
+        }
+        IrValue *load = emit(builder, IR_LOAD, get_variable_type(builder, node->name), node->name, node);
+        if (!is_nullable(node->data_type))
+        {
+            return load;
+        }
+        // A nullable variable in an expression is read as whether it is not null,
+        // only |id| bindings (untyped identifiers) take its value
+        IrValue *test = emit(builder, IR_NOT_NULL, TYPE_BOOL, NULL, node);
+        add_operand(test, load);
+        return test;
+    }
+
+    case NODE_BINARY_OPERATION:
+    {
+        IrValue *left = build_expression(builder, node->left);
+        IrValue *right = build_expression(builder, node->right);
+        IrValue *value = emit(builder, IR_BINARY, node->data_type, node->name, node);
+        add_operand(value, left);
+        add_operand(value, right);
+        return value;
+    }
+
+    case NODE_FUNCTION_CALL:
+    {
+        // Arguments of user functions are pushed, so evaluated, from the last one
+        bool is_builtin = strncmp(node->name, "ifj.", 4) == 0;
+        IrValue **arguments = (IrValue **)safe_malloc(sizeof(IrValue *) * (node->arg_count + 1));
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            int index = is_builtin ? i : node->arg_count - 1 - i;
+            arguments[index] = build_expression(builder, node->arguments[index]);
+        }
+        IrValue *call = emit(builder, IR_CALL, node->data_type, node->name, node);
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            add_operand(call, arguments[i]);
+        }
+        safe_free(arguments);
+        return call;
+    }
+
+    default:
+        error_exit(ERR_INTERNAL, "Unsupported expression in IR construction, type: %d\n", node->type);
+        return NULL;
+    }
+}
+
+/**
+ * Stores the value of an expression into a variable, a variable read becomes a copy
+ */
+static void build_store(IrBuilder *builder, const char *name, ASTNode *expression)
+{
+    IrValue *value = build_expression(builder, expression);
+    if (is_variable(expression) && value->opcode == IR_LOAD)
+    {
+        // An |id| binding copies a nullable variable, the copy has the declared type
+        IrValue *copy = emit(builder, IR_COPY, get_variable_type(builder, name), name, expression);
+        add_operand(copy, value);
+        value = copy;
+    }
+    if (strcmp(name, "_") == 0)
+    {
+        return;
+    }
+    IrValue *store = emit(builder, IR_STORE, TYPE_VOID, name, expression);
+    add_operand(store, value);
+}
+
+static void build_statements(IrBuilder *builder, ASTNode *statement);
+
+/**
+ * Builds an if statement, both branches continue in a new block
+ */
+static void build_if(IrBuilder *builder, ASTNode *if_node)
+{
+    IrBlock *then_block = new_block(builder->function);
+    IrBlock *else_block = new_block(builder->function);
+    IrBlock *join_block = new_block(builder->function);
+
+    IrValue *condition = build_expression(builder, if_node->condition);
+    emit_branch(builder, condition, then_block, else_block, if_node);
+
+    builder->current = then_block;
+    build_statements(builder, if_node->body->body);
+    emit_jump(builder, join_block);
+
+    builder->current = else_block;
+    if (if_node->left != NULL)
+    {
+        build_statements(builder, if_node->left->body);
+    }
+    emit_jump(builder, join_block);
+    builder->current = join_block;
+}
+
+/**
+ * Builds a while statement, the condition is tested in its own header block
+ */
+static void build_while(IrBuilder *builder, ASTNode *while_node)
+{
+    IrBlock *header = new_block(builder->function);
+    IrBlock *body = new_block(builder->function);
+    IrBlock *exit = new_block(builder->function);
+
+    emit_jump(builder, header);
+    builder->current = header;
+    IrValue *condition = build_expression(builder, while_node->condition);
+    emit_branch(builder, condition, body, exit, while_node);
+
+    builder->current = body;
+    build_statements(builder, while_node->body->body);
+    emit_jump(builder, header);
+    builder->current = exit;
+}
+
+/**
+ * Builds a list of statements into the current block
+ */
+static void build_statements(IrBuilder *builder, ASTNode *statement)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+            add_variable(builder, statement->name, statement->data_type);
+            if (statement->left != NULL)
+            {
+                build_store(builder, statement->name, statement->left);
+            }
+            break;
+
+        case NODE_ASSIGNMENT:
+            build_store(builder, statement->name, statement->left);
+            break;
+
+        case NODE_FUNCTION_CALL:
+        {
+            IrValue *call = build_expression(builder, statement);
+            if (statement->left != NULL)
+            {
+                IrValue *store = emit(builder, IR_STORE, TYPE_VOID, statement->left->name, statement);
+                add_operand(store, call);
+            }
+            break;
+        }
+
+        case NODE_RETURN:
+        {
+            IrValue *value = statement->left != NULL ? build_expression(builder, statement->left) : NULL;
+            IrValue *return_value = emit(builder, IR_RETURN, TYPE_VOID, NULL, statement);
+            if (value != NULL)
+            {
+                add_operand(return_value, value);
+            }
+            // Statements after a return are unreachable
+            builder->current = new_block(builder->function);
+            break;
+        }
+
+        case NODE_IF:
+            build_if(builder, statement);
+            break;
+
+        case NODE_WHILE:
+            build_while(builder, statement);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Marks blocks reachable from a block
+ */
+static void mark_reachable(IrBlock *block, bool *reachable)
+{
+    if (reachable[block->id])
+    {
+        return;
+    }
+    reachable[block->id] = true;
+    for (int i = 0; i < block->succ_count; i++)
+    {
+        mark_reachable(block->succs[i], reachable);
+    }
+}
+
+/**
+ * Removes a predecessor from the list of a block
+ */
+static void remove_pred(IrBlock *block, IrBlock *pred)
+{
+    for (int i = 0; i < block->pred_count; i++)
+    {
+        if (block->preds[i] == pred)
+        {
+            for (int j = i; j < block->pred_count - 1; j++)
+            {
+                block->preds[j] = block->preds[j + 1];
+            }
+            block->pred_count--;
+            return;
+        }
+    }
+}
+
+/**
+ * Removes blocks unreachable from the entry (code after returns)
+ */
+static void remove_unreachable_blocks(IrFunction *function)
+{
+    bool *reachable = (bool *)safe_malloc(sizeof(bool) * function->next_block_id);
+    memset(reachable, 0, sizeof(bool) * function->next_block_id);
+    mark_reachable(function->blocks[0], reachable);
+
+    int count = 0;
+    for (int i = 0; i < function->block_count; i++)
+    {
+        IrBlock *block = function->blocks[i];
+        if (reachable[block->id])
+        {
+            function->blocks[count++] = block;
+            continue;
+        }
+        for (int j = 0; j < block->succ_count; j++)
+        {
+            remove_pred(block->succs[j], block);
+        }
+    }
+    function->block_count = count;
+    safe_free(reachable);
+}
+
+/**
+ * Splits edges from blocks with two successors to blocks with several predecessors,
+ * so copies for phi nodes always have a block of their own edge
+ */
+static void split_critical_edges(IrFunction *function)
+{
+    int block_count = function->block_count;
+    for (int i = 0; i < block_count; i++)
+    {
+        IrBlock *block = function->blocks[i];
+        if (block->succ_count < 2)
+        {
+            continue;
+        }
+        for (int j = 0; j < block->succ_count; j++)
+        {
+            IrBlock *succ = block->succs[j];
+            if (succ->pred_count < 2)
+            {
+                continue;
+            }
+            IrBlock *split = new_block(function);
+            IrValue *jump = new_value(function, IR_JUMP, TYPE_VOID, NULL, NULL);
+            insert_value(split, NULL, jump);
+            block->succs[j] = split;
+            add_block_to(&split->preds, &split->pred_count, &split->pred_capacity, block);
+            split->succs[split->succ_count++] = succ;
+            for (int k = 0; k < succ->pred_count; k++)
+            {
+                if (succ->preds[k] == block)
+                {
+                    succ->preds[k] = split;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Numbers blocks in postorder of a depth-first search
+ */
+static void number_postorder(IrBlock *block, bool *visited, IrBlock **postorder, int *count)
+{
+    visited[block->id] = true;
+    for (int i = 0; i < block->succ_count; i++)
+    {
+        if (!visited[block->succs[i]->id])
+        {
+            number_postorder(block->succs[i], visited, postorder, count);
+        }
+    }
+    postorder[(*count)++] = block;
+}
+
+/**
+ * Nearest common dominator of two blocks with computed dominators
+ */
+static IrBlock *intersect(IrBlock *a, IrBlock *b)
+{
+    while (a != b)
+    {
+        while (a->order > b->order)
+        {
+            a = a->idom;
+        }
+        while (b->order > a->order)
+        {
+            b = b->idom;
+        }
+    }
+    return a;
+}
+
+/**
+ * Computes reverse postorder, dominators (Cooper, Harvey, Kennedy),
+ * the dominator tree and dominance frontiers
+ */
+void ir_compute_dominators(IrFunction *function)
+{
+    bool *visited = (bool *)safe_malloc(sizeof(bool) * function->next_block_id);
+    memset(visited, 0, sizeof(bool) * function->next_block_id);
+    IrBlock **postorder = (IrBlock **)safe_malloc(sizeof(IrBlock *) * function->block_count);
+    int count = 0;
+    number_postorder(function->blocks[0], visited, postorder, &count);
+    for (int i = 0; i < count; i++)
+    {
+        IrBlock *block = postorder[count - 1 - i];
+        function->blocks[i] = block;
+        block->order = i;
+        block->idom = NULL;
+        block->child_count = 0;
+        block->frontier_count = 0;
+    }
+    function->block_count = count;
+    safe_free(postorder);
+    safe_free(visited);
+
+    IrBlock *entry = function->blocks[0];
+    entry->idom = entry;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 1; i < function->block_count; i++)
+        {
+            IrBlock *block = function->blocks[i];
+            IrBlock *idom = NULL;
+            for (int j = 0; j < block->pred_count; j++)
+            {
+                IrBlock *pred = block->preds[j];
+                if (pred->idom != NULL)
+                {
+                    idom = idom == NULL ? pred : intersect(pred, idom);
+                }
+            }
+            if (block->idom != idom)
+            {
+                block->idom = idom;
+                changed = true;
+            }
+        }
+    }
+    entry->idom = NULL;
+
+    for (int i = 1; i < function->block_count; i++)
+    {
+        IrBlock *block = function->blocks[i];
+        add_block_to(&block->idom->children, &block->idom->child_count, &block->idom->child_capacity, block);
+    }
+
+    // A join block is in the frontier of every block between its predecessors and its dominator
+    for (int i = 0; i < function->block_count; i++)
+    {
+        IrBlock *block = function->blocks[i];
+        if (block->pred_count < 2)
+        {
+            continue;
+        }
+        for (int j = 0; j < block->pred_count; j++)
+        {
+            for (IrBlock *runner = block->preds[j]; runner != block->idom; runner = runner->idom)
+            {
+                bool present = false;
+                for (int k = 0; k < runner->frontier_count; k++)
+                {
+                    present = present || runner->frontier[k] == block;
+                }
+                if (!present)
+                {
+                    add_block_to(&runner->frontier, &runner->frontier_count, &runner->frontier_capacity, block);
+                }
+                if (runner->idom == NULL)
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Checks if block a dominates block b
+ */
+bool ir_dominates(IrBlock *a, IrBlock *b)
+{
+    for (; b != NULL; b = b->idom)
+    {
+        if (a == b)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Value of a variable on paths where it was never assigned
+ */
+static IrValue *get_undef(IrBuilder *builder)
+{
+    if (builder->undef == NULL)
+    {
+        IrBlock *entry = builder->function->blocks[0];
+        builder->undef = new_value(builder->function, IR_UNDEF, TYPE_UNKNOWN, NULL, NULL);
+        insert_value(entry, entry->first, builder->undef);
+    }
+    return builder->undef;
+}
+
+/**
+ * Inserts phi nodes on the iterated dominance frontiers of the stores of each variable
+ * read in a block other than the one assigning it (semi-pruned SSA)
+ */
+static void insert_phis(IrBuilder *builder)
+{
+    IrFunction *function = builder->function;
+    int block_count = function->block_count;
+    bool *is_global = (bool *)safe_malloc(sizeof(bool) * (builder->variable_count + 1));
+    memset(is_global, 0, sizeof(bool) * (builder->variable_count + 1));
+    bool *assigned = (bool *)safe_malloc(sizeof(bool) * (builder->variable_count + 1));
+
+    for (int i = 0; i < block_count; i++)
+    {
+        memset(assigned, 0, sizeof(bool) * (builder->variable_count + 1));
+        for (IrValue *value = function->blocks[i]->first; value != NULL; value = value->next)
+        {
+            int index = value->opcode == IR_LOAD || value->opcode == IR_STORE ? find_variable(builder, value->name) : -1;
+            if (index < 0)
+            {
+                continue;
+            }
+            if (value->opcode == IR_LOAD && !assigned[index])
+            {
+                is_global[index] = true;
+            }
+            assigned[index] = assigned[index] || value->opcode == IR_STORE;
+        }
+    }
+
+    bool *has_phi = (bool *)safe_malloc(sizeof(bool) * block_count);
+    bool *queued = (bool *)safe_malloc(sizeof(bool) * block_count);
+    IrBlock **worklist = (IrBlock **)safe_malloc(sizeof(IrBlock *) * block_count);
+    for (int variable = 0; variable < builder->variable_count; variable++)
+    {
+        if (!is_global[variable])
+        {
+            continue;
+        }
+        memset(has_phi, 0, sizeof(bool) * block_count);
+        memset(queued, 0, sizeof(bool) * block_count);
+        int count = 0;
+        for (int i = 0; i < block_count; i++)
+        {
+            for (IrValue *value = function->blocks[i]->first; value != NULL; value = value->next)
+            {
+                if (value->opcode == IR_STORE && strcmp(value->name, builder->variables[variable]) == 0)
+                {
+                    queued[i] = true;
+                    worklist[count++] = function->blocks[i];
+                    break;
+                }
+            }
+        }
+        while (count > 0)
+        {
+            IrBlock *block = worklist[--count];
+            for (int i = 0; i < block->frontier_count; i++)
+            {
+                IrBlock *join = block->frontier[i];
+                if (has_phi[join->order])
+                {
+                    continue;
+                }
+                has_phi[join->order] = true;
+                IrValue *phi = new_value(function, IR_PHI, builder->variable_types[variable],
+                                         builder->variables[variable], NULL);
+                phi->operands = (IrValue **)safe_malloc(sizeof(IrValue *) * join->pred_count);
+                phi->operand_count = phi->operand_capacity = join->pred_count;
+                insert_value(join, join->first, phi);
+                if (!queued[join->order])
+                {
+                    queued[join->order] = true;
+                    worklist[count++] = join;
+                }
+            }
+        }
+    }
+    safe_free(worklist);
+    safe_free(queued);
+    safe_free(has_phi);
+    safe_free(assigned);
+    safe_free(is_global);
+}
+
+/**
+ * Current definition of a variable, undefined if it has none on this path
+ */
+static IrValue *top_definition(IrBuilder *builder, IrDefinitionStack *stacks, int variable)
+{
+    return stacks[variable].count > 0 ? stacks[variable].values[stacks[variable].count - 1] : get_undef(builder);
+}
+
+/**
+ * Replaces loads and stores by the values they stand for, walking the dominator tree
+ */
+static void rename_block(IrBuilder *builder, IrBlock *block, IrDefinitionStack *stacks)
+{
+    int *heights = (int *)safe_malloc(sizeof(int) * (builder->variable_count + 1));
+    for (int i = 0; i < builder->variable_count; i++)
+    {
+        heights[i] = stacks[i].count;
+    }
+
+    IrValue *next;
+    for (IrValue *value = block->first; value != NULL; value = next)
+    {
+        next = value->next;
+        for (int i = 0; i < value->operand_count; i++)
+        {
+            if (value->opcode != IR_PHI && value->operands[i]->opcode == IR_LOAD)
+            {
+                value->operands[i] = value->operands[i]->replacement;
+            }
+        }
+        int variable = value->name != NULL ? find_variable(builder, value->name) : -1;
+        if (value->opcode == IR_PHI && variable >= 0)
+        {
+            add_value_to(&stacks[variable].values, &stacks[variable].count, &stacks[variable].capacity, value);
+        }
+        else if (value->opcode == IR_LOAD)
+        {
+            value->replacement = variable >= 0 ? top_definition(builder, stacks, variable) : get_undef(builder);
+            unlink_value(value);
+        }
+        else if (value->opcode == IR_STORE)
+        {
+            if (variable >= 0)
+            {
+                add_value_to(&stacks[variable].values, &stacks[variable].count, &stacks[variable].capacity,
+                             value->operands[0]);
+            }
+            unlink_value(value);
+        }
+    }
+
+    for (int i = 0; i < block->succ_count; i++)
+    {
+        IrBlock *succ = block->succs[i];
+        int index = 0;
+        while (succ->preds[index] != block)
+        {
+            index++;
+        }
+        for (IrValue *phi = succ->first; phi != NULL && phi->opcode == IR_PHI; phi = phi->next)
+        {
+            phi->operands[index] = top_definition(builder, stacks, find_variable(builder, phi->name));
+        }
+    }
+
+    for (int i = 0; i < block->child_count; i++)
+    {
+        rename_block(builder, block->children[i], stacks);
+    }
+
+    for (int i = 0; i < builder->variable_count; i++)
+    {
+        stacks[i].count = heights[i];
+    }
+    safe_free(heights);
+}
+
+/**
+ * Recomputes def-use chains of all values of the function
+ */
+void ir_compute_uses(IrFunction *function)
+{
+    for (int i = 0; i < function->block_count; i++)
+    {
+        for (IrValue *value = function->blocks[i]->first; value != NULL; value = value->next)
+        {
+            value->user_count = 0;
+        }
+    }
+    for (int i = 0; i < function->param_count; i++)
+    {
+        function->params[i]->user_count = 0;
+    }
+    for (int i = 0; i < function->block_count; i++)
+    {
+        for (IrValue *value = function->blocks[i]->first; value != NULL; value = value->next)
+        {
+            for (int j = 0; j < value->operand_count; j++)
+            {
+                IrValue *operand = value->operands[j];
+                add_value_to(&operand->users, &operand->user_count, &operand->user_capacity, value);
+            }
+        }
+    }
+}
+
+/**
+ * Removes one occurrence of a user from the def-use chain of a value
+ */
+static void remove_user(IrValue *value, IrValue *user)
+{
+    for (int i = 0; i < value->user_count; i++)
+    {
+        if (value->users[i] == user)
+        {
+            value->users[i] = value->users[--value->user_count];
+            return;
+        }
+    }
+}
+
+/**
+ * Replaces all uses of a value by another value
+ */
+void ir_replace_uses(IrValue *value, IrValue *replacement)
+{
+    for (int i = 0; i < value->user_count; i++)
+    {
+        IrValue *user = value->users[i];
+        for (int j = 0; j < user->operand_count; j++)
+        {
+            if (user->operands[j] == value)
+            {
+                user->operands[j] = replacement;
+                add_value_to(&replacement->users, &replacement->user_count, &replacement->user_capacity, user);
+                break;
+            }
+        }
+    }
+    value->user_count = 0;
+}
+
+/**
+ * Removes an instruction without uses from its block
+ */
+void ir_remove_value(IrValue *value)
+{
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        remove_user(value->operands[i], value);
+    }
+    value->operand_count = 0;
+    if (value->block != NULL)
+    {
+        unlink_value(value);
+    }
+}
+
+/**
+ * Removes phi nodes that are unused or merge a single value
+ */
+static void simplify_phis(IrFunction *function)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 0; i < function->block_count; i++)
+        {
+            IrValue *next;
+            for (IrValue *phi = function->blocks[i]->first; phi != NULL && phi->opcode == IR_PHI; phi = next)
+            {
+                next = phi->next;
+                bool is_used = false;
+                for (int j = 0; j < phi->user_count; j++)
+                {
+                    is_used = is_used || phi->users[j] != phi;
+                }
+                IrValue *same = NULL;
+                bool is_trivial = true;
+                for (int j = 0; j < phi->operand_count; j++)
+                {
+                    IrValue *operand = phi->operands[j];
+                    if (operand != phi && operand != same)
+                    {
+                        is_trivial = is_trivial && same == NULL;
+                        same = operand;
+                    }
+                }
+                if (!is_used || (is_trivial && same != NULL))
+                {
+                    if (is_used)
+                    {
+                        ir_replace_uses(phi, same);
+                    }
+                    ir_remove_value(phi);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Builds the SSA form of a function
+ */
+static IrFunction *build_function(ASTNode *function_node)
+{
+    IrFunction *function = (IrFunction *)safe_malloc(sizeof(IrFunction));
+    memset(function, 0, sizeof(IrFunction));
+    function->name = string_duplicate(function_node->name);
+    function->return_type = function_node->data_type;
+    function->origin = function_node;
+
+    IrBuilder builder;
+    memset(&builder, 0, sizeof(IrBuilder));
+    builder.function = function;
+    builder.current = new_block(function);
+
+    if (function_node->param_count > 0)
+    {
+        function->params = (IrValue **)safe_malloc(sizeof(IrValue *) * function_node->param_count);
+    }
+    for (int i = 0; i < function_node->param_count; i++)
+    {
+        ASTNode *param_node = function_node->parameters[i];
+        add_variable(&builder, param_node->name, param_node->data_type);
+        IrValue *param = emit(&builder, IR_PARAM, param_node->data_type, param_node->name, param_node);
+        IrValue *store = emit(&builder, IR_STORE, TYPE_VOID, param_node->name, param_node);
+        add_operand(store, param);
+        function->params[function->param_count++] = param;
+    }
+
+    build_statements(&builder, function_node->body->body);
+    if (builder.current->last == NULL || !is_terminator(builder.current->last->opcode))
+    {
+        emit(&builder, IR_RETURN, TYPE_VOID, NULL, NULL);
+    }
+
+    remove_unreachable_blocks(function);
+    split_critical_edges(function);
+    ir_compute_dominators(function);
+    insert_phis(&builder);
+
+    IrDefinitionStack *stacks = (IrDefinitionStack *)safe_malloc(sizeof(IrDefinitionStack) * (builder.variable_count + 1));
+    memset(stacks, 0, sizeof(IrDefinitionStack) * (builder.variable_count + 1));
+    rename_block(&builder, function->blocks[0], stacks);
+    for (int i = 0; i < builder.variable_count; i++)
+    {
+        if (stacks[i].values != NULL)
+        {
+            safe_free(stacks[i].values);
+        }
+    }
+    safe_free(stacks);
+
+    ir_compute_uses(function);
+    simplify_phis(function);
+    return function;
+}
+
+/**
+ * Builds the SSA form of all functions of the program
+ */
+IrProgram *ir_build_program(ASTNode *program_node)
+{
+    IrProgram *program = (IrProgram *)safe_malloc(sizeof(IrProgram));
+    program->functions = NULL;
+    IrFunction **link = &program->functions;
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            *link = build_function(function);
+            link = &(*link)->next;
+        }
+    }
+    return program;
+}
+
+/**
+ * Checks if a value is defined before an instruction of the same block
+ */
+static bool is_defined_before(IrValue *definition, IrValue *use)
+{
+    for (IrValue *value = use->prev; value != NULL; value = value->prev)
+    {
+        if (value == definition)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks the structure of the function and the SSA dominance property, prints the first error
+ */
+bool ir_verify(IrFunction *function, FILE *output)
+{
+    for (int i = 0; i < function->block_count; i++)
+    {
+        IrBlock *block = function->blocks[i];
+        if (block->last == NULL || !is_terminator(block->last->opcode))
+        {
+            fprintf(output, "IR error in %s: block b%d has no terminator\n", function->name, block->id);
+            return false;
+        }
+        int expected_succs = block->last->opcode == IR_JUMP ? 1 : block->last->opcode == IR_BRANCH ? 2 : 0;
+        if (block->succ_count != expected_succs)
+        {
+            fprintf(output, "IR error in %s: block b%d has %d successors\n", function->name, block->id, block->succ_count);
+            return false;
+        }
+        for (int j = 0; j < block->succ_count; j++)
+        {
+            IrBlock *succ = block->succs[j];
+            int found = 0;
+            for (int k = 0; k < succ->pred_count; k++)
+            {
+                found += succ->preds[k] == block;
+            }
+            if (found != 1)
+            {
+                fprintf(output, "IR error in %s: edge b%d -> b%d is not in the predecessors\n",
+                        function->name, block->id, succ->id);
+                return false;
+            }
+        }
+
+        bool phis_allowed = true;
+        for (IrValue *value = block->first; value != NULL; value = value->next)
+        {
+            if (value->block != block || (is_terminator(value->opcode) && value != block->last))
+            {
+                fprintf(output, "IR error in %s: v%d misplaced in block b%d\n", function->name, value->id, block->id);
+                return false;
+            }
+            if (value->opcode == IR_LOAD || value->opcode == IR_STORE || (value->opcode == IR_PHI && !phis_allowed))
+            {
+                fprintf(output, "IR error in %s: v%d is not valid SSA\n", function->name, value->id);
+                return false;
+            }
+            phis_allowed = value->opcode == IR_PHI || value->opcode == IR_UNDEF;
+            if (value->opcode == IR_PHI && value->operand_count != block->pred_count)
+            {
+                fprintf(output, "IR error in %s: phi v%d has %d operands for %d predecessors\n",
+                        function->name, value->id, value->operand_count, block->pred_count);
+                return false;
+            }
+            for (int j = 0; j < value->operand_count; j++)
+            {
+                IrValue *operand = value->operands[j];
+                IrBlock *use_block = value->opcode == IR_PHI ? block->preds[j] : block;
+                bool dominated = operand->block != NULL && ir_dominates(operand->block, use_block) &&
+                                 (operand->block != block || value->opcode == IR_PHI || is_defined_before(operand, value));
+                if (!dominated)
+                {
+                    fprintf(output, "IR error in %s: v%d uses v%d which does not dominate it\n",
+                            function->name, value->id, operand->id);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Name of a type in IFJ24 syntax
+ */
+static const char *get_type_name(DataType type)
+{
+    switch (type)
+    {
+    case TYPE_INT:
+        return "i32";
+    case TYPE_FLOAT:
+        return "f64";
+    case TYPE_U8:
+        return "[]u8";
+    case TYPE_BOOL:
+        return "bool";
+    case TYPE_NULL:
+        return "null";
+    case TYPE_VOID:
+        return "void";
+    case TYPE_INT_NULLABLE:
+        return "?i32";
+    case TYPE_FLOAT_NULLABLE:
+        return "?f64";
+    case TYPE_U8_NULLABLE:
+        return "?[]u8";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * Prints one instruction
+ */
+static void dump_value(IrValue *value, FILE *output)
+{
+    fprintf(output, "  ");
+    if (!is_terminator(value->opcode) && value->type != TYPE_VOID)
+    {
+        fprintf(output, "v%d = ", value->id);
+    }
+    switch (value->opcode)
+    {
+    case IR_CONST:
+        if (value->type == TYPE_U8)
+        {
+            fprintf(output, "const %s \"%s\"", get_type_name(value->type), value->name);
+        }
+        else
+        {
+            fprintf(output, "const %s %s", get_type_name(value->type), value->name);
+        }
+        break;
+    case IR_UNDEF:
+        fprintf(output, "undef");
+        break;
+    case IR_PARAM:
+        fprintf(output, "param %s %s", get_type_name(value->type), value->name);
+        break;
+    case IR_PHI:
+        fprintf(output, "phi %s", get_type_name(value->type));
+        for (int i = 0; i < value->operand_count; i++)
+        {
+            fprintf(output, "%s [v%d, b%d]", i > 0 ? "," : "", value->operands[i]->id, value->block->preds[i]->id);
+        }
+        fprintf(output, " ; %s", value->name);
+        break;
+    case IR_COPY:
+        fprintf(output, "copy %s v%d ; %s", get_type_name(value->type), value->operands[0]->id, value->name);
+        break;
+    case IR_BINARY:
+        fprintf(output, "%s v%d %s v%d", get_type_name(value->type), value->operands[0]->id, value->name,
+                value->operands[1]->id);
+        break;
+    case IR_NOT_NULL:
+        fprintf(output, "not_null v%d", value->operands[0]->id);
+        break;
+    case IR_CALL:
+        fprintf(output, "call %s %s(", get_type_name(value->type), value->name);
+        for (int i = 0; i < value->operand_count; i++)
+        {
+            fprintf(output, "%sv%d", i > 0 ? ", " : "", value->operands[i]->id);
+        }
+        fprintf(output, ")");
+        break;
+    case IR_JUMP:
+        fprintf(output, "jump b%d", value->block->succs[0]->id);
+        break;
+    case IR_BRANCH:
+        fprintf(output, "branch v%d, b%d, b%d", value->operands[0]->id, value->block->succs[0]->id,
+                value->block->succs[1]->id);
+        break;
+    case IR_RETURN:
+        fprintf(output, "return");
+        if (value->operand_count > 0)
+        {
+            fprintf(output, " v%d", value->operands[0]->id);
+        }
+        break;
+    default:
+        fprintf(output, "%s %s", value->opcode == IR_LOAD ? "load" : "store", value->name);
+        break;
+    }
+    fprintf(output, "\n");
+}
+
+/**
+ * Prints the program in a readable form
+ */
+void ir_dump(IrProgram *program, FILE *output)
+{
+    for (IrFunction *function = program->functions; function != NULL; function = function->next)
+    {
+        fprintf(output, "function %s(", function->name);
+        for (int i = 0; i < function->param_count; i++)
+        {
+            fprintf(output, "%sv%d", i > 0 ? ", " : "", function->params[i]->id);
+        }
+        fprintf(output, ") %s\n", get_type_name(function->return_type));
+        for (int i = 0; i < function->block_count; i++)
+        {
+            IrBlock *block = function->blocks[i];
+            fprintf(output, "b%d:", block->id);
+            if (block->pred_count > 0)
+            {
+                fprintf(output, " ; preds");
+                for (int j = 0; j < block->pred_count; j++)
+                {
+                    fprintf(output, "%s b%d", j > 0 ? "," : "", block->preds[j]->id);
+                }
+                fprintf(output, ", idom b%d", block->idom->id);
+            }
+            fprintf(output, "\n");
+            for (IrValue *value = block->first; value != NULL; value = value->next)
+            {
+                dump_value(value, output);
+            }
+        }
+        fprintf(output, "\n");
+    }
+}
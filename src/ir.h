@@ -0,0 +1,117 @@
+/**
+ * @file ir.h
+ *
+ * Header file for the mid-level intermediate representation.
+ * Each function is a control flow graph of basic blocks holding instructions
+ * in SSA form, with dominators, dominance frontiers and def-use chains.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "ast.h"
+
+typedef enum {
+    IR_CONST,     // Literal, name holds its text
+    IR_UNDEF,     // Value of a variable not assigned on some path
+    IR_PARAM,     // Function parameter
+    IR_PHI,       // Operand i comes from predecessor i of the block
+    IR_COPY,      // Value of another variable
+    IR_BINARY,    // Arithmetic or comparison, name holds the operator
+    IR_NOT_NULL,  // Whether a nullable value is not null (read of a nullable variable)
+    IR_CALL,      // Built-in or user function call, name holds the function
+    IR_LOAD,      // Read of a variable, only before SSA construction
+    IR_STORE,     // Write of a variable, only before SSA construction
+    IR_JUMP,      // Terminator to the only successor
+    IR_BRANCH,    // Terminator to successor 0 if the operand is true, else to successor 1
+    IR_RETURN     // Terminator with an optional returned operand
+} IrOpcode;
+
+typedef struct IrValue {
+    int id;
+    IrOpcode opcode;
+    DataType type;              // Type of the result
+    char *name;                 // Constant text, operator, function or variable name
+    struct IrValue **operands;
+    int operand_count;
+    int operand_capacity;
+    struct IrValue **users;     // Instructions using the value, once per operand
+    int user_count;
+    int user_capacity;
+    struct IrBlock *block;
+    ASTNode *origin;            // AST node the value was built from
+    struct IrValue *replacement; // Value a load stands for during SSA construction
+    struct IrValue *prev;
+    struct IrValue *next;
+} IrValue;
+
+typedef struct IrBlock {
+    int id;
+    IrValue *first;
+    IrValue *last;              // Terminator
+    struct IrBlock **preds;
+    int pred_count;
+    int pred_capacity;
+    struct IrBlock *succs[2];
+    int succ_count;
+    struct IrBlock *idom;       // Immediate dominator, NULL for the entry block
+    struct IrBlock **frontier;  // Dominance frontier
+    int frontier_count;
+    int frontier_capacity;
+    struct IrBlock **children;  // Blocks immediately dominated by this one
+    int child_count;
+    int child_capacity;
+    int order;                  // Index in reverse postorder
+} IrBlock;
+
+typedef struct IrFunction {
+    char *name;
+    DataType return_type;
+    ASTNode *origin;
+    IrBlock **blocks;           // Reverse postorder, blocks[0] is the entry
+    int block_count;
+    int block_capacity;
+    IrValue **params;
+    int param_count;
+    int next_value_id;
+    int next_block_id;
+    struct IrFunction *next;
+} IrFunction;
+
+typedef struct {
+    IrFunction *functions;
+} IrProgram;
+
+// Builds the SSA form of all functions of the program
+IrProgram *ir_build_program(ASTNode *program_node);
+
+// Computes reverse postorder, dominators, the dominator tree and dominance frontiers
+void ir_compute_dominators(IrFunction *function);
+
+// Checks if block a dominates block b
+bool ir_dominates(IrBlock *a, IrBlock *b);
+
+// Recomputes def-use chains of all values of the function
+void ir_compute_uses(IrFunction *function);
+
+// Replaces all uses of a value by another value
+void ir_replace_uses(IrValue *value, IrValue *replacement);
+
+// Removes an instruction without uses from its block
+void ir_remove_value(IrValue *value);
+
+// Checks the structure of the function and the SSA dominance property, prints the first error
+bool ir_verify(IrFunction *function, FILE *output);
+
+// Prints the program in a readable form
+void ir_dump(IrProgram *program, FILE *output);
+
+#endif // IR_H
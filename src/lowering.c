@@ -0,0 +1,367 @@
+/**
+ * @file lowering.c
+ *
+ * Translation of the SSA IR to IFJcode24.
+ * Every SSA value with a result gets its own frame variable, constants are used
+ * directly as instruction operands. Phi nodes become moves at the end of their
+ * predecessors (critical edges are split, so each of them has a single successor),
+ * through temporaries when a phi of the same block is one of the moved values.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "lowering.h"
+#include "codegen.h"
+#include "compiler.h"
+#include "parser.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SYMBOL_SIZE 1024
+
+/**
+ * Checks if a value is stored in a frame variable
+ */
+static bool has_variable(IrValue *value) {
+    return value->opcode != IR_CONST && value->opcode != IR_UNDEF && value->opcode != IR_JUMP &&
+           value->opcode != IR_BRANCH && value->opcode != IR_RETURN && value->type != TYPE_VOID;
+}
+
+/**
+ * Returns the instruction operand holding a value
+ */
+static char *get_symbol(IrValue *value) {
+    char *symbol = safe_malloc(SYMBOL_SIZE);
+    if (value->opcode == IR_UNDEF || (value->opcode == IR_CONST && value->type == TYPE_NULL)) {
+        snprintf(symbol, SYMBOL_SIZE, "nil@nil");
+    } else if (value->opcode != IR_CONST) {
+        snprintf(symbol, SYMBOL_SIZE, "LF@%%v%d", value->id);
+    } else if (value->type == TYPE_INT) {
+        snprintf(symbol, SYMBOL_SIZE, "int@%s", value->name);
+    } else if (value->type == TYPE_FLOAT) {
+        snprintf(symbol, SYMBOL_SIZE, "float@%.13a", atof(value->name));
+    } else if (value->type == TYPE_BOOL) {
+        snprintf(symbol, SYMBOL_SIZE, "bool@%s", strcmp(value->name, "true") == 0 ? "true" : "false");
+    } else {
+        char *escaped = escape_ifj24_string(value->name);
+        snprintf(symbol, SYMBOL_SIZE, "string@%s", escaped);
+        safe_free(escaped);
+    }
+    return symbol;
+}
+
+/**
+ * Label of a block
+ */
+static void get_block_label(IrFunction *function, IrBlock *block, char *label, size_t size) {
+    snprintf(label, size, "$ir_%s_b%d", function->name, block->id);
+}
+
+/**
+ * Generates a binary operation into the variable of the value
+ */
+static void lowering_generate_binary(FILE *output, IrValue *value, const char *result) {
+    char *left = get_symbol(value->operands[0]);
+    char *right = get_symbol(value->operands[1]);
+    const char *op = value->name;
+
+    if (strcmp(op, "/") == 0 && (value->operands[0]->type == TYPE_FLOAT || value->operands[1]->type == TYPE_FLOAT)) {
+        // Integer operands of a float division are converted first
+        if (value->operands[0]->type != TYPE_FLOAT) {
+            fprintf(output, "INT2FLOAT LF@%%tmp_float %s\n", left);
+            snprintf(left, SYMBOL_SIZE, "LF@%%tmp_float");
+        }
+        if (value->operands[1]->type != TYPE_FLOAT) {
+            fprintf(output, "INT2FLOAT LF@%%tmp_float2 %s\n", right);
+            snprintf(right, SYMBOL_SIZE, "LF@%%tmp_float2");
+        }
+        fprintf(output, "DIV %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "/") == 0) {
+        fprintf(output, "IDIV %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "+") == 0) {
+        fprintf(output, "ADD %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "-") == 0) {
+        fprintf(output, "SUB %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "*") == 0) {
+        fprintf(output, "MUL %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "<") == 0 || strcmp(op, ">=") == 0) {
+        fprintf(output, "LT %s %s %s\n", result, left, right);
+    } else if (strcmp(op, ">") == 0 || strcmp(op, "<=") == 0) {
+        fprintf(output, "GT %s %s %s\n", result, left, right);
+    } else if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0) {
+        fprintf(output, "EQ %s %s %s\n", result, left, right);
+    } else {
+        error_exit(ERR_INTERNAL, "Unsupported operator in IR lowering: %s\n", op);
+    }
+    if (strcmp(op, ">=") == 0 || strcmp(op, "<=") == 0 || strcmp(op, "!=") == 0) {
+        fprintf(output, "NOT %s %s\n", result, result);
+    }
+    safe_free(left);
+    safe_free(right);
+}
+
+/**
+ * Generates a call of a built-in or user function
+ */
+static void lowering_generate_call(FILE *output, IrFunction *function, IrValue *value, const char *result) {
+    const char *name = value->name;
+    char *args[3] = {NULL, NULL, NULL};
+    for (int i = 0; i < value->operand_count && i < 3; i++) {
+        args[i] = get_symbol(value->operands[i]);
+    }
+    int label = compiler_context_current()->lowering_label_counter++;
+
+    if (strcmp(name, "ifj.write") == 0) {
+        if (is_nullable(value->operands[0]->type)) {
+            fprintf(output, "TYPE LF@%%tmp_type %s\n", args[0]);
+            fprintf(output, "JUMPIFEQ $ir_%s_%d_null LF@%%tmp_type string@nil\n", function->name, label);
+            fprintf(output, "WRITE %s\n", args[0]);
+            fprintf(output, "JUMP $ir_%s_%d_end\n", function->name, label);
+            fprintf(output, "LABEL $ir_%s_%d_null\n", function->name, label);
+            fprintf(output, "WRITE string@null\n");
+            fprintf(output, "LABEL $ir_%s_%d_end\n", function->name, label);
+        } else {
+            fprintf(output, "WRITE %s\n", args[0]);
+        }
+    } else if (strcmp(name, "ifj.readstr") == 0) {
+        fprintf(output, "READ %s string\n", result);
+    } else if (strcmp(name, "ifj.readi32") == 0) {
+        fprintf(output, "READ %s int\n", result);
+    } else if (strcmp(name, "ifj.readf64") == 0) {
+        fprintf(output, "READ %s float\n", result);
+    } else if (strcmp(name, "ifj.i2f") == 0) {
+        fprintf(output, "INT2FLOAT %s %s\n", result, args[0]);
+    } else if (strcmp(name, "ifj.f2i") == 0) {
+        fprintf(output, "FLOAT2INT %s %s\n", result, args[0]);
+    } else if (strcmp(name, "ifj.string") == 0) {
+        fprintf(output, "MOVE %s %s\n", result, args[0]);
+    } else if (strcmp(name, "ifj.length") == 0) {
+        fprintf(output, "STRLEN %s %s\n", result, args[0]);
+    } else if (strcmp(name, "ifj.concat") == 0) {
+        fprintf(output, "CONCAT %s %s %s\n", result, args[0], args[1]);
+    } else if (strcmp(name, "ifj.chr") == 0) {
+        // The code is taken modulo 256
+        fprintf(output, "IDIV LF@%%tmp_int %s int@256\n", args[0]);
+        fprintf(output, "MUL LF@%%tmp_int LF@%%tmp_int int@256\n");
+        fprintf(output, "SUB LF@%%tmp_int %s LF@%%tmp_int\n", args[0]);
+        fprintf(output, "INT2CHAR %s LF@%%tmp_int\n", result);
+    } else if (strcmp(name, "ifj.ord") == 0) {
+        // Index out of the string gives 0
+        fprintf(output, "MOVE %s int@0\n", result);
+        fprintf(output, "LT LF@%%tmp_bool %s int@0\n", args[1]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@true\n", function->name, label);
+        fprintf(output, "STRLEN LF@%%tmp_int %s\n", args[0]);
+        fprintf(output, "LT LF@%%tmp_bool %s LF@%%tmp_int\n", args[1]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@false\n", function->name, label);
+        fprintf(output, "STRI2INT %s %s %s\n", result, args[0], args[1]);
+        fprintf(output, "LABEL $ir_%s_%d_end\n", function->name, label);
+    } else if (strcmp(name, "ifj.strcmp") == 0) {
+        fprintf(output, "MOVE %s int@0\n", result);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end %s %s\n", function->name, label, args[0], args[1]);
+        fprintf(output, "LT LF@%%tmp_bool %s %s\n", args[0], args[1]);
+        fprintf(output, "MOVE %s int@1\n", result);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@false\n", function->name, label);
+        fprintf(output, "MOVE %s int@-1\n", result);
+        fprintf(output, "LABEL $ir_%s_%d_end\n", function->name, label);
+    } else if (strcmp(name, "ifj.substring") == 0) {
+        // Out of range bounds give null: start < 0, start >= length, end > length, start > end
+        fprintf(output, "MOVE %s nil@nil\n", result);
+        fprintf(output, "LT LF@%%tmp_bool %s int@0\n", args[1]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@true\n", function->name, label);
+        fprintf(output, "STRLEN LF@%%tmp_int %s\n", args[0]);
+        fprintf(output, "LT LF@%%tmp_bool %s LF@%%tmp_int\n", args[1]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@false\n", function->name, label);
+        fprintf(output, "GT LF@%%tmp_bool %s LF@%%tmp_int\n", args[2]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@true\n", function->name, label);
+        fprintf(output, "GT LF@%%tmp_bool %s %s\n", args[1], args[2]);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_bool bool@true\n", function->name, label);
+        fprintf(output, "MOVE %s string@\n", result);
+        fprintf(output, "MOVE LF@%%tmp_int %s\n", args[1]);
+        fprintf(output, "LABEL $ir_%s_%d_loop\n", function->name, label);
+        fprintf(output, "JUMPIFEQ $ir_%s_%d_end LF@%%tmp_int %s\n", function->name, label, args[2]);
+        fprintf(output, "GETCHAR LF@%%tmp_char %s LF@%%tmp_int\n", args[0]);
+        fprintf(output, "CONCAT %s %s LF@%%tmp_char\n", result, result);
+        fprintf(output, "ADD LF@%%tmp_int LF@%%tmp_int int@1\n");
+        fprintf(output, "JUMP $ir_%s_%d_loop\n", function->name, label);
+        fprintf(output, "LABEL $ir_%s_%d_end\n", function->name, label);
+    } else {
+        // User function, arguments are pushed from the last one
+        for (int i = value->operand_count - 1; i >= 0; i--) {
+            char *arg = get_symbol(value->operands[i]);
+            fprintf(output, "PUSHS %s\n", arg);
+            safe_free(arg);
+        }
+        fprintf(output, "CALL %s\n", name);
+        if (value->type != TYPE_VOID) {
+            fprintf(output, "POPS %s\n", result);
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (args[i] != NULL) {
+            safe_free(args[i]);
+        }
+    }
+}
+
+/**
+ * Generates the moves of the phi nodes of the successor for the edge from block
+ */
+static void lowering_generate_phi_moves(FILE *output, IrBlock *block, IrBlock *succ) {
+    int index = 0;
+    while (succ->preds[index] != block) {
+        index++;
+    }
+
+    // Moves are parallel, a phi read by another one is saved first
+    bool through_temporaries = false;
+    for (IrValue *phi = succ->first; phi != NULL && phi->opcode == IR_PHI; phi = phi->next) {
+        IrValue *operand = phi->operands[index];
+        through_temporaries = through_temporaries || (operand->opcode == IR_PHI && operand->block == succ && operand != phi);
+    }
+    for (IrValue *phi = succ->first; phi != NULL && phi->opcode == IR_PHI; phi = phi->next) {
+        IrValue *operand = phi->operands[index];
+        if (operand == phi) {
+            continue;
+        }
+        char *symbol = get_symbol(operand);
+        if (through_temporaries) {
+            fprintf(output, "MOVE LF@%%p%d %s\n", phi->id, symbol);
+        } else {
+            fprintf(output, "MOVE LF@%%v%d %s\n", phi->id, symbol);
+        }
+        safe_free(symbol);
+    }
+    if (through_temporaries) {
+        for (IrValue *phi = succ->first; phi != NULL && phi->opcode == IR_PHI; phi = phi->next) {
+            if (phi->operands[index] != phi) {
+                fprintf(output, "MOVE LF@%%v%d LF@%%p%d\n", phi->id, phi->id);
+            }
+        }
+    }
+}
+
+/**
+ * Generates the terminator of a block, jumps to the next block in the layout are omitted
+ */
+static void lowering_generate_terminator(FILE *output, IrFunction *function, IrBlock *block, IrBlock *next_block) {
+    IrValue *terminator = block->last;
+    char label[SYMBOL_SIZE];
+    switch (terminator->opcode) {
+    case IR_JUMP:
+        lowering_generate_phi_moves(output, block, block->succs[0]);
+        if (block->succs[0] != next_block) {
+            get_block_label(function, block->succs[0], label, sizeof(label));
+            fprintf(output, "JUMP %s\n", label);
+        }
+        break;
+
+    case IR_BRANCH: {
+        char *condition = get_symbol(terminator->operands[0]);
+        if (block->succs[0] != next_block) {
+            get_block_label(function, block->succs[0], label, sizeof(label));
+            fprintf(output, "JUMPIFEQ %s %s bool@true\n", label, condition);
+        }
+        if (block->succs[1] != next_block) {
+            get_block_label(function, block->succs[1], label, sizeof(label));
+            fprintf(output, "JUMP %s\n", label);
+        }
+        safe_free(condition);
+        break;
+    }
+
+    default:
+        if (terminator->operand_count > 0) {
+            char *value = get_symbol(terminator->operands[0]);
+            fprintf(output, "PUSHS %s\n", value);
+            safe_free(value);
+        }
+        fprintf(output, "POPFRAME\n");
+        fprintf(output, "RETURN\n");
+        break;
+    }
+}
+
+/**
+ * Generates one function
+ */
+static void lowering_generate_function(IrFunction *function, FILE *output) {
+    fprintf(output, "LABEL %s\n", function->name);
+    fprintf(output, "CREATEFRAME\n");
+    fprintf(output, "PUSHFRAME\n");
+
+    const char *scratch[] = {"tmp_type", "tmp_bool", "tmp_int", "tmp_char", "tmp_float", "tmp_float2"};
+    for (size_t i = 0; i < sizeof(scratch) / sizeof(scratch[0]); i++) {
+        fprintf(output, "DEFVAR LF@%%%s\n", scratch[i]);
+    }
+    for (int i = 0; i < function->block_count; i++) {
+        for (IrValue *value = function->blocks[i]->first; value != NULL; value = value->next) {
+            if (has_variable(value)) {
+                fprintf(output, "DEFVAR LF@%%v%d\n", value->id);
+            }
+            if (value->opcode == IR_PHI) {
+                fprintf(output, "DEFVAR LF@%%p%d\n", value->id);
+            }
+        }
+    }
+    for (int i = 0; i < function->param_count; i++) {
+        fprintf(output, "POPS LF@%%v%d\n", function->params[i]->id);
+    }
+
+    for (int i = 0; i < function->block_count; i++) {
+        IrBlock *block = function->blocks[i];
+        IrBlock *next_block = i + 1 < function->block_count ? function->blocks[i + 1] : NULL;
+        char label[SYMBOL_SIZE];
+        if (i > 0) {
+            get_block_label(function, block, label, sizeof(label));
+            fprintf(output, "LABEL %s\n", label);
+        }
+        for (IrValue *value = block->first; value != NULL && value != block->last; value = value->next) {
+            char result[SYMBOL_SIZE];
+            snprintf(result, sizeof(result), "LF@%%v%d", value->id);
+            switch (value->opcode) {
+            case IR_COPY: {
+                char *operand = get_symbol(value->operands[0]);
+                fprintf(output, "MOVE %s %s\n", result, operand);
+                safe_free(operand);
+                break;
+            }
+            case IR_BINARY:
+                lowering_generate_binary(output, value, result);
+                break;
+            case IR_NOT_NULL: {
+                char *operand = get_symbol(value->operands[0]);
+                fprintf(output, "TYPE LF@%%tmp_type %s\n", operand);
+                fprintf(output, "EQ %s LF@%%tmp_type string@nil\n", result);
+                fprintf(output, "NOT %s %s\n", result, result);
+                safe_free(operand);
+                break;
+            }
+            case IR_CALL:
+                lowering_generate_call(output, function, value, result);
+                break;
+            default:
+                // Constants are operands, parameters are popped, phis are moved into
+                break;
+            }
+        }
+        lowering_generate_terminator(output, function, block, next_block);
+    }
+}
+
+/**
+ * Generates IFJcode24 of the program, each SSA value gets a frame variable
+ */
+void lowering_generate_program(IrProgram *program, FILE *output) {
+    fprintf(output, ".IFJcode24\n");
+    fprintf(output, "CALL main\n");
+    fprintf(output, "EXIT int@0\n");
+    for (IrFunction *function = program->functions; function != NULL; function = function->next) {
+        lowering_generate_function(function, output);
+    }
+}
@@ -0,0 +1,22 @@
+/**
+ * @file lowering.h
+ *
+ * Header file for the translation of the SSA IR to IFJcode24.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef LOWERING_H
+#define LOWERING_H
+
+#include <stdio.h>
+#include "ir.h"
+
+// Generates IFJcode24 of the program, each SSA value gets a frame variable
+void lowering_generate_program(IrProgram *program, FILE *output);
+
+#endif // LOWERING_H
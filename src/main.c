@@ -11,69 +11,320 @@
  * @author <xshmon00> Gleb Shmonin
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include "scanner.h"
-#include "parser.h"
+#include <string.h>
+#include <unistd.h>
+#include "compiler.h"
+#include "batch.h"
+#include "cache.h"
 #include "error.h"
-#include "ast.h"
-#include "codegen.h"
-#include "utils.h"
+#include "server.h"
+
+/**
+ * Copies the source into memory: the parser rewinds the source after declaring
+ * the functions, which a pipe cannot do, and the cache hashes it.
+ * Returns a stream reading the copy stored to *buffer, NULL if there is no memory.
+ */
+static FILE *buffer_source(FILE *input, char **buffer, size_t *length) {
+    FILE *copy = open_memstream(buffer, length);
+    if (!copy) {
+        return NULL;
+    }
+    char chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        fwrite(chunk, 1, count, copy);
+    }
+    fclose(copy);
+    return fmemopen(*buffer, *length, "r");
+}
+
+/**
+ * Writes the diagnostics to stderr and, when the program compiled, the code to the output file or stdout
+ */
+static int write_output(const char *output_filename, const CacheEntry *entry) {
+    if (entry->diagnostics_length > 0) {
+        fwrite(entry->diagnostics, 1, entry->diagnostics_length, stderr);
+    }
+    if (entry->result != ERR_OK) {
+        return entry->result;
+    }
+    FILE *output_file = output_filename != NULL ? fopen(output_filename, "w") : stdout;
+    if (!output_file) {
+        fprintf(stderr, "Error: Cannot open output file %s for writing.\n", output_filename);
+        return ERR_INTERNAL;
+    }
+    fwrite(entry->code, 1, entry->code_length, output_file);
+    if (output_file != stdout) {
+        fclose(output_file);
+    }
+    return ERR_OK;
+}
+
+/**
+ * Reads a whole number from min to max, returns false if the argument is not one
+ */
+static bool parse_number(const char *argument, long min, long max, int *number) {
+    char *end = NULL;
+    long value = strtol(argument, &end, 10);
+    if (*argument == '\0' || *end != '\0' || value < min || value > max) {
+        return false;
+    }
+    *number = (int)value;
+    return true;
+}
+
+/**
+ * Returns the number of processors, the default number of worker threads
+ */
+static int processor_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1) {
+        return 1;
+    }
+    return count < SERVER_MAX_WORKERS ? (int)count : SERVER_MAX_WORKERS;
+}
+
+/**
+ * Fills the options of the library (ifj24.c) used by the server and the batch mode.
+ * The passes switched by --enable-pass and --disable-pass are given as NULL-terminated lists,
+ * the disabled ones are applied last.
+ */
+static void fill_library_options(Ifj24Options *library_options, OptimizationLevel level, int inline_threshold,
+                                 CompilerOptions options, const char **enabled_passes, const char **disabled_passes) {
+    static const Ifj24OptLevel library_levels[] = {
+        [OPT_LEVEL_0] = IFJ24_OPT_0, [OPT_LEVEL_1] = IFJ24_OPT_1, [OPT_LEVEL_2] = IFJ24_OPT_2, [OPT_LEVEL_SIZE] = IFJ24_OPT_SIZE
+    };
+    ifj24_default_options(library_options);
+    library_options->level = library_levels[level];
+    library_options->inline_threshold = inline_threshold;
+    library_options->ir_codegen = options.ir_codegen;
+    library_options->dump_callgraph = options.dump_callgraph;
+    library_options->dump_ir = options.dump_ir;
+    library_options->time_passes = options.time_passes;
+    library_options->enable_passes = enabled_passes;
+    library_options->disable_passes = disabled_passes;
+}
 
 /**
  * Main function of the compiler project.
- * Initializes scanner, parser, and code generator.
+ * Reads the options into a compiler context and compiles the source file.
  */
 int main(int argc, char *argv[]) {
-    FILE *source_file = stdin; // Default source file is standard input
+    FILE *source_file = NULL; // Default source file is standard input
+    char *source_buffer = NULL; // Copy of the standard input
+    const char *source_filename = NULL; // Default source filename is NULL
     const char *output_filename = NULL; // Default output filename is NULL
+    OptimizationLevel level = DEFAULT_OPT_LEVEL; // Passes enabled before --enable-pass/--disable-pass
+    int inline_threshold = DEFAULT_INLINE_THRESHOLD;
+    CompilerOptions options = {false, false, false, false, 0};
+    const char *server_path = NULL; // Socket of the compile server, NULL to compile one file
+    bool batch = false; // Compile all positional arguments into output_directory
+    const char *output_directory = "."; // Output directory of the batch mode
+    int workers = processor_count();
+    const char *sources[argc]; // Positional arguments
+    int source_count = 0;
+    const char *enabled_passes[argc]; // Passes switched for the server and the batch mode, NULL-terminated
+    const char *disabled_passes[argc];
+    int enabled_count = 0;
+    int disabled_count = 0;
+    Cache cache = {NULL, (size_t)CACHE_DEFAULT_SIZE_MB << 20, cache_entry_mode()}; // Directory of --cache, NULL without a cache
+    bool cache_statistics = false;
 
-    // Check the number of arguments passed to the program
-    if (argc > 3) {
-        fprintf(stderr, "Usage: %s [source_file] [output_file]\n", argv[0]);
+    // Process options and positional arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump-callgraph") == 0) {
+            options.dump_callgraph = true;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            options.dump_ir = true;
+        } else if (strcmp(argv[i], "--ir-codegen") == 0) {
+            options.ir_codegen = true;
+        } else if (strcmp(argv[i], "--time-passes") == 0) {
+            options.time_passes = true;
+        } else if (strcmp(argv[i], "--list-passes") == 0) {
+            passes_print_list(stdout);
+            return ERR_OK;
+        } else if (passes_parse_level(argv[i], &level)) {
+            // Applied once all options are read
+        } else if (strcmp(argv[i], "--enable-pass") == 0 && i + 1 < argc) {
+            // Applied in order after the optimization level
+            enabled_passes[enabled_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--disable-pass") == 0 && i + 1 < argc) {
+            disabled_passes[disabled_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--inline-threshold") == 0 && i + 1 < argc) {
+            if (!parse_number(argv[++i], 0, 100000, &inline_threshold)) {
+                fprintf(stderr, "Invalid inline threshold: %s\n", argv[i]);
+                return ERR_INTERNAL;
+            }
+        } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            server_path = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache.directory = argv[++i];
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            int megabytes;
+            if (!parse_number(argv[++i], 1, 1048576, &megabytes)) {
+                fprintf(stderr, "Invalid cache size: %s\n", argv[i]);
+                return ERR_INTERNAL;
+            }
+            cache.max_size = (size_t)megabytes << 20;
+        } else if (strcmp(argv[i], "--cache-stats") == 0) {
+            cache_statistics = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_directory = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            if (!parse_number(argv[++i], 1, SERVER_MAX_WORKERS, &workers)) {
+                fprintf(stderr, "Invalid number of workers: %s\n", argv[i]);
+                return ERR_INTERNAL;
+            }
+            options.codegen_threads = workers; // Compiling one file, the functions are generated in parallel
+        } else {
+            sources[source_count++] = argv[i];
+        }
+    }
+    enabled_passes[enabled_count] = NULL;
+    disabled_passes[disabled_count] = NULL;
+    if (source_count > 2 && !batch) {
+        fprintf(stderr, "Usage: %s [-O0|-O1|-O2|-Os] [--enable-pass NAME] [--disable-pass NAME] [--list-passes] "
+                        "[--time-passes] [--dump-callgraph] [--dump-ir] [--ir-codegen] [--inline-threshold N] "
+                        "[--cache directory] [--cache-size MB] [--cache-stats] [-j N] [source_file] [output_file] | "
+                        "[--server socket] [-j N] | [--batch] [-j N] [-o directory] source_file...\n", argv[0]);
         return ERR_INTERNAL;
     }
-    // If a source file is specified, open it
-    if (argc > 1) {
-        source_file = fopen(argv[1], "r");
-        if (!source_file) {
-            fprintf(stderr, "Error opening file: %s\n", argv[1]);
+    if (cache_statistics) {
+        if (cache.directory == NULL) {
+            fprintf(stderr, "--cache-stats needs --cache DIRECTORY\n");
             return ERR_INTERNAL;
         }
+        cache_print_statistics(&cache, stdout);
+        return ERR_OK;
     }
+    source_filename = source_count > 0 ? sources[0] : NULL;
+    output_filename = source_count > 1 ? sources[1] : NULL;
 
-    // If an output file is specified, set the output filename
-    if (argc > 2) {
-        output_filename = argv[2];
+    // Create the context holding all state of the compilation (compiler.c)
+    CompilerContext *context = compiler_context_create();
+    if (!context) {
+        fprintf(stderr, "Failed to allocate the compiler context\n");
+        return ERR_INTERNAL;
     }
+    context->options = options;
+    context->codegen.inline_threshold = inline_threshold;
 
-    // Initialize memory management for pointers (utils.c)
-    init_pointers_storage(5);
-
-    // Initialize scanner (scanner.c)
-    Scanner scanner;
-    scanner_init(source_file, &scanner);
-
-    // Initialize parser (parser.c)
-    parser_init(&scanner);
+    // Select the passes: the level first, then the single passes in the order given
+    passes_set_level(context, level);
+    for (int i = 1; i + 1 < argc; i++) {
+        bool enable = strcmp(argv[i], "--enable-pass") == 0;
+        if (enable || strcmp(argv[i], "--disable-pass") == 0) {
+            if (!passes_set_enabled(context, argv[++i], enable)) {
+                fprintf(stderr, "Unknown pass: %s (see --list-passes)\n", argv[i]);
+                compiler_context_destroy(context);
+                return ERR_INTERNAL;
+            }
+        }
+    }
 
-    // Parse the source file and generate an abstract syntax tree (AST) (ast.c)
-    ASTNode* ast_root = parse_program(&scanner);
+    // Serve the compilations of clients or compile many files instead of one (server.c, batch.c)
+    if (server_path != NULL || batch) {
+        compiler_context_destroy(context);
+        Ifj24Options library_options;
+        fill_library_options(&library_options, level, inline_threshold, options, enabled_passes, disabled_passes);
+        if (server_path != NULL) {
+            return server_run(server_path, workers, &library_options);
+        }
+        return batch_run(sources, source_count, output_directory, workers, &library_options);
+    }
 
-    // Initialize code generator (codegen.c)
-    codegen_init(output_filename);
+    // If a source file is specified, read it, otherwise read the standard input
+    FILE *input_file = stdin;
+    if (source_filename != NULL) {
+        input_file = fopen(source_filename, "r");
+        if (!input_file) {
+            fprintf(stderr, "Error opening file: %s\n", source_filename);
+            compiler_context_destroy(context);
+            return ERR_INTERNAL;
+        }
+    }
+    size_t source_length = 0;
+    source_file = buffer_source(input_file, &source_buffer, &source_length);
+    if (input_file != stdin) {
+        fclose(input_file);
+    }
+    if (!source_file) {
+        fprintf(stderr, "Failed to read the source\n");
+        free(source_buffer);
+        compiler_context_destroy(context);
+        return ERR_INTERNAL;
+    }
 
-    // Generate code from the AST (codegen.c)
-    codegen_generate_program(ast_root);
+    // A program compiled before with the same options is answered from the cache (cache.c),
+    // the dumps and timing describe a compilation and always compile
+    CacheEntry entry = {ERR_OK, NULL, 0, NULL, 0};
+    char key[CACHE_KEY_LENGTH + 1];
+    bool cached = cache.directory != NULL && !options.dump_callgraph && !options.dump_ir && !options.time_passes;
+    if (cached) {
+        cache_key(context, source_buffer, source_length, key);
+        if (cache_lookup(&cache, key, &entry)) {
+            fclose(source_file);
+            free(source_buffer);
+            compiler_context_destroy(context);
+            int result = write_output(output_filename, &entry);
+            cache_free_entry(&entry);
+            return result;
+        }
+    }
 
-    // Finalize code generation (codegen.c)
-    codegen_finalize();
+    // Scan, parse, optimize and generate the code into memory (compiler.c),
+    // the diagnostics are kept for the cache
+    FILE *code_stream = open_memstream(&entry.code, &entry.code_length);
+    FILE *diagnostics_stream = cached ? open_memstream(&entry.diagnostics, &entry.diagnostics_length) : NULL;
+    if (!code_stream || (cached && !diagnostics_stream)) {
+        fprintf(stderr, "Failed to allocate the output buffer\n");
+        if (code_stream) {
+            fclose(code_stream);
+        }
+        if (diagnostics_stream) {
+            fclose(diagnostics_stream);
+        }
+        cache_free_entry(&entry);
+        fclose(source_file);
+        free(source_buffer);
+        compiler_context_destroy(context);
+        return ERR_INTERNAL;
+    }
+    if (diagnostics_stream) {
+        context->diagnostics = diagnostics_stream;
+    }
+    if (cached) {
+        // Functions not changed since an earlier compilation are not generated again (codegen.c)
+        context->function_cache = &cache;
+    }
+    entry.result = compiler_compile(context, source_file, code_stream);
+    fclose(code_stream);
+    if (diagnostics_stream) {
+        fclose(diagnostics_stream);
+    }
 
     // Close the source file
     fclose(source_file);
+    free(source_buffer);
+
+    // Free all memory of the compilation (compiler.c)
+    compiler_context_destroy(context);
+
+    // Internal errors such as running out of memory are not results of the program
+    if (cached && entry.result != ERR_INTERNAL) {
+        cache_store(&cache, key, &entry);
+    }
 
-    // Cleanup memory used for pointers (utils.c)
-    cleanup_pointers_storage();
+    // The output file is written only when the program compiled
+    int result = write_output(output_filename, &entry);
+    cache_free_entry(&entry);
 
-    return ERR_OK;  // Return success status
+    return result;
 }
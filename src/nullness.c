@@ -0,0 +1,396 @@
+/**
+ * @file nullness.c
+ *
+ * Implementation of the flow-sensitive null analysis.
+ * A variable is known not to be null after it gets a value of a non-nullable
+ * expression and inside the true branch of if (x) |v| or the body of while (x) |v|,
+ * it is known to be null after a null literal, in the else branch and after the loop.
+ * Variables assigned in a loop are unknown at its entry.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "nullness.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Finds the facts about a variable
+ */
+static NullnessVariable *find_variable(NullnessVariable *env, const char *name)
+{
+    for (; env != NULL; env = env->next)
+    {
+        if (strcmp(env->name, name) == 0)
+        {
+            return env;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns the state of a variable, unknown if there are no facts about it
+ */
+static Nullness get_state(NullnessVariable *env, const char *name)
+{
+    NullnessVariable *variable = find_variable(env, name);
+    return variable != NULL ? variable->state : NULLNESS_UNKNOWN;
+}
+
+/**
+ * Sets the state of a variable
+ */
+static void set_state(NullnessVariable **env, const char *name, Nullness state)
+{
+    NullnessVariable *variable = find_variable(*env, name);
+    if (variable == NULL)
+    {
+        variable = (NullnessVariable *)safe_malloc(sizeof(NullnessVariable));
+        variable->name = name;
+        variable->next = *env;
+        *env = variable;
+    }
+    variable->state = state;
+}
+
+/**
+ * Copies the facts for a branch of the program
+ */
+static NullnessVariable *copy_env(NullnessVariable *env)
+{
+    NullnessVariable *copy = NULL;
+    for (; env != NULL; env = env->next)
+    {
+        set_state(&copy, env->name, env->state);
+    }
+    return copy;
+}
+
+/**
+ * Frees the facts of a branch
+ */
+static void free_env(NullnessVariable *env)
+{
+    while (env != NULL)
+    {
+        NullnessVariable *next = env->next;
+        safe_free(env);
+        env = next;
+    }
+}
+
+/**
+ * Facts holding after either of two branches
+ */
+static NullnessVariable *join_envs(NullnessVariable *a, NullnessVariable *b)
+{
+    NullnessVariable *joined = NULL;
+    for (; a != NULL; a = a->next)
+    {
+        if (a->state != NULLNESS_UNKNOWN && get_state(b, a->name) == a->state)
+        {
+            set_state(&joined, a->name, a->state);
+        }
+    }
+    return joined;
+}
+
+/**
+ * Records the state of a nullable variable read by an identifier node
+ */
+static void record_read(NullnessInfo *info, ASTNode *node, Nullness state)
+{
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->nodes[i] == node)
+        {
+            info->states[i] = state;
+            return;
+        }
+    }
+    if (info->count == info->capacity)
+    {
+        info->capacity = info->capacity == 0 ? 8 : info->capacity * 2;
+        ASTNode **nodes = (ASTNode **)safe_malloc(sizeof(ASTNode *) * info->capacity);
+        Nullness *states = (Nullness *)safe_malloc(sizeof(Nullness) * info->capacity);
+        for (int i = 0; i < info->count; i++)
+        {
+            nodes[i] = info->nodes[i];
+            states[i] = info->states[i];
+        }
+        if (info->nodes != NULL)
+        {
+            safe_free(info->nodes);
+            safe_free(info->states);
+        }
+        info->nodes = nodes;
+        info->states = states;
+    }
+    info->nodes[info->count] = node;
+    info->states[info->count] = state;
+    info->count++;
+}
+
+/**
+ * Records the states of nullable variables read in an expression
+ */
+static void record_reads(ASTNode *node, NullnessVariable *env, NullnessInfo *info)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    switch (node->type)
+    {
+    case NODE_IDENTIFIER:
+        if (is_nullable(node->data_type))
+        {
+            record_read(info, node, get_state(env, node->name));
+        }
+        break;
+
+    case NODE_BINARY_OPERATION:
+        record_reads(node->left, env, info);
+        record_reads(node->right, env, info);
+        break;
+
+    case NODE_FUNCTION_CALL:
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            record_reads(node->arguments[i], env, info);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Finds if the value of an expression can be null
+ */
+static Nullness get_expression_nullness(ASTNode *node, NullnessVariable *env)
+{
+    if (node == NULL)
+    {
+        return NULLNESS_UNKNOWN;
+    }
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+        return node->data_type == TYPE_NULL ? NULLNESS_NULL : NULLNESS_NON_NULL;
+
+    case NODE_IDENTIFIER:
+        // The value bound by |id| is the value of the variable itself,
+        // reading a nullable variable elsewhere gives whether it is not null
+        return node->data_type == TYPE_UNKNOWN ? get_state(env, node->name) : NULLNESS_NON_NULL;
+
+    case NODE_FUNCTION_CALL:
+        return is_nullable(node->data_type) || node->data_type == TYPE_NULL ? NULLNESS_UNKNOWN : NULLNESS_NON_NULL;
+
+    default:
+        return NULLNESS_NON_NULL;
+    }
+}
+
+/**
+ * Checks if a condition is a nullable variable binding its value with |id|
+ */
+static bool is_null_check(ASTNode *condition)
+{
+    return condition->type == NODE_IDENTIFIER && is_nullable(condition->data_type);
+}
+
+/**
+ * Checks if a variable gets a new value in a list of statements
+ */
+static bool is_assigned(ASTNode *statement, const char *name)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            if (strcmp(statement->name, name) == 0)
+            {
+                return true;
+            }
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (statement->left != NULL && strcmp(statement->left->name, name) == 0)
+            {
+                return true;
+            }
+            break;
+
+        case NODE_IF:
+            if (is_assigned(statement->body->body, name) ||
+                (statement->left != NULL && is_assigned(statement->left->body, name)))
+            {
+                return true;
+            }
+            break;
+
+        case NODE_WHILE:
+            if (is_assigned(statement->body->body, name))
+            {
+                return true;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Analyzes a list of statements, updating the facts in order
+ */
+static void analyze_statements(ASTNode *statement, NullnessVariable **env, NullnessInfo *info)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            record_reads(statement->left, *env, info);
+            set_state(env, statement->name, get_expression_nullness(statement->left, *env));
+            break;
+
+        case NODE_FUNCTION_CALL:
+            record_reads(statement, *env, info);
+            if (statement->left != NULL)
+            {
+                set_state(env, statement->left->name, get_expression_nullness(statement, *env));
+            }
+            break;
+
+        case NODE_RETURN:
+            record_reads(statement->left, *env, info);
+            break;
+
+        case NODE_IF:
+        {
+            record_reads(statement->condition, *env, info);
+            NullnessVariable *then_env = copy_env(*env);
+            NullnessVariable *else_env = copy_env(*env);
+            if (is_null_check(statement->condition))
+            {
+                set_state(&then_env, statement->condition->name, NULLNESS_NON_NULL);
+                set_state(&else_env, statement->condition->name, NULLNESS_NULL);
+            }
+            analyze_statements(statement->body->body, &then_env, info);
+            if (statement->left != NULL)
+            {
+                analyze_statements(statement->left->body, &else_env, info);
+            }
+
+            // A branch that returns does not reach the next statement
+            bool then_returns = block_terminates(statement->body);
+            bool else_returns = statement->left != NULL && block_terminates(statement->left);
+            free_env(*env);
+            if (then_returns && !else_returns)
+            {
+                *env = else_env;
+                free_env(then_env);
+            }
+            else if (else_returns && !then_returns)
+            {
+                *env = then_env;
+                free_env(else_env);
+            }
+            else
+            {
+                *env = join_envs(then_env, else_env);
+                free_env(then_env);
+                free_env(else_env);
+            }
+            break;
+        }
+
+        case NODE_WHILE:
+        {
+            for (NullnessVariable *variable = *env; variable != NULL; variable = variable->next)
+            {
+                if (is_assigned(statement->body->body, variable->name))
+                {
+                    variable->state = NULLNESS_UNKNOWN;
+                }
+            }
+            record_reads(statement->condition, *env, info);
+            NullnessVariable *body_env = copy_env(*env);
+            if (is_null_check(statement->condition))
+            {
+                set_state(&body_env, statement->condition->name, NULLNESS_NON_NULL);
+                // The loop only ends when the variable is null
+                set_state(env, statement->condition->name, NULLNESS_NULL);
+            }
+            analyze_statements(statement->body->body, &body_env, info);
+            free_env(body_env);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Analyzes all functions of the program, parameters may be null
+ */
+NullnessInfo *nullness_analyze(ASTNode *program_node)
+{
+    NullnessInfo *info = (NullnessInfo *)safe_malloc(sizeof(NullnessInfo));
+    info->nodes = NULL;
+    info->states = NULL;
+    info->count = 0;
+    info->capacity = 0;
+    if (program_node == NULL)
+    {
+        return info;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            NullnessVariable *env = NULL;
+            analyze_statements(function->body->body, &env, info);
+            free_env(env);
+        }
+    }
+    return info;
+}
+
+/**
+ * Returns the known state of a nullable variable read by an identifier node
+ */
+Nullness nullness_of(NullnessInfo *info, ASTNode *node)
+{
+    if (info == NULL)
+    {
+        return NULLNESS_UNKNOWN;
+    }
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->nodes[i] == node)
+        {
+            return info->states[i];
+        }
+    }
+    return NULLNESS_UNKNOWN;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file nullness.h
+ *
+ * Header file for the flow-sensitive null analysis.
+ * Finds reads and |id| conditions of nullable variables whose value is
+ * known to be null or not null, so the generated code can skip the TYPE checks.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef NULLNESS_H
+#define NULLNESS_H
+
+#include "ast.h"
+
+/**
+ * What is known about a nullable value
+ */
+typedef enum {
+    NULLNESS_UNKNOWN,
+    NULLNESS_NON_NULL,
+    NULLNESS_NULL
+} Nullness;
+
+/**
+ * Facts about a variable at a point of a function body
+ */
+typedef struct NullnessVariable {
+    const char *name;
+    Nullness state;
+    struct NullnessVariable *next;
+} NullnessVariable;
+
+/**
+ * Identifier nodes reading a nullable variable with a known state
+ */
+typedef struct {
+    ASTNode **nodes;
+    Nullness *states;
+    int count;
+    int capacity;
+} NullnessInfo;
+
+// Analyzes all functions of the program
+NullnessInfo *nullness_analyze(ASTNode *program_node);
+
+// Returns the known state of a nullable variable read by an identifier node
+Nullness nullness_of(NullnessInfo *info, ASTNode *node);
+
+#endif // NULLNESS_H
@@ -0,0 +1,1673 @@
+/**
+ * @file optimizer.c
+ *
+ * Implementation of the AST optimization passes.
+ * Passes run after the semantic checks, so they only have to keep
+ * the behaviour of the generated program.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "optimizer.h"
+#include "compiler.h"
+#include "utils.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ASTNode *eliminate_dead_statements(ASTNode *statements);
+
+/** Maximal number of distinct factors of one induction variable considered for strength reduction */
+#define MAX_INDUCTION_FACTORS 8
+
+/**
+ * State of rewriting products i * k of an induction variable
+ */
+typedef struct {
+    const char *name;                       // Induction variable
+    long long factors[MAX_INDUCTION_FACTORS]; // Distinct factors found in collect mode
+    int factor_count;
+    bool collect;                           // Only gather factors
+    long long factor;                       // Factor of the products being rewritten
+    ASTNode *derived;                       // Replacement variable, NULL to only count products
+    int count;                              // Number of products with the factor
+} InductionRewrite;
+
+/**
+ * Adds two integers, fails on overflow
+ */
+static bool checked_add(long long a, long long b, long long *result)
+{
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b))
+    {
+        return false;
+    }
+    *result = a + b;
+    return true;
+}
+
+/**
+ * Subtracts two integers, fails on overflow
+ */
+static bool checked_sub(long long a, long long b, long long *result)
+{
+    if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b))
+    {
+        return false;
+    }
+    *result = a - b;
+    return true;
+}
+
+/**
+ * Multiplies two integers, fails on overflow
+ */
+static bool checked_mul(long long a, long long b, long long *result)
+{
+    if (a == 0 || b == 0)
+    {
+        *result = 0;
+        return true;
+    }
+    if ((a == -1 && b == LLONG_MIN) || (b == -1 && a == LLONG_MIN))
+    {
+        return false;
+    }
+    long long product = a * b;
+    if (product / b != a)
+    {
+        return false;
+    }
+    *result = product;
+    return true;
+}
+
+/**
+ * Compares two numbers with a relational operator
+ */
+static bool compare_values(const char *operator_name, double left, double right, bool *result)
+{
+    if (strcmp(operator_name, "<") == 0)
+        *result = left < right;
+    else if (strcmp(operator_name, "<=") == 0)
+        *result = left <= right;
+    else if (strcmp(operator_name, ">") == 0)
+        *result = left > right;
+    else if (strcmp(operator_name, ">=") == 0)
+        *result = left >= right;
+    else if (strcmp(operator_name, "==") == 0)
+        *result = left == right;
+    else if (strcmp(operator_name, "!=") == 0)
+        *result = left != right;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Compares two integers with a relational operator
+ */
+static bool compare_int_values(const char *operator_name, long long left, long long right, bool *result)
+{
+    if (strcmp(operator_name, "<") == 0)
+        *result = left < right;
+    else if (strcmp(operator_name, "<=") == 0)
+        *result = left <= right;
+    else if (strcmp(operator_name, ">") == 0)
+        *result = left > right;
+    else if (strcmp(operator_name, ">=") == 0)
+        *result = left >= right;
+    else if (strcmp(operator_name, "==") == 0)
+        *result = left == right;
+    else if (strcmp(operator_name, "!=") == 0)
+        *result = left != right;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Stores a string made of length bytes of value into a constant
+ */
+static void set_string_value(ConstantValue *result, const char *value, size_t length)
+{
+    result->type = TYPE_U8;
+    result->string_value = safe_malloc(length + 1);
+    memcpy(result->string_value, value, length);
+    result->string_value[length] = '\0';
+}
+
+/**
+ * Evaluates a call of a built-in function with constant arguments.
+ * Follows the generated code: chr takes its argument modulo 256, ord of an index
+ * out of range is 0 and substring out of range is null. Calls whose result cannot be
+ * a literal (chr of a zero byte) or that fail at runtime (f2i out of range) are kept.
+ */
+static bool evaluate_constant_builtin(ASTNode *call, ConstantValue *result)
+{
+    ConstantValue args[3];
+    if (call->arg_count < 1 || call->arg_count > 3)
+    {
+        return false;
+    }
+    for (int i = 0; i < call->arg_count; i++)
+    {
+        if (!evaluate_constant_expression(call->arguments[i], &args[i]))
+        {
+            return false;
+        }
+    }
+
+    const char *name = call->name;
+    if (strcmp(name, "ifj.string") == 0 && args[0].type == TYPE_U8)
+    {
+        *result = args[0];
+        return true;
+    }
+    if (strcmp(name, "ifj.length") == 0 && args[0].type == TYPE_U8)
+    {
+        result->type = TYPE_INT;
+        result->int_value = (long long)strlen(args[0].string_value);
+        return true;
+    }
+    if (strcmp(name, "ifj.concat") == 0 && args[0].type == TYPE_U8 && args[1].type == TYPE_U8)
+    {
+        size_t first_length = strlen(args[0].string_value);
+        size_t second_length = strlen(args[1].string_value);
+        result->type = TYPE_U8;
+        result->string_value = safe_malloc(first_length + second_length + 1);
+        memcpy(result->string_value, args[0].string_value, first_length);
+        memcpy(result->string_value + first_length, args[1].string_value, second_length + 1);
+        return true;
+    }
+    if (strcmp(name, "ifj.i2f") == 0 && args[0].type == TYPE_INT)
+    {
+        result->type = TYPE_FLOAT;
+        result->float_value = (double)args[0].int_value;
+        return true;
+    }
+    if (strcmp(name, "ifj.f2i") == 0 && args[0].type == TYPE_FLOAT &&
+        args[0].float_value > -9.2e18 && args[0].float_value < 9.2e18)
+    {
+        result->type = TYPE_INT;
+        result->int_value = (long long)args[0].float_value;
+        return true;
+    }
+    if (strcmp(name, "ifj.chr") == 0 && args[0].type == TYPE_INT)
+    {
+        // Negative arguments stay negative after the modulo and fail at runtime
+        char code = (char)(args[0].int_value % 256);
+        if (args[0].int_value < 0 || code == '\0')
+        {
+            return false;
+        }
+        set_string_value(result, &code, 1);
+        return true;
+    }
+    if (strcmp(name, "ifj.ord") == 0 && args[0].type == TYPE_U8 && args[1].type == TYPE_INT)
+    {
+        long long length = (long long)strlen(args[0].string_value);
+        result->type = TYPE_INT;
+        result->int_value = 0;
+        if (args[1].int_value >= 0 && args[1].int_value < length)
+        {
+            result->int_value = (unsigned char)args[0].string_value[args[1].int_value];
+        }
+        return true;
+    }
+    if (strcmp(name, "ifj.strcmp") == 0 && args[0].type == TYPE_U8 && args[1].type == TYPE_U8)
+    {
+        int order = strcmp(args[0].string_value, args[1].string_value);
+        result->type = TYPE_INT;
+        result->int_value = order < 0 ? -1 : order > 0 ? 1 : 0;
+        return true;
+    }
+    if (strcmp(name, "ifj.substring") == 0 && args[0].type == TYPE_U8 &&
+        args[1].type == TYPE_INT && args[2].type == TYPE_INT)
+    {
+        long long length = (long long)strlen(args[0].string_value);
+        long long start = args[1].int_value;
+        long long end = args[2].int_value;
+        if (start < 0 || end < 0 || start > end || start >= length || end > length)
+        {
+            result->type = TYPE_NULL;
+            return true;
+        }
+        set_string_value(result, args[0].string_value + start, (size_t)(end - start));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Evaluates an expression built only from literals and calls of built-in functions.
+ * Returns false if the value depends on runtime or would fail at runtime
+ * (overflow, division by zero), the expression is then kept untouched.
+ */
+bool evaluate_constant_expression(ASTNode *node, ConstantValue *result)
+{
+    if (node == NULL)
+    {
+        return false;
+    }
+
+    if (node->type == NODE_LITERAL)
+    {
+        if (node->data_type == TYPE_INT)
+        {
+            char *end = NULL;
+            result->type = TYPE_INT;
+            result->int_value = strtoll(node->value, &end, 10);
+            return end != node->value && *end == '\0';
+        }
+        if (node->data_type == TYPE_FLOAT)
+        {
+            result->type = TYPE_FLOAT;
+            result->float_value = atof(node->value);
+            return true;
+        }
+        if (node->data_type == TYPE_U8)
+        {
+            result->type = TYPE_U8;
+            result->string_value = node->value;
+            return true;
+        }
+        if (node->data_type == TYPE_NULL)
+        {
+            result->type = TYPE_NULL;
+            return true;
+        }
+        return false;
+    }
+
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        return evaluate_constant_builtin(node, result);
+    }
+
+    if (node->type != NODE_BINARY_OPERATION)
+    {
+        return false;
+    }
+
+    ConstantValue left, right;
+    if (!evaluate_constant_expression(node->left, &left) || !evaluate_constant_expression(node->right, &right))
+    {
+        return false;
+    }
+    if (left.type != right.type || (left.type != TYPE_INT && left.type != TYPE_FLOAT))
+    {
+        return false;
+    }
+
+    const char *op = node->name;
+    if (left.type == TYPE_INT)
+    {
+        result->type = TYPE_INT;
+        if (strcmp(op, "+") == 0)
+            return checked_add(left.int_value, right.int_value, &result->int_value);
+        if (strcmp(op, "-") == 0)
+            return checked_sub(left.int_value, right.int_value, &result->int_value);
+        if (strcmp(op, "*") == 0)
+            return checked_mul(left.int_value, right.int_value, &result->int_value);
+        if (strcmp(op, "/") == 0)
+        {
+            // Rounding of negative operands is left to the interpreter
+            if (right.int_value <= 0 || left.int_value < 0)
+            {
+                return false;
+            }
+            result->int_value = left.int_value / right.int_value;
+            return true;
+        }
+        result->type = TYPE_BOOL;
+        return compare_int_values(op, left.int_value, right.int_value, &result->bool_value);
+    }
+
+    result->type = TYPE_FLOAT;
+    if (strcmp(op, "+") == 0)
+        result->float_value = left.float_value + right.float_value;
+    else if (strcmp(op, "-") == 0)
+        result->float_value = left.float_value - right.float_value;
+    else if (strcmp(op, "*") == 0)
+        result->float_value = left.float_value * right.float_value;
+    else if (strcmp(op, "/") == 0)
+    {
+        if (right.float_value == 0.0)
+        {
+            return false;
+        }
+        result->float_value = left.float_value / right.float_value;
+    }
+    else
+    {
+        result->type = TYPE_BOOL;
+        return compare_values(op, left.float_value, right.float_value, &result->bool_value);
+    }
+    return true;
+}
+
+/**
+ * Evaluates a condition of if/while statement at compile time.
+ * Nullable conditions (if (x) |val|) are never constant.
+ */
+bool evaluate_constant_condition(ASTNode *condition, bool *result)
+{
+    ConstantValue value;
+    if (!evaluate_constant_expression(condition, &value) || value.type != TYPE_BOOL)
+    {
+        return false;
+    }
+    *result = value.bool_value;
+    return true;
+}
+
+/**
+ * Checks if a block never falls through its end
+ */
+bool block_terminates(ASTNode *block_node)
+{
+    if (block_node == NULL)
+    {
+        return false;
+    }
+    for (ASTNode *statement = block_node->body; statement != NULL; statement = statement->next)
+    {
+        if (statement_terminates(statement))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if control never continues after a statement.
+ * That is a return, an if with both branches terminating,
+ * or a loop with a constant true condition (there is no break statement).
+ */
+bool statement_terminates(ASTNode *statement)
+{
+    if (statement == NULL)
+    {
+        return false;
+    }
+
+    switch (statement->type)
+    {
+    case NODE_RETURN:
+        return true;
+
+    case NODE_IF:
+        return statement->left != NULL && block_terminates(statement->body) && block_terminates(statement->left);
+
+    case NODE_WHILE:
+    {
+        bool condition_value;
+        return evaluate_constant_condition(statement->condition, &condition_value) && condition_value;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Appends a statement list to the end of the list being built
+ */
+static void append_statements(ASTNode **head, ASTNode **tail, ASTNode *statements)
+{
+    if (statements == NULL)
+    {
+        return;
+    }
+    if (*head == NULL)
+    {
+        *head = statements;
+    }
+    else
+    {
+        (*tail)->next = statements;
+    }
+    *tail = statements;
+    while ((*tail)->next != NULL)
+    {
+        *tail = (*tail)->next;
+    }
+}
+
+/**
+ * Removes dead code from a list of statements and returns the new list.
+ * Constant branches are replaced by the statements of the taken block,
+ * this is safe as variable names are already unique per scope.
+ */
+static ASTNode *eliminate_dead_statements(ASTNode *statements)
+{
+    ASTNode *head = NULL;
+    ASTNode *tail = NULL;
+    ASTNode *current = statements;
+
+    while (current != NULL)
+    {
+        ASTNode *next = current->next;
+        current->next = NULL;
+        bool condition_value;
+
+        if (current->type == NODE_IF)
+        {
+            current->body->body = eliminate_dead_statements(current->body->body);
+            if (current->left != NULL)
+            {
+                current->left->body = eliminate_dead_statements(current->left->body);
+            }
+
+            if (evaluate_constant_condition(current->condition, &condition_value))
+            {
+                ASTNode *taken = condition_value ? current->body : current->left;
+                append_statements(&head, &tail, taken != NULL ? taken->body : NULL);
+            }
+            else
+            {
+                append_statements(&head, &tail, current);
+            }
+        }
+        else if (current->type == NODE_WHILE)
+        {
+            if (evaluate_constant_condition(current->condition, &condition_value) && !condition_value)
+            {
+                // while (false) never executes its body
+            }
+            else
+            {
+                current->body->body = eliminate_dead_statements(current->body->body);
+                append_statements(&head, &tail, current);
+            }
+        }
+        else
+        {
+            append_statements(&head, &tail, current);
+        }
+
+        // Everything after a terminating statement is unreachable
+        if (tail != NULL && statement_terminates(tail))
+        {
+            break;
+        }
+        current = next;
+    }
+
+    return head;
+}
+
+/**
+ * Dead code elimination over all functions of the program
+ */
+void optimize_dead_code(ASTNode *program_node)
+{
+    if (program_node == NULL || program_node->type != NODE_PROGRAM)
+    {
+        return;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            function->body->body = eliminate_dead_statements(function->body->body);
+        }
+    }
+}
+
+/**
+ * Checks if a node is a numeric literal with the given value
+ */
+static bool is_literal_value(ASTNode *node, DataType type, double value)
+{
+    return node->type == NODE_LITERAL && node->data_type == type && atof(node->value) == value;
+}
+
+/**
+ * Checks if evaluating an expression may call a user function or do input/output
+ */
+static bool has_calls(ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return false;
+    }
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        return true;
+    }
+    return has_calls(node->left) || has_calls(node->right);
+}
+
+/**
+ * Checks if a node is a non-nullable variable of a numeric type
+ */
+static bool is_numeric_variable(ASTNode *node)
+{
+    return node->type == NODE_IDENTIFIER && (node->data_type == TYPE_INT || node->data_type == TYPE_FLOAT) &&
+           strcmp(node->name, "true") != 0 && strcmp(node->name, "false") != 0;
+}
+
+/**
+ * Creates an integer literal node
+ */
+static ASTNode *create_int_literal(long long value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%lld", value);
+    ASTNode *literal = create_literal_node(TYPE_INT, buffer);
+    return literal;
+}
+
+/**
+ * Creates a copy of an identifier node
+ */
+static ASTNode *copy_identifier(ASTNode *identifier)
+{
+    ASTNode *copy = create_identifier_node(identifier->name);
+    copy->data_type = identifier->data_type;
+    return copy;
+}
+
+/**
+ * Rewrites a binary operation on simplified operands into a cheaper equivalent one.
+ * Float rules keep IEEE semantics (x + 0.0 and x * 0.0 are not simplified because of -0.0, NaN and infinities).
+ */
+static ASTNode *simplify_binary_operation(ASTNode *node)
+{
+    ASTNode *left = node->left;
+    ASTNode *right = node->right;
+    const char *op = node->name;
+    DataType type = left->data_type;
+
+    if (type != right->data_type || (type != TYPE_INT && type != TYPE_FLOAT))
+    {
+        return node;
+    }
+
+    if (type == TYPE_INT && node->data_type == TYPE_INT)
+    {
+        if (strcmp(op, "+") == 0 && is_literal_value(right, TYPE_INT, 0))
+            return left;
+        if (strcmp(op, "+") == 0 && is_literal_value(left, TYPE_INT, 0))
+            return right;
+        if (strcmp(op, "-") == 0 && is_literal_value(right, TYPE_INT, 0))
+            return left;
+        if (strcmp(op, "-") == 0 && is_numeric_variable(left) && is_numeric_variable(right) &&
+            strcmp(left->name, right->name) == 0)
+            return create_int_literal(0);
+        if ((strcmp(op, "*") == 0 || strcmp(op, "/") == 0) && is_literal_value(right, TYPE_INT, 1))
+            return left;
+        if (strcmp(op, "*") == 0 && is_literal_value(left, TYPE_INT, 1))
+            return right;
+        if (strcmp(op, "*") == 0 && ((is_literal_value(right, TYPE_INT, 0) && !has_calls(left)) ||
+                                     (is_literal_value(left, TYPE_INT, 0) && !has_calls(right))))
+            return create_int_literal(0);
+    }
+
+    if (type == TYPE_FLOAT && node->data_type == TYPE_FLOAT)
+    {
+        if ((strcmp(op, "*") == 0 || strcmp(op, "/") == 0) && is_literal_value(right, TYPE_FLOAT, 1.0))
+            return left;
+        if (strcmp(op, "*") == 0 && is_literal_value(left, TYPE_FLOAT, 1.0))
+            return right;
+        if (strcmp(op, "-") == 0 && is_literal_value(right, TYPE_FLOAT, 0.0))
+            return left;
+    }
+
+    // x * 2 is x + x
+    if (strcmp(op, "*") == 0 && is_numeric_variable(left) && is_literal_value(right, type, 2))
+    {
+        ASTNode *sum = create_binary_operation_node("+", left, copy_identifier(left));
+        sum->data_type = node->data_type;
+        return sum;
+    }
+
+    // Integer x <= c is x < c + 1 and x >= c is x > c - 1, a single comparison without NOT
+    ConstantValue constant;
+    if (type == TYPE_INT && (strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0))
+    {
+        bool constant_right = evaluate_constant_expression(right, &constant);
+        if (!constant_right && !evaluate_constant_expression(left, &constant))
+        {
+            return node;
+        }
+        // c <= x is c - 1 < x, c >= x is c + 1 > x
+        bool increment = (strcmp(op, "<=") == 0) == constant_right;
+        if ((increment && constant.int_value == LLONG_MAX) || (!increment && constant.int_value == LLONG_MIN))
+        {
+            return node;
+        }
+        ASTNode *adjusted = create_int_literal(constant.int_value + (increment ? 1 : -1));
+        if (constant_right)
+        {
+            node->right = adjusted;
+        }
+        else
+        {
+            node->left = adjusted;
+        }
+        char *strict_op = string_duplicate(strcmp(op, "<=") == 0 ? "<" : ">");
+        safe_free(node->name);
+        node->name = strict_op;
+    }
+    return node;
+}
+
+/**
+ * Replaces an expression with a literal of its value if it is a constant.
+ * Comparisons are left to the dead code elimination of conditions.
+ */
+static ASTNode *fold_constant_expression(ASTNode *node)
+{
+    ConstantValue value;
+    if (!evaluate_constant_expression(node, &value))
+    {
+        return node;
+    }
+    char buffer[64];
+    switch (value.type)
+    {
+    case TYPE_INT:
+        return create_int_literal(value.int_value);
+
+    case TYPE_FLOAT:
+        if (!isfinite(value.float_value))
+        {
+            return node;
+        }
+        snprintf(buffer, sizeof(buffer), "%a", value.float_value);
+        return create_literal_node(TYPE_FLOAT, buffer);
+
+    case TYPE_U8:
+        return create_literal_node(TYPE_U8, value.string_value);
+
+    case TYPE_NULL:
+        return create_literal_node(TYPE_NULL, "null");
+
+    default:
+        return node;
+    }
+}
+
+/**
+ * Simplifies an expression bottom-up and returns its new root
+ */
+static ASTNode *simplify_expression(ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            node->arguments[i] = simplify_expression(node->arguments[i]);
+        }
+        return fold_constant_expression(node);
+    }
+    if (node->type != NODE_BINARY_OPERATION)
+    {
+        return node;
+    }
+    node->left = simplify_expression(node->left);
+    node->right = simplify_expression(node->right);
+    return fold_constant_expression(simplify_binary_operation(node));
+}
+
+/**
+ * Simplifies all expressions in a list of statements
+ */
+static void simplify_statements(ASTNode *statement)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+        case NODE_RETURN:
+            statement->left = simplify_expression(statement->left);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            simplify_expression(statement);
+            break;
+
+        case NODE_IF:
+            statement->condition = simplify_expression(statement->condition);
+            simplify_statements(statement->body->body);
+            if (statement->left != NULL)
+            {
+                simplify_statements(statement->left->body);
+            }
+            break;
+
+        case NODE_WHILE:
+            statement->condition = simplify_expression(statement->condition);
+            simplify_statements(statement->body->body);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Counts declarations and assignments of a variable in a list of statements
+ */
+static int count_assignments(ASTNode *statement, const char *name)
+{
+    int count = 0;
+    for (; statement != NULL; statement = statement->next)
+    {
+        if ((statement->type == NODE_VARIABLE_DECLARATION || statement->type == NODE_ASSIGNMENT) &&
+            strcmp(statement->name, name) == 0)
+        {
+            count++;
+        }
+        if (statement->type == NODE_IF || statement->type == NODE_WHILE)
+        {
+            count += count_assignments(statement->body->body, name);
+        }
+        if (statement->type == NODE_IF && statement->left != NULL)
+        {
+            count += count_assignments(statement->left->body, name);
+        }
+    }
+    return count;
+}
+
+/**
+ * Checks if a statement is an integer induction step i = i + c or i = i - c
+ */
+static bool is_induction_step(ASTNode *statement, long long *step)
+{
+    if (statement->type != NODE_ASSIGNMENT || statement->left->type != NODE_BINARY_OPERATION)
+    {
+        return false;
+    }
+    ASTNode *value = statement->left;
+    bool is_add = strcmp(value->name, "+") == 0;
+    if ((!is_add && strcmp(value->name, "-") != 0) || value->data_type != TYPE_INT ||
+        value->left->type != NODE_IDENTIFIER || strcmp(value->left->name, statement->name) != 0 ||
+        value->right->type != NODE_LITERAL || value->right->data_type != TYPE_INT)
+    {
+        return false;
+    }
+    *step = strtoll(value->right->value, NULL, 10);
+    if (!is_add)
+    {
+        *step = -*step;
+    }
+    return true;
+}
+
+/**
+ * Checks if an expression is i * k or k * i with a constant integer k
+ */
+static bool is_induction_product(ASTNode *node, const char *name, long long *factor)
+{
+    if (node == NULL || node->type != NODE_BINARY_OPERATION || strcmp(node->name, "*") != 0 ||
+        node->data_type != TYPE_INT)
+    {
+        return false;
+    }
+    ASTNode *other;
+    if (node->left->type == NODE_IDENTIFIER && strcmp(node->left->name, name) == 0)
+    {
+        other = node->right;
+    }
+    else if (node->right->type == NODE_IDENTIFIER && strcmp(node->right->name, name) == 0)
+    {
+        other = node->left;
+    }
+    else
+    {
+        return false;
+    }
+    ConstantValue value;
+    if (!evaluate_constant_expression(other, &value) || value.type != TYPE_INT)
+    {
+        return false;
+    }
+    *factor = value.int_value;
+    return true;
+}
+
+/**
+ * Rewrites products of an induction variable in an expression, returns its new root.
+ * In collect mode distinct factors are gathered, otherwise products with the
+ * given factor are counted and replaced by the derived variable (if set).
+ */
+static ASTNode *rewrite_induction_expression(ASTNode *node, InductionRewrite *rewrite)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    long long factor;
+    if (is_induction_product(node, rewrite->name, &factor))
+    {
+        if (rewrite->collect)
+        {
+            for (int i = 0; i < rewrite->factor_count; i++)
+            {
+                if (rewrite->factors[i] == factor)
+                {
+                    return node;
+                }
+            }
+            if (rewrite->factor_count < MAX_INDUCTION_FACTORS)
+            {
+                rewrite->factors[rewrite->factor_count++] = factor;
+            }
+            return node;
+        }
+        if (factor == rewrite->factor)
+        {
+            rewrite->count++;
+            return rewrite->derived != NULL ? copy_identifier(rewrite->derived) : node;
+        }
+        return node;
+    }
+
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            node->arguments[i] = rewrite_induction_expression(node->arguments[i], rewrite);
+        }
+    }
+    else if (node->type == NODE_BINARY_OPERATION)
+    {
+        node->left = rewrite_induction_expression(node->left, rewrite);
+        node->right = rewrite_induction_expression(node->right, rewrite);
+    }
+    return node;
+}
+
+/**
+ * Rewrites products of an induction variable in a list of statements
+ */
+static void rewrite_induction_statements(ASTNode *statement, InductionRewrite *rewrite)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+        case NODE_RETURN:
+            statement->left = rewrite_induction_expression(statement->left, rewrite);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            rewrite_induction_expression(statement, rewrite);
+            break;
+
+        case NODE_IF:
+            statement->condition = rewrite_induction_expression(statement->condition, rewrite);
+            rewrite_induction_statements(statement->body->body, rewrite);
+            if (statement->left != NULL)
+            {
+                rewrite_induction_statements(statement->left->body, rewrite);
+            }
+            break;
+
+        case NODE_WHILE:
+            statement->condition = rewrite_induction_expression(statement->condition, rewrite);
+            rewrite_induction_statements(statement->body->body, rewrite);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Rewrites products of an induction variable in a while loop (condition and body)
+ */
+static void rewrite_induction_loop(ASTNode *while_node, InductionRewrite *rewrite)
+{
+    while_node->condition = rewrite_induction_expression(while_node->condition, rewrite);
+    rewrite_induction_statements(while_node->body->body, rewrite);
+}
+
+/**
+ * Strength reduction of a while loop. For an induction variable i stepped once per
+ * iteration by i = i + c, products i * k are replaced by a derived variable d
+ * initialized to i * k before the loop and increased by c * k right after the step.
+ * Returns the declarations of derived variables to be placed before the loop.
+ */
+static ASTNode *reduce_induction_variables(ASTNode *while_node)
+{
+    ASTNode *head = NULL;
+    ASTNode *tail = NULL;
+
+    for (ASTNode *step_statement = while_node->body->body; step_statement != NULL; step_statement = step_statement->next)
+    {
+        long long step;
+        if (!is_induction_step(step_statement, &step) ||
+            count_assignments(while_node->body->body, step_statement->name) != 1)
+        {
+            continue;
+        }
+
+        InductionRewrite rewrite = {step_statement->name, {0}, 0, true, 0, NULL, 0};
+        rewrite_induction_loop(while_node, &rewrite);
+        rewrite.collect = false;
+
+        for (int i = 0; i < rewrite.factor_count; i++)
+        {
+            rewrite.factor = rewrite.factors[i];
+            rewrite.derived = NULL;
+            rewrite.count = 0;
+            rewrite_induction_loop(while_node, &rewrite);
+
+            // The running addition costs as much as one product, so it pays off from two uses
+            long long increment;
+            if (rewrite.count < 2 || !checked_mul(step, rewrite.factor, &increment) || increment == LLONG_MIN)
+            {
+                continue;
+            }
+
+            char derived_name[32];
+            snprintf(derived_name, sizeof(derived_name), "%%iv%d", compiler_context_current()->induction_variable_counter++);
+            ASTNode *derived = create_identifier_node(derived_name);
+            derived->data_type = TYPE_INT;
+
+            ASTNode *induction = create_identifier_node(step_statement->name);
+            induction->data_type = TYPE_INT;
+            ASTNode *initial_value = create_binary_operation_node("*", induction, create_int_literal(rewrite.factor));
+            initial_value->data_type = TYPE_INT;
+            append_statements(&head, &tail, create_variable_declaration_node(derived_name, TYPE_INT, initial_value));
+
+            rewrite.derived = derived;
+            rewrite_induction_loop(while_node, &rewrite);
+
+            ASTNode *update_value = create_binary_operation_node(increment >= 0 ? "+" : "-", copy_identifier(derived),
+                                                                 create_int_literal(increment >= 0 ? increment : -increment));
+            update_value->data_type = TYPE_INT;
+            ASTNode *update = create_assignment_node(derived_name, update_value);
+            update->next = step_statement->next;
+            step_statement->next = update;
+        }
+    }
+    return head;
+}
+
+/**
+ * Applies strength reduction to all while loops in a list of statements
+ */
+static void reduce_loops_in_statements(ASTNode **statements)
+{
+    for (ASTNode **link = statements; *link != NULL; link = &(*link)->next)
+    {
+        ASTNode *statement = *link;
+        if (statement->type == NODE_IF)
+        {
+            reduce_loops_in_statements(&statement->body->body);
+            if (statement->left != NULL)
+            {
+                reduce_loops_in_statements(&statement->left->body);
+            }
+        }
+        else if (statement->type == NODE_WHILE)
+        {
+            reduce_loops_in_statements(&statement->body->body);
+            ASTNode *declarations = reduce_induction_variables(statement);
+            if (declarations != NULL)
+            {
+                // Derived variables are initialized right before the loop
+                ASTNode *last = declarations;
+                while (last->next != NULL)
+                {
+                    last = last->next;
+                }
+                last->next = statement;
+                *link = declarations;
+                link = &last->next;
+            }
+        }
+    }
+}
+
+/**
+ * Algebraic simplification and strength reduction over all functions of the program
+ */
+void optimize_algebraic(ASTNode *program_node)
+{
+    if (program_node == NULL || program_node->type != NODE_PROGRAM)
+    {
+        return;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            simplify_statements(function->body->body);
+            reduce_loops_in_statements(&function->body->body);
+        }
+    }
+}
+
+/**
+ * Checks if a statement is a copy y = x of a non-nullable variable
+ */
+static bool is_copy_statement(ASTNode *statement)
+{
+    if ((statement->type != NODE_VARIABLE_DECLARATION && statement->type != NODE_ASSIGNMENT) ||
+        statement->left == NULL || statement->left->type != NODE_IDENTIFIER || strcmp(statement->name, "_") == 0)
+    {
+        return false;
+    }
+    ASTNode *source = statement->left;
+    return (source->data_type == TYPE_INT || source->data_type == TYPE_FLOAT || source->data_type == TYPE_U8) &&
+           strcmp(source->name, "true") != 0 && strcmp(source->name, "false") != 0 &&
+           strcmp(source->name, statement->name) != 0;
+}
+
+/**
+ * Checks if an expression reads a variable
+ */
+static bool expression_reads(ASTNode *node, const char *name)
+{
+    if (node == NULL)
+    {
+        return false;
+    }
+    if (node->type == NODE_IDENTIFIER)
+    {
+        return strcmp(node->name, name) == 0;
+    }
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            if (expression_reads(node->arguments[i], name))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    return expression_reads(node->left, name) || expression_reads(node->right, name);
+}
+
+/**
+ * Checks if a statement or any statement nested in it reads a variable
+ */
+static bool statement_reads(ASTNode *statement, const char *name)
+{
+    switch (statement->type)
+    {
+    case NODE_VARIABLE_DECLARATION:
+    case NODE_ASSIGNMENT:
+    case NODE_RETURN:
+        return expression_reads(statement->left, name);
+
+    case NODE_FUNCTION_CALL:
+        return expression_reads(statement, name);
+
+    case NODE_IF:
+    case NODE_WHILE:
+        if (expression_reads(statement->condition, name))
+        {
+            return true;
+        }
+        for (ASTNode *nested = statement->body->body; nested != NULL; nested = nested->next)
+        {
+            if (statement_reads(nested, name))
+            {
+                return true;
+            }
+        }
+        if (statement->type == NODE_IF && statement->left != NULL)
+        {
+            for (ASTNode *nested = statement->left->body; nested != NULL; nested = nested->next)
+            {
+                if (statement_reads(nested, name))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Checks if a statement or any statement nested in it assigns a variable
+ */
+static bool statement_assigns(ASTNode *statement, const char *name)
+{
+    if ((statement->type == NODE_VARIABLE_DECLARATION || statement->type == NODE_ASSIGNMENT) &&
+        strcmp(statement->name, name) == 0)
+    {
+        return true;
+    }
+    if (statement->type == NODE_IF || statement->type == NODE_WHILE)
+    {
+        return count_assignments(statement->body->body, name) > 0 ||
+               (statement->type == NODE_IF && statement->left != NULL && count_assignments(statement->left->body, name) > 0);
+    }
+    return false;
+}
+
+/**
+ * Replaces reads of a variable by reads of another variable of the same type
+ */
+static void rename_reads(ASTNode *node, const char *name, ASTNode *source)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    if (node->type == NODE_IDENTIFIER)
+    {
+        if (strcmp(node->name, name) == 0 && node->data_type == source->data_type)
+        {
+            node->name = string_duplicate(source->name);
+        }
+        return;
+    }
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            rename_reads(node->arguments[i], name, source);
+        }
+        return;
+    }
+    rename_reads(node->left, name, source);
+    rename_reads(node->right, name, source);
+}
+
+/**
+ * Propagates a copy target = source into the statements following it.
+ * Stops at the first statement that may change one of the two variables.
+ */
+static void propagate_copy(ASTNode *statement, const char *target, ASTNode *source)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            rename_reads(statement->left, target, source);
+            if (strcmp(statement->name, target) == 0 || strcmp(statement->name, source->name) == 0)
+            {
+                return;
+            }
+            break;
+
+        case NODE_RETURN:
+            rename_reads(statement->left, target, source);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            rename_reads(statement, target, source);
+            break;
+
+        case NODE_IF:
+            rename_reads(statement->condition, target, source);
+            if (statement_assigns(statement, target) || statement_assigns(statement, source->name))
+            {
+                return;
+            }
+            propagate_copy(statement->body->body, target, source);
+            if (statement->left != NULL)
+            {
+                propagate_copy(statement->left->body, target, source);
+            }
+            break;
+
+        case NODE_WHILE:
+            // The condition is evaluated again after the body
+            if (statement_assigns(statement, target) || statement_assigns(statement, source->name))
+            {
+                return;
+            }
+            rename_reads(statement->condition, target, source);
+            propagate_copy(statement->body->body, target, source);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Renames all reads and stores of a variable in a statement and the statements nested in it
+ */
+static void rename_variable(ASTNode *statement, const char *name, const char *new_name)
+{
+    if (statement == NULL)
+    {
+        return;
+    }
+    if (statement->type == NODE_IDENTIFIER ||
+        statement->type == NODE_VARIABLE_DECLARATION || statement->type == NODE_ASSIGNMENT)
+    {
+        if (strcmp(statement->name, name) == 0)
+        {
+            statement->name = string_duplicate(new_name);
+        }
+    }
+    if (statement->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < statement->arg_count; i++)
+        {
+            rename_variable(statement->arguments[i], name, new_name);
+        }
+        return;
+    }
+    if (statement->type == NODE_IF || statement->type == NODE_WHILE)
+    {
+        rename_variable(statement->condition, name, new_name);
+        for (ASTNode *nested = statement->body->body; nested != NULL; nested = nested->next)
+        {
+            rename_variable(nested, name, new_name);
+        }
+        if (statement->type == NODE_IF && statement->left != NULL)
+        {
+            for (ASTNode *nested = statement->left->body; nested != NULL; nested = nested->next)
+            {
+                rename_variable(nested, name, new_name);
+            }
+        }
+        return;
+    }
+    if (statement->type != NODE_IDENTIFIER && statement->type != NODE_LITERAL)
+    {
+        rename_variable(statement->left, name, new_name);
+        rename_variable(statement->right, name, new_name);
+    }
+}
+
+/**
+ * Stores the values of temporaries directly into the targets of their copies.
+ * For var x = e; ... y = x; with x dead after the copy and y untouched in between,
+ * the declaration becomes y = e, uses of x in between read y and the copy is removed.
+ */
+static void coalesce_copies(ASTNode **statements)
+{
+    for (ASTNode **link = statements; *link != NULL; link = &(*link)->next)
+    {
+        ASTNode *declaration = *link;
+        if (declaration->type == NODE_IF || declaration->type == NODE_WHILE)
+        {
+            coalesce_copies(&declaration->body->body);
+            if (declaration->type == NODE_IF && declaration->left != NULL)
+            {
+                coalesce_copies(&declaration->left->body);
+            }
+            continue;
+        }
+        // Bindings of if (x) |v| are left alone
+        if (declaration->type != NODE_VARIABLE_DECLARATION || declaration->left == NULL ||
+            declaration->left->data_type == TYPE_UNKNOWN)
+        {
+            continue;
+        }
+
+        const char *source = declaration->name;
+        ASTNode **copy_link = &declaration->next;
+        while (*copy_link != NULL &&
+               !(is_copy_statement(*copy_link) && strcmp((*copy_link)->left->name, source) == 0))
+        {
+            copy_link = &(*copy_link)->next;
+        }
+        if (*copy_link == NULL)
+        {
+            continue;
+        }
+
+        ASTNode *copy = *copy_link;
+        bool can_coalesce = true;
+        for (ASTNode *between = declaration->next; between != copy && can_coalesce; between = between->next)
+        {
+            can_coalesce = !statement_reads(between, copy->name) && !statement_assigns(between, copy->name);
+        }
+        for (ASTNode *after = copy->next; after != NULL && can_coalesce; after = after->next)
+        {
+            can_coalesce = !statement_reads(after, source);
+        }
+        if (!can_coalesce)
+        {
+            continue;
+        }
+
+        for (ASTNode *between = declaration->next; between != copy; between = between->next)
+        {
+            rename_variable(between, source, copy->name);
+        }
+        declaration->type = copy->type;
+        declaration->name = copy->name;
+        if (copy->type == NODE_VARIABLE_DECLARATION)
+        {
+            declaration->data_type = copy->data_type;
+        }
+        *copy_link = copy->next;
+    }
+}
+
+/**
+ * Propagates copies in a list of statements and the statements nested in it
+ */
+static void propagate_copies(ASTNode *statement)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        if (is_copy_statement(statement))
+        {
+            propagate_copy(statement->next, statement->name, statement->left);
+        }
+        if (statement->type == NODE_IF || statement->type == NODE_WHILE)
+        {
+            propagate_copies(statement->body->body);
+            if (statement->type == NODE_IF && statement->left != NULL)
+            {
+                propagate_copies(statement->left->body);
+            }
+        }
+    }
+}
+
+/**
+ * Variable live at some point of the dead store analysis
+ */
+typedef struct LiveVariable {
+    const char *name;
+    struct LiveVariable *next;
+} LiveVariable;
+
+/**
+ * Checks if a variable is in a live set
+ */
+static bool is_live(LiveVariable *live, const char *name)
+{
+    for (; live != NULL; live = live->next)
+    {
+        if (strcmp(live->name, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds a variable to a live set, returns false if it was already there
+ */
+static bool add_live(LiveVariable **live, const char *name)
+{
+    if (is_live(*live, name))
+    {
+        return false;
+    }
+    LiveVariable *variable = (LiveVariable *)safe_malloc(sizeof(LiveVariable));
+    variable->name = name;
+    variable->next = *live;
+    *live = variable;
+    return true;
+}
+
+/**
+ * Removes a variable from a live set
+ */
+static void remove_live(LiveVariable **live, const char *name)
+{
+    for (LiveVariable **link = live; *link != NULL; link = &(*link)->next)
+    {
+        if (strcmp((*link)->name, name) == 0)
+        {
+            LiveVariable *variable = *link;
+            *link = variable->next;
+            safe_free(variable);
+            return;
+        }
+    }
+}
+
+/**
+ * Frees a live set
+ */
+static void free_live(LiveVariable *live)
+{
+    while (live != NULL)
+    {
+        LiveVariable *next = live->next;
+        safe_free(live);
+        live = next;
+    }
+}
+
+/**
+ * Adds all variables of a live set to another one, returns true if it grew
+ */
+static bool merge_live(LiveVariable **live, LiveVariable *other)
+{
+    bool changed = false;
+    for (; other != NULL; other = other->next)
+    {
+        changed |= add_live(live, other->name);
+    }
+    return changed;
+}
+
+/**
+ * Copies a live set
+ */
+static LiveVariable *copy_live(LiveVariable *live)
+{
+    LiveVariable *copy = NULL;
+    merge_live(&copy, live);
+    return copy;
+}
+
+/**
+ * Adds the variables read by an expression to a live set
+ */
+static void add_live_uses(LiveVariable **live, ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    if (node->type == NODE_IDENTIFIER)
+    {
+        add_live(live, node->name);
+        return;
+    }
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            add_live_uses(live, node->arguments[i]);
+        }
+        return;
+    }
+    add_live_uses(live, node->left);
+    add_live_uses(live, node->right);
+}
+
+/**
+ * Checks if an expression can be dropped when its value is not used.
+ * It must not fail at runtime, read input or call a user function.
+ */
+static bool is_removable_expression(ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+    case NODE_IDENTIFIER:
+        return true;
+
+    case NODE_BINARY_OPERATION:
+        if (strcmp(node->name, "/") == 0)
+        {
+            ConstantValue divisor;
+            if (!evaluate_constant_expression(node->right, &divisor) ||
+                (divisor.type == TYPE_INT && (divisor.int_value == 0 || divisor.int_value == -1)) ||
+                (divisor.type == TYPE_FLOAT && divisor.float_value == 0.0))
+            {
+                return false;
+            }
+        }
+        return is_removable_expression(node->left) && is_removable_expression(node->right);
+
+    case NODE_FUNCTION_CALL:
+    {
+        static const char *removable_builtins[] = {
+            "ifj.length", "ifj.concat", "ifj.string", "ifj.i2f", "ifj.strcmp", "ifj.ord", "ifj.substring"};
+        bool is_removable_builtin = false;
+        for (size_t i = 0; i < sizeof(removable_builtins) / sizeof(removable_builtins[0]); i++)
+        {
+            is_removable_builtin |= strcmp(node->name, removable_builtins[i]) == 0;
+        }
+        if (!is_removable_builtin)
+        {
+            return false;
+        }
+        for (int i = 0; i < node->arg_count; i++)
+        {
+            if (!is_removable_expression(node->arguments[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Backward liveness over a list of statements.
+ * Takes the variables live after the list and returns the variables live before it,
+ * stores of values never read are removed when remove is set.
+ * The statements of the whole function are needed to keep declarations of variables stored later.
+ */
+static LiveVariable *eliminate_dead_stores(ASTNode *function_body, ASTNode **link, LiveVariable *live, bool remove)
+{
+    ASTNode *statement = *link;
+    if (statement == NULL)
+    {
+        return live;
+    }
+    live = eliminate_dead_stores(function_body, &statement->next, live, remove);
+
+    switch (statement->type)
+    {
+    case NODE_VARIABLE_DECLARATION:
+    case NODE_ASSIGNMENT:
+        if (statement->left != NULL && !is_live(live, statement->name) && is_removable_expression(statement->left))
+        {
+            // A declaration stays without its value while other statements still store to the variable
+            if (remove && statement->type == NODE_VARIABLE_DECLARATION && count_assignments(function_body, statement->name) > 1)
+            {
+                statement->left = NULL;
+            }
+            else if (remove)
+            {
+                *link = statement->next;
+            }
+            break;
+        }
+        remove_live(&live, statement->name);
+        add_live_uses(&live, statement->left);
+        break;
+
+    case NODE_RETURN:
+        free_live(live);
+        live = NULL;
+        add_live_uses(&live, statement->left);
+        break;
+
+    case NODE_FUNCTION_CALL:
+        add_live_uses(&live, statement);
+        break;
+
+    case NODE_IF:
+    {
+        LiveVariable *else_live = copy_live(live);
+        if (statement->left != NULL)
+        {
+            else_live = eliminate_dead_stores(function_body, &statement->left->body, else_live, remove);
+        }
+        live = eliminate_dead_stores(function_body, &statement->body->body, live, remove);
+        merge_live(&live, else_live);
+        free_live(else_live);
+        add_live_uses(&live, statement->condition);
+        break;
+    }
+
+    case NODE_WHILE:
+    {
+        // Variables live at the condition, iterated until the loop body adds no more
+        LiveVariable *header = live;
+        add_live_uses(&header, statement->condition);
+        bool changed = true;
+        while (changed)
+        {
+            LiveVariable *body_live = eliminate_dead_stores(function_body, &statement->body->body, copy_live(header), false);
+            changed = merge_live(&header, body_live);
+            free_live(body_live);
+        }
+        if (remove)
+        {
+            free_live(eliminate_dead_stores(function_body, &statement->body->body, copy_live(header), true));
+        }
+        live = header;
+        break;
+    }
+
+    default:
+        break;
+    }
+    return live;
+}
+
+/**
+ * Copy propagation and dead store elimination over all functions of the program
+ */
+void optimize_copies(ASTNode *program_node)
+{
+    if (program_node == NULL || program_node->type != NODE_PROGRAM)
+    {
+        return;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            propagate_copies(function->body->body);
+            coalesce_copies(&function->body->body);
+            free_live(eliminate_dead_stores(function->body->body, &function->body->body, NULL, true));
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * @file optimizer.h
+ *
+ * Header file for the AST optimization passes.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdbool.h>
+#include "ast.h"
+
+/**
+ * Value of a constant expression evaluated at compile time
+ */
+typedef struct {
+    DataType type;       // TYPE_INT, TYPE_FLOAT, TYPE_BOOL, TYPE_U8 or TYPE_NULL
+    long long int_value;
+    double float_value;
+    bool bool_value;
+    char *string_value;  // Not owned, points to a literal or to a folded string
+} ConstantValue;
+
+// Evaluates an expression built only from literals and built-in functions
+bool evaluate_constant_expression(ASTNode *node, ConstantValue *result);
+
+// Evaluates a condition that does not depend on runtime values
+bool evaluate_constant_condition(ASTNode *condition, bool *result);
+
+// Checks if control never falls through the end of a statement or block
+bool statement_terminates(ASTNode *statement);
+bool block_terminates(ASTNode *block_node);
+
+// Dead code elimination (unreachable statements, constant branches, dead loops)
+void optimize_dead_code(ASTNode *program_node);
+
+// Algebraic simplification of expressions and strength reduction of induction variables
+void optimize_algebraic(ASTNode *program_node);
+
+// Copy propagation and elimination of stores whose values are never read
+void optimize_copies(ASTNode *program_node);
+
+#endif // OPTIMIZER_H
@@ -12,15 +12,7 @@
  * @author <xshmon00> Gleb Shmonin
  */
 #include "parser.h"
-
-#define MAX_SCOPE_DEPTH 100
-
-// Global symbol table for the program
-static SymTable symtable;
-
-static int scope_stack[MAX_SCOPE_DEPTH];
-static int scope_stack_top = -1;
-static int scope_counter = 0;
+#include "compiler.h"
 
 // Function to make sure that current token us expected_type
 static void expect_token(TokenType expected_type, Scanner *scanner);
@@ -44,9 +36,6 @@ static ASTNode *parse_idendifier(Scanner *scanner, Symbol *symbol, char *identif
 static ASTNode *check_and_convert_expression(ASTNode *node, DataType expected_type, const char *variable_name);
 static ASTNode **parse_arguments(Scanner *scanner, Symbol *symbol, ASTNode **arguments, int param_count, int *arg_count, char *function_name, char *builtin_function_name);
 
-// Global token storage
-static Token current_token;
-
 /**
  * Dictionary of builtin functions
  */
@@ -65,47 +54,78 @@ BuiltinFunctionInfo builtin_functions[] = {
     {"ord", TYPE_INT, {TYPE_U8, TYPE_INT}, 2},
     {"chr", TYPE_U8, {TYPE_INT}, 1}};
 
+/**
+ * Returns the state of the parser in the current compiler context
+ */
+static ParserState *parser_state()
+{
+    return &compiler_context_current()->parser;
+}
+
+/**
+ * Adds the type and the lexeme of a token to a hash
+ */
+static void add_token_to_hash(Sha256 *hash, const Token *token)
+{
+    sha256_update(hash, &token->type, sizeof(token->type));
+    const char *lexeme = token->lexeme != NULL ? token->lexeme : "";
+    sha256_update(hash, lexeme, strlen(lexeme) + 1);
+}
+
+/**
+ * Initializes the state of the parser of a new compiler context
+ */
+void parser_state_init(ParserState *state)
+{
+    state->scope_stack_top = -1;
+    state->scope_counter = 0;
+}
+
 /**
  * Function that enters a new scope
  */
 void enter_scope() {
-    scope_counter++;
-    if (scope_stack_top >= MAX_SCOPE_DEPTH - 1) {
+    ParserState *state = parser_state();
+    state->scope_counter++;
+    if (state->scope_stack_top >= MAX_SCOPE_DEPTH - 1) {
         error_exit(ERR_INTERNAL, "Scope stack overflow");
     }
-    scope_stack[++scope_stack_top] = scope_counter;
+    state->scope_stack[++state->scope_stack_top] = state->scope_counter;
 }
 
 /**
  * Function that exits the current scope
  */
 void exit_scope() {
-    if (scope_stack_top < 0) {
+    ParserState *state = parser_state();
+    if (state->scope_stack_top < 0) {
         error_exit(ERR_INTERNAL, "Scope stack underflow");
     }
-    scope_stack_top--;
+    state->scope_stack_top--;
 }
 
 /**
  * Function that returns the current scope ID
  */
 int current_scope_id() {
-    if (scope_stack_top < 0) {
+    ParserState *state = parser_state();
+    if (state->scope_stack_top < 0) {
         return 0;
     }
-    return scope_stack[scope_stack_top];
+    return state->scope_stack[state->scope_stack_top];
 }
 
 /**
  * Function that finds variables in scopes in the format "variable.scope.function_name"
  */
 Symbol *search_variable_in_scopes(const char *variable_name, const char *function_name) {
-    for (int i = scope_stack_top; i >= -1; i--) {
-        int scope_id = (i >= 0) ? scope_stack[i] : 0;
+    ParserState *state = parser_state();
+    for (int i = state->scope_stack_top; i >= -1; i--) {
+        int scope_id = (i >= 0) ? state->scope_stack[i] : 0;
         size_t len = strlen(function_name) + strlen(variable_name) + 20;
         char *full_name = (char *)safe_malloc(len);
         snprintf(full_name, len, "%s.%d.%s", variable_name, scope_id, function_name);
-        Symbol *symbol = symtable_search(&symtable, full_name);
+        Symbol *symbol = symtable_search(&state->symtable, full_name);
         if (symbol != NULL) {
             return symbol;
         }
@@ -117,12 +137,13 @@ Symbol *search_variable_in_scopes(const char *variable_name, const char *functio
  * Function that checks variables in outer scopes in the format "variable.scope.function_name"
  */
 Symbol *search_variable_in_outer_scopes(const char *variable_name, const char *function_name) {
-    for (int i = scope_stack_top - 1; i >= -1; i--) {
-        int scope_id = (i >= 0) ? scope_stack[i] : 0;
+    ParserState *state = parser_state();
+    for (int i = state->scope_stack_top - 1; i >= -1; i--) {
+        int scope_id = (i >= 0) ? state->scope_stack[i] : 0;
         size_t len = strlen(function_name) + strlen(variable_name) + 20;
         char *full_name = (char *)safe_malloc(len);
         snprintf(full_name, len, "%s.%d.%s", variable_name, scope_id, function_name);
-        Symbol *symbol = symtable_search(&symtable, full_name);
+        Symbol *symbol = symtable_search(&state->symtable, full_name);
         safe_free(full_name);
         if (symbol != NULL) {
             return symbol;
@@ -137,9 +158,9 @@ Symbol *search_variable_in_outer_scopes(const char *variable_name, const char *f
 void parser_init(Scanner *scanner)
 {
     // Initialize the symbol table
-    symtable_init(&symtable);
+    symtable_init(&parser_state()->symtable);
     // Get the first token to start parsing
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 }
 
 /**
@@ -162,7 +183,7 @@ ASTNode *parse_program(Scanner *scanner)
     ASTNode *import_node = parse_import(scanner);
     program_node->next = import_node;
 
-    load_builtin_functions(&symtable, import_node);
+    load_builtin_functions(&parser_state()->symtable, import_node);
 
     // Pre-run
     parse_functions_declaration(scanner, program_node);
@@ -175,9 +196,9 @@ ASTNode *parse_program(Scanner *scanner)
     program_node_pointer = *program_node->body;
     current_function_pointer = program_node->body;
 
-    while (current_token.type != TOKEN_EOF)
+    while (parser_state()->current_token.type != TOKEN_EOF)
     {
-        if ((current_token.type == TOKEN_PUB) || (current_token.type == TOKEN_FN))
+        if ((parser_state()->current_token.type == TOKEN_PUB) || (parser_state()->current_token.type == TOKEN_FN))
         {
             // Creating function node again with all deeper nodes
             *current_function_pointer = *(parse_function(scanner, true));
@@ -194,14 +215,14 @@ ASTNode *parse_program(Scanner *scanner)
         }
         else
         {
-            error_exit(ERR_SYNTAX, "Expected function definition. Line: %d, Column: %d", current_token.line, current_token.column);
+            error_exit(ERR_SYNTAX, "Expected function definition. Line: %d, Column: %d", parser_state()->current_token.line, parser_state()->current_token.column);
         }
     }
 
     // Semantics check
 
-    is_main_correct(&symtable);
-    is_symtable_all_used(&symtable);
+    is_main_correct(&parser_state()->symtable);
+    is_symtable_all_used(&parser_state()->symtable);
     scope_check_identifiers_in_tree(program_node);
 
     return program_node;
@@ -224,27 +245,34 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
     expect_token(TOKEN_PUB, scanner);
     expect_token(TOKEN_FN, scanner);
 
-    if (current_token.type != TOKEN_IDENTIFIER)
+    if (parser_state()->current_token.type != TOKEN_IDENTIFIER)
     {
         error_exit(ERR_SYNTAX, "Expected function name.");
     }
 
-    char *function_name = string_duplicate(current_token.lexeme);
+    char *function_name = string_duplicate(parser_state()->current_token.lexeme);
 
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_LEFT_PAREN, scanner); // '('
+
+    // Variable names contain the function name, so when functions are generated on their own
+    // the scopes are numbered in each function and its names do not depend on the functions before it
+    if (is_definition && codegen_separate_functions())
+    {
+        parser_state()->scope_counter = 0;
+    }
     enter_scope();
     ASTNode **parameters = NULL;
     int param_count = 0;
 
-    if (current_token.type != TOKEN_RIGHT_PAREN)
+    if (parser_state()->current_token.type != TOKEN_RIGHT_PAREN)
     {
         parameters = (ASTNode **)safe_malloc(sizeof(ASTNode *));
         parameters[param_count++] = parse_parameter(scanner, function_name, is_definition);
-        while (current_token.type == TOKEN_COMMA)
+        while (parser_state()->current_token.type == TOKEN_COMMA)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             parameters = (ASTNode **)safe_realloc(parameters, (param_count + 1) * sizeof(ASTNode *));
             parameters[param_count++] = parse_parameter(scanner, function_name, is_definition);
         }
@@ -265,7 +293,7 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
     }
     else
     {
-        if (current_token.type != TOKEN_LEFT_BRACE)
+        if (parser_state()->current_token.type != TOKEN_LEFT_BRACE)
         {
             error_exit(ERR_SYNTAX, "Expected '{' at the start of function body.");
         }
@@ -273,13 +301,17 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
 
         while (brace_count > 0)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
+            if (parser_state()->body_hash != NULL)
+            {
+                add_token_to_hash(parser_state()->body_hash, &parser_state()->current_token);
+            }
 
-            if (current_token.type == TOKEN_LEFT_BRACE)
+            if (parser_state()->current_token.type == TOKEN_LEFT_BRACE)
             {
                 brace_count++;
             }
-            else if (current_token.type == TOKEN_RIGHT_BRACE)
+            else if (parser_state()->current_token.type == TOKEN_RIGHT_BRACE)
             {
                 brace_count--;
             }
@@ -287,7 +319,7 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
         function_node = create_function_node(function_name, return_type, parameters, param_count, NULL);
 
         char *function_name_symtable = string_duplicate(function_name);
-        Symbol *function_symbol = symtable_search(&symtable, function_name_symtable);
+        Symbol *function_symbol = symtable_search(&parser_state()->symtable, function_name_symtable);
         if (function_symbol != NULL)
         {
             error_exit(ERR_SEMANTIC_OTHER, "Function already defined.");
@@ -301,10 +333,11 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
         new_function->is_defined = true;
         new_function->declaration_node = function_node;
         new_function->is_used = strcmp(new_function->name, "main") == 0 ? true : false;
+        new_function->is_constant = false;
         new_function->next = NULL;
 
-        symtable_insert(&symtable, function_name_symtable, new_function);
-        current_token = get_next_token(scanner);
+        symtable_insert(&parser_state()->symtable, function_name_symtable, new_function);
+        parser_state()->current_token = get_next_token(scanner);
     }
     exit_scope();
 
@@ -322,20 +355,20 @@ ASTNode *parse_function(Scanner *scanner, bool is_definition)
  */
 ASTNode *parse_parameter(Scanner *scanner, char *function_name, bool is_definition)
 {
-    if (current_token.type != TOKEN_IDENTIFIER)
+    if (parser_state()->current_token.type != TOKEN_IDENTIFIER)
     {
         error_exit(ERR_SYNTAX, "Expected parameter name.");
     }
 
-    char *param_name = construct_variable_name(current_token.lexeme, function_name);
+    char *param_name = construct_variable_name(parser_state()->current_token.lexeme, function_name);
 
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_COLON, scanner);
 
     DataType param_type = parse_type(scanner);
 
-    Symbol *param_symbol = symtable_search(&symtable, param_name);
+    Symbol *param_symbol = symtable_search(&parser_state()->symtable, param_name);
     if (param_symbol != NULL && is_definition)
     {
         safe_free(param_name);
@@ -351,10 +384,12 @@ ASTNode *parse_parameter(Scanner *scanner, char *function_name, bool is_definiti
         new_param->parent_function = string_duplicate(function_name);
         new_param->data_type = param_type;
         new_param->is_defined = true;
+        new_param->is_used = false;
+        new_param->is_constant = false;
         new_param->next = NULL;
         new_param->declaration_node = param_node;
 
-        symtable_insert(&symtable, param_name, new_param);
+        symtable_insert(&parser_state()->symtable, param_name, new_param);
     }
 
     return param_node;
@@ -378,7 +413,7 @@ ASTNode *parse_block(Scanner *scanner, char *function_name, bool enter_new_scope
     ASTNode *block_node = create_block_node(NULL, TYPE_NULL);
     ASTNode *current_statement = NULL;
 
-    while (current_token.type != TOKEN_RIGHT_BRACE)
+    while (parser_state()->current_token.type != TOKEN_RIGHT_BRACE)
     {
         ASTNode *statement_node = parse_statement(scanner, function_name);
 
@@ -409,23 +444,23 @@ ASTNode *parse_block(Scanner *scanner, char *function_name, bool enter_new_scope
  */
 ASTNode *parse_statement(Scanner *scanner, char *function_name)
 {
-    if (current_token.type == TOKEN_VAR || current_token.type == TOKEN_CONST)
+    if (parser_state()->current_token.type == TOKEN_VAR || parser_state()->current_token.type == TOKEN_CONST)
     {
         return parse_variable_declaration(scanner, function_name);
     }
-    else if (current_token.type == TOKEN_IF)
+    else if (parser_state()->current_token.type == TOKEN_IF)
     {
         return parse_if_statement(scanner, function_name);
     }
-    else if (current_token.type == TOKEN_WHILE)
+    else if (parser_state()->current_token.type == TOKEN_WHILE)
     {
         return parse_while_statement(scanner, function_name);
     }
-    else if (current_token.type == TOKEN_RETURN)
+    else if (parser_state()->current_token.type == TOKEN_RETURN)
     {
         return parse_return_statement(scanner, function_name);
     }
-    else if (current_token.type == TOKEN_IDENTIFIER)
+    else if (parser_state()->current_token.type == TOKEN_IDENTIFIER)
     {
         return parse_variable_assigning(scanner, function_name);
     }
@@ -451,10 +486,10 @@ ASTNode *parse_variable_assigning(Scanner *scanner, char *function_name)
     char *name = NULL;
     Symbol *symbol = NULL;
     ASTNode *function_node;
-    bool is_builtin = is_builtin_function(current_token.lexeme, scanner);
+    bool is_builtin = is_builtin_function(parser_state()->current_token.lexeme, scanner);
     bool is_function = false;
     bool is_underscore = false;
-    symbol = symtable_search(&symtable, current_token.lexeme);
+    symbol = symtable_search(&parser_state()->symtable, parser_state()->current_token.lexeme);
     if (symbol != NULL)
     {
         if (symbol->symbol_type == SYMBOL_FUNCTION)
@@ -474,8 +509,8 @@ ASTNode *parse_variable_assigning(Scanner *scanner, char *function_name)
     }
     else if (is_function)
     {
-        char *function_call_name = string_duplicate(current_token.lexeme);
-        symbol = symtable_search(&symtable, function_call_name);
+        char *function_call_name = string_duplicate(parser_state()->current_token.lexeme);
+        symbol = symtable_search(&parser_state()->symtable, function_call_name);
         if (symbol == NULL || symbol->symbol_type != SYMBOL_FUNCTION)
         {
             error_exit(ERR_SEMANTIC_UNDEF, "Undefined function %s.", function_call_name);
@@ -494,10 +529,10 @@ ASTNode *parse_variable_assigning(Scanner *scanner, char *function_name)
     }
     else if (is_underscore)
     {
-        name = string_duplicate(current_token.lexeme);
-        symbol = symtable_search(&symtable, name);
+        name = string_duplicate(parser_state()->current_token.lexeme);
+        symbol = symtable_search(&parser_state()->symtable, name);
 
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
 
         expect_token(TOKEN_ASSIGN, scanner);
 
@@ -524,13 +559,13 @@ ASTNode *parse_variable_assigning(Scanner *scanner, char *function_name)
     }
     else
     {
-        symbol = search_variable_in_scopes(current_token.lexeme, function_name);
+        symbol = search_variable_in_scopes(parser_state()->current_token.lexeme, function_name);
         if (symbol == NULL)
         {
-            error_exit(ERR_SEMANTIC_UNDEF, "Variable or function %s is not defined.", current_token.lexeme);
+            error_exit(ERR_SEMANTIC_UNDEF, "Variable or function %s is not defined.", parser_state()->current_token.lexeme);
         }
         name = string_duplicate(symbol->name);
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
 
         expect_token(TOKEN_ASSIGN, scanner);
 
@@ -586,33 +621,33 @@ ASTNode *check_and_convert_expression(ASTNode *node, DataType expected_type, con
  */
 ASTNode *parse_variable_declaration(Scanner *scanner, char *function_name)
 {
-    TokenType var_type = current_token.type;
-    current_token = get_next_token(scanner);
+    TokenType var_type = parser_state()->current_token.type;
+    parser_state()->current_token = get_next_token(scanner);
 
-    if (current_token.type != TOKEN_IDENTIFIER)
+    if (parser_state()->current_token.type != TOKEN_IDENTIFIER)
     {
         error_exit(ERR_SYNTAX, "Expected variable name.");
     }
-    if (current_token.lexeme == NULL)
+    if (parser_state()->current_token.lexeme == NULL)
     {
         error_exit(ERR_INTERNAL, "Lexeme is NULL before strdup.");
     }
-    if (strcmp(current_token.lexeme, "_") == 0)
+    if (strcmp(parser_state()->current_token.lexeme, "_") == 0)
     {
         error_exit(ERR_SEMANTIC, "Variable _ is already declared.");
     }
     // Saving the base name of the variable for checking
-    const char *base_variable_name = current_token.lexeme;
+    const char *base_variable_name = parser_state()->current_token.lexeme;
 
     // We create the full name of the variable taking into account the scope
     char *variable_name = construct_variable_name(base_variable_name, function_name);
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     DataType declaration_type = TYPE_UNKNOWN;
 
-    if (current_token.type == TOKEN_COLON)
+    if (parser_state()->current_token.type == TOKEN_COLON)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         declaration_type = parse_type(scanner);
     }
 
@@ -654,7 +689,7 @@ ASTNode *parse_variable_declaration(Scanner *scanner, char *function_name)
     }
 
     // Checking whether a variable with the same name exists in the current scope
-    symbol = symtable_search(&symtable, variable_name);
+    symbol = symtable_search(&parser_state()->symtable, variable_name);
     if (symbol != NULL)
     {
         error_exit(ERR_SEMANTIC_OTHER, "Variable '%s' is already defined in the current scope.", base_variable_name);
@@ -667,11 +702,12 @@ ASTNode *parse_variable_declaration(Scanner *scanner, char *function_name)
     new_var->parent_function = string_duplicate(function_name);
     new_var->data_type = declaration_type;
     new_var->is_defined = true;
+    new_var->is_used = false;
     new_var->is_constant = (var_type == TOKEN_CONST) ? true : false;
     new_var->declaration_node = variable_declaration_node;
     new_var->next = NULL;
 
-    symtable_insert(&symtable, variable_name, new_var);
+    symtable_insert(&parser_state()->symtable, variable_name, new_var);
 
     return variable_declaration_node;
 }
@@ -700,15 +736,15 @@ ASTNode *parse_if_statement(Scanner *scanner, char *function_name)
 
     expect_token(TOKEN_RIGHT_PAREN, scanner); // ')'
 
-    if (current_token.type == TOKEN_PIPE)
+    if (parser_state()->current_token.type == TOKEN_PIPE)
     {
-        current_token = get_next_token(scanner);
-        if (current_token.type != TOKEN_IDENTIFIER)
+        parser_state()->current_token = get_next_token(scanner);
+        if (parser_state()->current_token.type != TOKEN_IDENTIFIER)
         {
             error_exit(ERR_SEMANTIC, "Expected identifier |id|");
         }
-        char *variable_name = construct_variable_name(current_token.lexeme, function_name);
-        Symbol *symbol = symtable_search(&symtable, current_token.lexeme);
+        char *variable_name = construct_variable_name(parser_state()->current_token.lexeme, function_name);
+        Symbol *symbol = symtable_search(&parser_state()->symtable, parser_state()->current_token.lexeme);
         if (symbol != NULL)
         {
             error_exit(ERR_SEMANTIC_OTHER, "Variable is already defined");
@@ -720,13 +756,14 @@ ASTNode *parse_if_statement(Scanner *scanner, char *function_name)
         new_var->parent_function = string_duplicate(function_name);
         new_var->data_type = detach_nullable(condition_node->data_type);
         new_var->is_defined = true;
+        new_var->is_used = false;
         new_var->is_constant = true;
         new_var->declaration_node = variable_declaration_node;
         new_var->next = NULL;
 
-        symtable_insert(&symtable, variable_name, new_var);
+        symtable_insert(&parser_state()->symtable, variable_name, new_var);
 
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         expect_token(TOKEN_PIPE, scanner);
 
         is_pipe = true;
@@ -742,9 +779,9 @@ ASTNode *parse_if_statement(Scanner *scanner, char *function_name)
         variable_declaration_node->left = create_identifier_node(condition_node->name);
     }
     ASTNode *false_block = NULL;
-    if (current_token.type == TOKEN_ELSE)
+    if (parser_state()->current_token.type == TOKEN_ELSE)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         enter_scope();
         false_block = parse_block(scanner, function_name, true);
         exit_scope();
@@ -779,15 +816,15 @@ ASTNode *parse_while_statement(Scanner *scanner, char *function_name)
 
     expect_token(TOKEN_RIGHT_PAREN, scanner); // ')'
 
-    if (current_token.type == TOKEN_PIPE)
+    if (parser_state()->current_token.type == TOKEN_PIPE)
     {
-        current_token = get_next_token(scanner);
-        if (current_token.type != TOKEN_IDENTIFIER)
+        parser_state()->current_token = get_next_token(scanner);
+        if (parser_state()->current_token.type != TOKEN_IDENTIFIER)
         {
             error_exit(ERR_SEMANTIC, "Expected identifier |id|");
         }
-        char *variable_name = construct_variable_name(current_token.lexeme, function_name);
-        Symbol *symbol = symtable_search(&symtable, current_token.lexeme);
+        char *variable_name = construct_variable_name(parser_state()->current_token.lexeme, function_name);
+        Symbol *symbol = symtable_search(&parser_state()->symtable, parser_state()->current_token.lexeme);
         if (symbol != NULL)
         {
             error_exit(ERR_SEMANTIC_OTHER, "Variable is already defined");
@@ -799,13 +836,14 @@ ASTNode *parse_while_statement(Scanner *scanner, char *function_name)
         new_var->parent_function = string_duplicate(function_name);
         new_var->data_type = detach_nullable(condition_node->data_type);
         new_var->is_defined = true;
+        new_var->is_used = false;
         new_var->is_constant = true;
         new_var->declaration_node = variable_declaration_node;
         new_var->next = NULL;
 
-        symtable_insert(&symtable, variable_name, new_var);
+        symtable_insert(&parser_state()->symtable, variable_name, new_var);
 
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         expect_token(TOKEN_PIPE, scanner);
         is_pipe = true;
     }
@@ -833,7 +871,7 @@ ASTNode *parse_return_statement(Scanner *scanner, char *function_name)
 
     ASTNode *return_value_node = NULL;
 
-    if (current_token.type != TOKEN_SEMICOLON)
+    if (parser_state()->current_token.type != TOKEN_SEMICOLON)
     {
         return_value_node = parse_expression(scanner, function_name);
     }
@@ -1001,10 +1039,10 @@ ASTNode *parse_multiplicative(Scanner *scanner, char *function_name)
 {
     ASTNode *node = parse_primary_expression(scanner, function_name);
 
-    while (current_token.type == TOKEN_MULTIPLY || current_token.type == TOKEN_DIVIDE)
+    while (parser_state()->current_token.type == TOKEN_MULTIPLY || parser_state()->current_token.type == TOKEN_DIVIDE)
     {
-        const char *operator_name = current_token.lexeme;
-        current_token = get_next_token(scanner);
+        const char *operator_name = parser_state()->current_token.lexeme;
+        parser_state()->current_token = get_next_token(scanner);
         ASTNode *right_node = parse_primary_expression(scanner, function_name);
 
         // Perform type checking and set data_type
@@ -1018,10 +1056,10 @@ ASTNode *parse_additive(Scanner *scanner, char *function_name)
 {
     ASTNode *node = parse_multiplicative(scanner, function_name);
 
-    while (current_token.type == TOKEN_PLUS || current_token.type == TOKEN_MINUS)
+    while (parser_state()->current_token.type == TOKEN_PLUS || parser_state()->current_token.type == TOKEN_MINUS)
     {
-        const char *operator_name = current_token.lexeme;
-        current_token = get_next_token(scanner);
+        const char *operator_name = parser_state()->current_token.lexeme;
+        parser_state()->current_token = get_next_token(scanner);
         ASTNode *right_node = parse_multiplicative(scanner, function_name);
 
         // Perform type checking and set data_type
@@ -1035,11 +1073,11 @@ ASTNode *parse_relational(Scanner *scanner, char *function_name)
 {
     ASTNode *node = parse_additive(scanner, function_name);
 
-    while (current_token.type == TOKEN_LESS || current_token.type == TOKEN_LESS_EQUAL ||
-           current_token.type == TOKEN_GREATER || current_token.type == TOKEN_GREATER_EQUAL)
+    while (parser_state()->current_token.type == TOKEN_LESS || parser_state()->current_token.type == TOKEN_LESS_EQUAL ||
+           parser_state()->current_token.type == TOKEN_GREATER || parser_state()->current_token.type == TOKEN_GREATER_EQUAL)
     {
-        const char *operator_name = current_token.lexeme;
-        current_token = get_next_token(scanner);
+        const char *operator_name = parser_state()->current_token.lexeme;
+        parser_state()->current_token = get_next_token(scanner);
         ASTNode *right_node = parse_additive(scanner, function_name);
 
         // Perform type checking and create a node
@@ -1055,10 +1093,10 @@ ASTNode *parse_equality(Scanner *scanner, char *function_name)
 {
     ASTNode *node = parse_relational(scanner, function_name);
 
-    while (current_token.type == TOKEN_EQUAL || current_token.type == TOKEN_NOT_EQUAL)
+    while (parser_state()->current_token.type == TOKEN_EQUAL || parser_state()->current_token.type == TOKEN_NOT_EQUAL)
     {
-        const char *operator_name = current_token.lexeme;
-        current_token = get_next_token(scanner);
+        const char *operator_name = parser_state()->current_token.lexeme;
+        parser_state()->current_token = get_next_token(scanner);
         ASTNode *right_node = parse_relational(scanner, function_name);
         // Perform type checking and create a node
         node = perform_type_checking_and_create_node(operator_name, node, right_node);
@@ -1079,39 +1117,39 @@ ASTNode *parse_expression(Scanner *scanner, char *function_name)
  */
 ASTNode *parse_primary_expression(Scanner *scanner, char *function_name)
 {
-    if (current_token.type == TOKEN_INT_LITERAL)
+    if (parser_state()->current_token.type == TOKEN_INT_LITERAL)
     {
-        char *value = string_duplicate(current_token.lexeme);
+        char *value = string_duplicate(parser_state()->current_token.lexeme);
         ASTNode *literal_node = create_literal_node(TYPE_INT, value);
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return literal_node;
     }
-    else if (current_token.type == TOKEN_FLOAT_LITERAL)
+    else if (parser_state()->current_token.type == TOKEN_FLOAT_LITERAL)
     {
-        char *value = string_duplicate(current_token.lexeme);
+        char *value = string_duplicate(parser_state()->current_token.lexeme);
         ASTNode *literal_node = create_literal_node(TYPE_FLOAT, value);
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return literal_node;
     }
-    else if (current_token.type == TOKEN_STRING_LITERAL)
+    else if (parser_state()->current_token.type == TOKEN_STRING_LITERAL)
     {
-        char *value = string_duplicate(current_token.lexeme);
+        char *value = string_duplicate(parser_state()->current_token.lexeme);
         ASTNode *literal_node = create_literal_node(TYPE_U8, value);
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return literal_node;
     }
-    else if (current_token.type == TOKEN_IDENTIFIER)
+    else if (parser_state()->current_token.type == TOKEN_IDENTIFIER)
     {
         char *identifier_name = NULL;
         Symbol *symbol = NULL;
-        bool is_builtin = is_builtin_function(current_token.lexeme, scanner);
+        bool is_builtin = is_builtin_function(parser_state()->current_token.lexeme, scanner);
         if (is_builtin)
         {
             return parse_builtin_function_call(scanner, symbol, identifier_name, function_name);
         }
         else
         {
-            symbol = symtable_search(&symtable, current_token.lexeme);
+            symbol = symtable_search(&parser_state()->symtable, parser_state()->current_token.lexeme);
 
             if (symbol != NULL && symbol->symbol_type == SYMBOL_FUNCTION)
             {
@@ -1123,18 +1161,18 @@ ASTNode *parse_primary_expression(Scanner *scanner, char *function_name)
             }
         }
     }
-    else if (current_token.type == TOKEN_LEFT_PAREN)
+    else if (parser_state()->current_token.type == TOKEN_LEFT_PAREN)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         ASTNode *expr_node = parse_expression(scanner, function_name);
         expect_token(TOKEN_RIGHT_PAREN, scanner);
         return expr_node;
     }
-    else if (current_token.type == TOKEN_NULL)
+    else if (parser_state()->current_token.type == TOKEN_NULL)
     {
-        char *value = string_duplicate(current_token.lexeme);
+        char *value = string_duplicate(parser_state()->current_token.lexeme);
         ASTNode *literal_node = create_literal_node(TYPE_NULL, value);
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return literal_node;
     }
     else
@@ -1150,28 +1188,28 @@ ASTNode *parse_import(Scanner *scanner)
 {
     expect_token(TOKEN_CONST, scanner);
 
-    if (current_token.type != TOKEN_IDENTIFIER || strcmp(current_token.lexeme, "ifj") != 0)
+    if (parser_state()->current_token.type != TOKEN_IDENTIFIER || strcmp(parser_state()->current_token.lexeme, "ifj") != 0)
     {
         error_exit(ERR_SYNTAX, "Expected identifier 'ifj'.");
     }
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_ASSIGN, scanner);
 
-    if (current_token.type != TOKEN_IMPORT)
+    if (parser_state()->current_token.type != TOKEN_IMPORT)
     {
         error_exit(ERR_SYNTAX, "Expected '@import'.");
     }
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_LEFT_PAREN, scanner);
 
-    if (current_token.type != TOKEN_STRING_LITERAL || strcmp(current_token.lexeme, "ifj24.zig") != 0)
+    if (parser_state()->current_token.type != TOKEN_STRING_LITERAL || strcmp(parser_state()->current_token.lexeme, "ifj24.zig") != 0)
     {
-        error_exit(ERR_SYNTAX, "Expected string literal \"ifj24.zig\". Got: %s", current_token.lexeme);
+        error_exit(ERR_SYNTAX, "Expected string literal \"ifj24.zig\". Got: %s", parser_state()->current_token.lexeme);
     }
-    char *import_value = string_duplicate(current_token.lexeme);
-    current_token = get_next_token(scanner);
+    char *import_value = string_duplicate(parser_state()->current_token.lexeme);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_RIGHT_PAREN, scanner);
 
@@ -1189,15 +1227,15 @@ ASTNode *parse_import(Scanner *scanner)
  */
 ASTNode *parse_builtin_function_call(Scanner *scanner, Symbol *symbol, char *identifier_name, char *function_name)
 {
-    identifier_name = construct_builtin_name("ifj", current_token.lexeme);
-    symbol = symtable_search(&symtable, identifier_name);
+    identifier_name = construct_builtin_name("ifj", parser_state()->current_token.lexeme);
+    symbol = symtable_search(&parser_state()->symtable, identifier_name);
     if (symbol == NULL)
     {
         error_exit(ERR_SEMANTIC_UNDEF, "Undefined builtin function");
     }
-    char *builtin_function_name = string_duplicate(current_token.lexeme);
+    char *builtin_function_name = string_duplicate(parser_state()->current_token.lexeme);
 
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_LEFT_PAREN, scanner);
 
@@ -1207,7 +1245,7 @@ ASTNode *parse_builtin_function_call(Scanner *scanner, Symbol *symbol, char *ide
     int builtin_index = get_builtin_function_index(builtin_function_name);
     int params_count = builtin_functions[builtin_index].param_count;
 
-    if (current_token.type != TOKEN_RIGHT_PAREN)
+    if (parser_state()->current_token.type != TOKEN_RIGHT_PAREN)
     {
         arguments =  parse_arguments(scanner, symbol, arguments, params_count, &arg_count, function_name, builtin_function_name);
     }
@@ -1231,8 +1269,8 @@ ASTNode *parse_builtin_function_call(Scanner *scanner, Symbol *symbol, char *ide
  */
 ASTNode *parse_function_call(Scanner *scanner, Symbol *symbol, char *identifier_name, char *function_name)
 {
-    identifier_name = current_token.lexeme;
-    current_token = get_next_token(scanner);
+    identifier_name = parser_state()->current_token.lexeme;
+    parser_state()->current_token = get_next_token(scanner);
 
     expect_token(TOKEN_LEFT_PAREN, scanner);
 
@@ -1240,7 +1278,7 @@ ASTNode *parse_function_call(Scanner *scanner, Symbol *symbol, char *identifier_
     int params_count = symbol->declaration_node->param_count;
     int arg_count = 0;
 
-    if (current_token.type != TOKEN_RIGHT_PAREN)
+    if (parser_state()->current_token.type != TOKEN_RIGHT_PAREN)
     {
         arguments = parse_arguments(scanner, symbol, arguments, params_count, &arg_count, function_name, NULL);
     }
@@ -1262,16 +1300,16 @@ ASTNode *parse_function_call(Scanner *scanner, Symbol *symbol, char *identifier_
  */
 ASTNode *parse_idendifier(Scanner *scanner, Symbol *symbol, char *identifier_name, char *function_name)
 {
-    symbol = search_variable_in_scopes(current_token.lexeme, function_name);
+    symbol = search_variable_in_scopes(parser_state()->current_token.lexeme, function_name);
     if (symbol == NULL)
     {
-        error_exit(ERR_SEMANTIC_UNDEF, "Undefined variable or function. Got lexeme: %s. Line and column: %d %d\n", current_token.lexeme, current_token.line, current_token.column);
+        error_exit(ERR_SEMANTIC_UNDEF, "Undefined variable or function. Got lexeme: %s. Line and column: %d %d\n", parser_state()->current_token.lexeme, parser_state()->current_token.line, parser_state()->current_token.column);
     }
     identifier_name = string_duplicate(symbol->name);
     ASTNode *identifier_node = create_identifier_node(identifier_name);
     identifier_node->data_type = symbol->data_type;
 
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
     return identifier_node;
 }
 
@@ -1290,10 +1328,10 @@ ASTNode **parse_arguments(Scanner *scanner, Symbol *symbol, ASTNode **arguments,
         error_exit(ERR_SEMANTIC_PARAMS, "Invalid type of arguments");
     }
 
-    while (current_token.type == TOKEN_COMMA)
+    while (parser_state()->current_token.type == TOKEN_COMMA)
     {
-        current_token = get_next_token(scanner);
-        if (current_token.type == TOKEN_RIGHT_PAREN)
+        parser_state()->current_token = get_next_token(scanner);
+        if (parser_state()->current_token.type == TOKEN_RIGHT_PAREN)
             break;
         if (*arg_count >= param_count)
         {
@@ -1349,9 +1387,9 @@ bool is_builtin_function(const char *identifier, Scanner *scanner)
     {
         return false;
     }
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
     expect_token(TOKEN_DOT, scanner);
-    identifier = current_token.lexeme;
+    identifier = parser_state()->current_token.lexeme;
     for (size_t i = 0; i < sizeof(builtin_functions) / sizeof(builtin_functions[0]); i++)
     {
         if (strcmp(identifier, builtin_functions[i].name) == 0)
@@ -1402,11 +1440,11 @@ void scope_check_identifiers_in_tree(ASTNode *root)
     // If it is identifier - check it
     if ((root->type == NODE_IDENTIFIER || root->type == NODE_ASSIGNMENT) && strcmp(root->name, "_") != 0)
     {
-        Symbol *symbol = symtable_search(&symtable, root->name);
+        Symbol *symbol = symtable_search(&parser_state()->symtable, root->name);
         ASTNode *declaration_node;
         if (symbol->symbol_type == SYMBOL_PARAMETER)
         {
-            Symbol *parent_function = symtable_search(&symtable, symbol->parent_function);
+            Symbol *parent_function = symtable_search(&parser_state()->symtable, symbol->parent_function);
             declaration_node = parent_function->declaration_node;
             bool found = scope_check(declaration_node, root);
             if (!found)
@@ -1476,15 +1514,29 @@ bool scope_check(ASTNode *node_decl, ASTNode *node_identifier)
 void parse_functions_declaration(Scanner *scanner, ASTNode *program_node)
 {
     Scanner saved_scanner_state = *scanner;
-    FILE saved_input = *scanner->input;
-    Token saved_token = current_token;
+    long saved_position = ftell(scanner->input);
+    Token saved_token = parser_state()->current_token;
+    bool hash_bodies = compiler_context_current()->function_cache != NULL;
 
     ASTNode *current_function = NULL;
-    while (current_token.type != TOKEN_EOF)
+    while (parser_state()->current_token.type != TOKEN_EOF)
     {
-        if ((current_token.type == TOKEN_PUB) || (current_token.type == TOKEN_FN))
+        if ((parser_state()->current_token.type == TOKEN_PUB) || (parser_state()->current_token.type == TOKEN_FN))
         {
+            // Bodies are hashed for the cache of functions, the signatures are kept in the nodes
+            Sha256 body_hash;
+            sha256_init(&body_hash);
+            parser_state()->body_hash = hash_bodies ? &body_hash : NULL;
             ASTNode *function_node = parse_function(scanner, false);
+            parser_state()->body_hash = NULL;
+            if (hash_bodies)
+            {
+                FunctionTokens *tokens = (FunctionTokens *)safe_malloc(sizeof(FunctionTokens));
+                tokens->name = string_duplicate(function_node->name);
+                sha256_final(&body_hash, tokens->digest);
+                tokens->next = parser_state()->function_tokens;
+                parser_state()->function_tokens = tokens;
+            }
             if (program_node->body == NULL)
             {
                 program_node->body = function_node;
@@ -1497,62 +1549,80 @@ void parse_functions_declaration(Scanner *scanner, ASTNode *program_node)
         }
         else
         {
-            error_exit(ERR_SYNTAX, "Expected function definition. Line: %d, Column: %d", current_token.line, current_token.column);
+            error_exit(ERR_SYNTAX, "Expected function definition. Line: %d, Column: %d", parser_state()->current_token.line, parser_state()->current_token.column);
         }
     }
     *scanner = saved_scanner_state;
-    *scanner->input = saved_input;
-    current_token = saved_token;
+    if (saved_position < 0 || fseek(scanner->input, saved_position, SEEK_SET) != 0)
+    {
+        error_exit(ERR_INTERNAL, "Cannot rewind the source file.");
+    }
+    parser_state()->current_token = saved_token;
 
     return;
 }
 
+/**
+ * Returns the hash of the tokens of a function body, NULL if the bodies were not hashed
+ */
+const unsigned char *parser_function_tokens(const char *function_name)
+{
+    for (FunctionTokens *tokens = parser_state()->function_tokens; tokens != NULL; tokens = tokens->next)
+    {
+        if (strcmp(tokens->name, function_name) == 0)
+        {
+            return tokens->digest;
+        }
+    }
+    return NULL;
+}
+
 /**
  * Pasre datatype and return it
  */
 DataType parse_type(Scanner *scanner)
 {
-    if (current_token.type == TOKEN_I32)
+    if (parser_state()->current_token.type == TOKEN_I32)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_INT;
     }
-    else if (current_token.type == TOKEN_F64)
+    else if (parser_state()->current_token.type == TOKEN_F64)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_FLOAT;
     }
-    else if (current_token.type == TOKEN_U8)
+    else if (parser_state()->current_token.type == TOKEN_U8)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_U8;
     }
-    else if (current_token.type == TOKEN_VOID)
+    else if (parser_state()->current_token.type == TOKEN_VOID)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_VOID;
     }
-    else if (current_token.type == TOKEN_ASSIGN)
+    else if (parser_state()->current_token.type == TOKEN_ASSIGN)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_UNKNOWN;
     }
-    else if (current_token.type == TOKEN_QUESTION)
+    else if (parser_state()->current_token.type == TOKEN_QUESTION)
     {
-        current_token = get_next_token(scanner);
-        if (current_token.type == TOKEN_I32)
+        parser_state()->current_token = get_next_token(scanner);
+        if (parser_state()->current_token.type == TOKEN_I32)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_INT_NULLABLE;
         }
-        else if (current_token.type == TOKEN_F64)
+        else if (parser_state()->current_token.type == TOKEN_F64)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_FLOAT_NULLABLE;
         }
-        else if (current_token.type == TOKEN_U8)
+        else if (parser_state()->current_token.type == TOKEN_U8)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_U8_NULLABLE;
         }
     }
@@ -1564,42 +1634,42 @@ DataType parse_type(Scanner *scanner)
 // Function to parse the return type (same as parameter type parsing)
 DataType parse_return_type(Scanner *scanner)
 {
-    if (current_token.type == TOKEN_I32)
+    if (parser_state()->current_token.type == TOKEN_I32)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_INT;
     }
-    else if (current_token.type == TOKEN_F64)
+    else if (parser_state()->current_token.type == TOKEN_F64)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_FLOAT;
     }
-    else if (current_token.type == TOKEN_U8)
+    else if (parser_state()->current_token.type == TOKEN_U8)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_U8;
     }
-    else if (current_token.type == TOKEN_VOID)
+    else if (parser_state()->current_token.type == TOKEN_VOID)
     {
-        current_token = get_next_token(scanner);
+        parser_state()->current_token = get_next_token(scanner);
         return TYPE_VOID;
     }
-    else if (current_token.type == TOKEN_QUESTION)
+    else if (parser_state()->current_token.type == TOKEN_QUESTION)
     {
-        current_token = get_next_token(scanner);
-        if (current_token.type == TOKEN_I32)
+        parser_state()->current_token = get_next_token(scanner);
+        if (parser_state()->current_token.type == TOKEN_I32)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_INT_NULLABLE;
         }
-        else if (current_token.type == TOKEN_F64)
+        else if (parser_state()->current_token.type == TOKEN_F64)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_FLOAT_NULLABLE;
         }
-        else if (current_token.type == TOKEN_U8)
+        else if (parser_state()->current_token.type == TOKEN_U8)
         {
-            current_token = get_next_token(scanner);
+            parser_state()->current_token = get_next_token(scanner);
             return TYPE_U8_NULLABLE;
         }
     }
@@ -1776,9 +1846,9 @@ DataType detach_nullable(DataType type_nullable)
  */
 static void expect_token(TokenType expected_type, Scanner *scanner)
 {
-    if (current_token.type != expected_type)
+    if (parser_state()->current_token.type != expected_type)
     {
-        error_exit(ERR_SYNTAX, "Unexpected token. Expected: %d, got: %d\nLine and column: %d %d\n", expected_type, current_token.type, current_token.line, current_token.column);
+        error_exit(ERR_SYNTAX, "Unexpected token. Expected: %d, got: %d\nLine and column: %d %d\n", expected_type, parser_state()->current_token.type, parser_state()->current_token.line, parser_state()->current_token.column);
     }
-    current_token = get_next_token(scanner);
+    parser_state()->current_token = get_next_token(scanner);
 }
\ No newline at end of file
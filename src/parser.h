@@ -22,10 +22,38 @@
 #include "string.h"
 #include "error.h"
 #include "scanner.h"
+#include "sha256.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#define MAX_SCOPE_DEPTH 100
+
+/**
+ * Hash of the tokens of a function body, taken by the declaration pre-pass
+ */
+typedef struct FunctionTokens {
+    char *name;
+    unsigned char digest[SHA256_SIZE];
+    struct FunctionTokens *next;
+} FunctionTokens;
+
+/**
+ * State of the parser in one compilation
+ */
+typedef struct {
+    SymTable symtable;                // Symbol table of the program
+    int scope_stack[MAX_SCOPE_DEPTH]; // Ids of the open scopes, innermost last
+    int scope_stack_top;
+    int scope_counter;                // Last scope id given out, in the function when functions are generated on their own
+    Token current_token;
+    Sha256 *body_hash;                // Tokens of the body skipped by the pre-pass are added to it, or NULL
+    FunctionTokens *function_tokens;  // Hashes of the function bodies when the code of functions is cached
+} ParserState;
+
+// Initializes the state of the parser of a new compiler context
+void parser_state_init(ParserState *state);
+
 // Initializes the parser
 void parser_init(Scanner *scanner);
 
@@ -52,6 +80,9 @@ void scope_check_identifiers_in_tree(ASTNode *root);
 bool scope_check(ASTNode *node_decl, ASTNode *node_identifier);
 
 void parse_functions_declaration(Scanner *scanner, ASTNode *program_node);
+
+// Returns the hash of the tokens of a function body, NULL if the bodies were not hashed
+const unsigned char *parser_function_tokens(const char *function_name);
 bool type_convertion(ASTNode *main_node);
 bool can_assign_type(DataType expected_type, DataType actual_type);
 DataType detach_nullable(DataType type_nullable);
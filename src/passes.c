@@ -0,0 +1,220 @@
+/**
+ * @file passes.c
+ *
+ * Implementation of the pass manager.
+ * Passes run in the order of the table, AST passes after the semantic checks
+ * and IR passes on the SSA form once it is built.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "passes.h"
+#include "codegen.h"
+#include "compiler.h"
+#include "error.h"
+#include "gvn.h"
+#include "optimizer.h"
+#include <string.h>
+#include <time.h>
+
+/** Offset of an option of the code generator switched by a pass */
+#define CODEGEN_FLAG(option) offsetof(CodegenOptions, option)
+
+/**
+ * All passes in the order they run
+ */
+static const Pass passes[PASS_COUNT] = {
+    {"dead-code", "Remove unreachable statements, constant branches and dead loops",
+     OPT_LEVEL_1, true, optimize_dead_code, NULL, CODEGEN_FLAG(skip_unreachable)},
+    {"algebraic", "Simplify expressions, fold built-in calls and reduce multiplications by loop counters",
+     OPT_LEVEL_1, true, optimize_algebraic, NULL, NO_CODEGEN_FLAG},
+    {"copy-propagation", "Propagate copies and remove stores whose values are never read",
+     OPT_LEVEL_1, true, optimize_copies, NULL, NO_CODEGEN_FLAG},
+    {"reachable", "Generate only functions reachable from main",
+     OPT_LEVEL_1, true, NULL, NULL, CODEGEN_FLAG(reachable_only)},
+    {"condition-jumps", "Lower comparisons in conditions to conditional jumps",
+     OPT_LEVEL_1, true, NULL, NULL, CODEGEN_FLAG(condition_jumps)},
+    {"tail-calls", "Compile tail self-calls as a jump reusing the frame",
+     OPT_LEVEL_1, true, NULL, NULL, CODEGEN_FLAG(tail_calls)},
+    {"inline-string", "Generate ifj.string and conversions of literals without a call",
+     OPT_LEVEL_1, true, NULL, NULL, CODEGEN_FLAG(inline_string)},
+    {"loop-rotation", "Generate while loops as a guard and a do-while",
+     OPT_LEVEL_2, false, NULL, NULL, CODEGEN_FLAG(loop_rotation)},
+    {"inline", "Inline small non-recursive functions",
+     OPT_LEVEL_2, false, NULL, NULL, CODEGEN_FLAG(inlining)},
+    {"licm", "Hoist loop-invariant expressions out of rotated loops",
+     OPT_LEVEL_2, false, NULL, NULL, CODEGEN_FLAG(licm)},
+    {"inline-strcmp", "Expand ifj.strcmp inline instead of calling a helper function",
+     OPT_LEVEL_2, false, NULL, NULL, CODEGEN_FLAG(inline_strcmp)},
+    {"inline-substring", "Expand ifj.substring inline instead of calling a helper function",
+     OPT_LEVEL_2, false, NULL, NULL, CODEGEN_FLAG(inline_substring)},
+    {"i2f-reuse", "Reuse conversions of a variable within a statement",
+     OPT_LEVEL_2, true, NULL, NULL, CODEGEN_FLAG(i2f_reuse)},
+    {"range-checks", "Drop checks of ifj.chr and ifj.ord arguments proven in range",
+     OPT_LEVEL_2, true, NULL, NULL, CODEGEN_FLAG(range_checks)},
+    {"null-checks", "Drop null tests of variables with a known state",
+     OPT_LEVEL_2, true, NULL, NULL, CODEGEN_FLAG(null_checks)},
+    {"gvn", "Reuse values of equivalent pure expressions",
+     OPT_LEVEL_2, true, NULL, gvn_optimize_function, CODEGEN_FLAG(value_numbering)},
+};
+
+/**
+ * Sets a pass and the option of the code generator it switches
+ */
+static void set_pass_enabled(CompilerContext *context, int index, bool enabled)
+{
+    context->passes.enabled[index] = enabled;
+    if (passes[index].codegen_flag != NO_CODEGEN_FLAG)
+    {
+        *(bool *)((char *)&context->codegen.options + passes[index].codegen_flag) = enabled;
+    }
+}
+
+/**
+ * Parses an optimization level option
+ */
+bool passes_parse_level(const char *argument, OptimizationLevel *level)
+{
+    static const struct {
+        const char *option;
+        OptimizationLevel level;
+    } levels[] = {{"-O0", OPT_LEVEL_0}, {"-O1", OPT_LEVEL_1}, {"-O2", OPT_LEVEL_2}, {"-Os", OPT_LEVEL_SIZE}};
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        if (strcmp(argument, levels[i].option) == 0)
+        {
+            *level = levels[i].level;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Enables exactly the passes of an optimization level
+ */
+void passes_set_level(CompilerContext *context, OptimizationLevel level)
+{
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        bool enabled = level == OPT_LEVEL_SIZE ? passes[i].in_size_level : passes[i].level <= level;
+        set_pass_enabled(context, i, enabled);
+    }
+}
+
+/**
+ * Enables or disables a pass by its name
+ */
+bool passes_set_enabled(CompilerContext *context, const char *name, bool enabled)
+{
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        if (strcmp(passes[i].name, name) == 0)
+        {
+            set_pass_enabled(context, i, enabled);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the elapsed time in seconds. Processor time (clock) would add up all codegen
+ * threads and the other compilations running in a server or batch process.
+ */
+double passes_clock()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Runs the enabled AST passes in order
+ */
+void passes_run_ast(CompilerContext *context, ASTNode *program_node)
+{
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        if (context->passes.enabled[i] && passes[i].run_ast != NULL)
+        {
+            double start = passes_clock();
+            passes[i].run_ast(program_node);
+            context->passes.seconds[i] += passes_clock() - start;
+        }
+    }
+}
+
+/**
+ * Verifies all functions of the SSA form, a broken one is an internal error
+ */
+static void verify_ir(CompilerContext *context, IrProgram *program, const char *pass_name)
+{
+    for (IrFunction *function = program->functions; function != NULL; function = function->next)
+    {
+        if (!ir_verify(function, context->diagnostics))
+        {
+            error_exit(ERR_INTERNAL, "Invalid IR of function %s after %s\n", function->name, pass_name);
+        }
+    }
+}
+
+/**
+ * Runs the enabled IR passes on every function, verifying the IR between them
+ */
+void passes_run_ir(CompilerContext *context, IrProgram *program)
+{
+    verify_ir(context, program, "construction");
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        if (context->passes.enabled[i] && passes[i].run_ir != NULL)
+        {
+            double start = passes_clock();
+            for (IrFunction *function = program->functions; function != NULL; function = function->next)
+            {
+                passes[i].run_ir(function);
+            }
+            context->passes.seconds[i] += passes_clock() - start;
+            verify_ir(context, program, passes[i].name);
+        }
+    }
+}
+
+/**
+ * Prints the time spent in the front end, in each pass that ran and in the code generator
+ */
+void passes_print_timing(CompilerContext *context, FILE *output, double frontend_seconds, double codegen_seconds)
+{
+    double total = frontend_seconds + codegen_seconds;
+    fprintf(output, "%-20s %10s\n", "phase", "seconds");
+    fprintf(output, "%-20s %10.6f\n", "frontend", frontend_seconds);
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        if (context->passes.enabled[i] && (passes[i].run_ast != NULL || passes[i].run_ir != NULL))
+        {
+            fprintf(output, "%-20s %10.6f\n", passes[i].name, context->passes.seconds[i]);
+            total += context->passes.seconds[i];
+        }
+    }
+    fprintf(output, "%-20s %10.6f\n", "codegen", codegen_seconds);
+    fprintf(output, "%-20s %10.6f\n", "total", total);
+}
+
+/**
+ * Prints names, levels and descriptions of all passes
+ */
+void passes_print_list(FILE *output)
+{
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        fprintf(output, "%-18s -O%d%-4s %s\n", passes[i].name, passes[i].level == OPT_LEVEL_1 ? 1 : 2,
+                passes[i].in_size_level ? " -Os" : "", passes[i].description);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file passes.h
+ *
+ * Header file for the pass manager.
+ * Every optimization is a named pass enabled by the -O levels and switched
+ * one by one from the command line. A pass rewrites the AST before code
+ * generation, rewrites the SSA form of each function, switches an optimization
+ * of the code generator, or does more of these.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "ast.h"
+#include "ir.h"
+
+struct CompilerContext;
+
+/** Optimization levels selected by -O0, -O1, -O2 and -Os */
+typedef enum {
+    OPT_LEVEL_0,    // No optimizations, the code of the plain translation
+    OPT_LEVEL_1,    // Cheap local optimizations
+    OPT_LEVEL_2,    // All optimizations
+    OPT_LEVEL_SIZE  // Optimizations that do not make the code larger
+} OptimizationLevel;
+
+/** Level used when no -O option is given */
+#define DEFAULT_OPT_LEVEL OPT_LEVEL_2
+
+/** Number of passes in the table of passes.c */
+#define PASS_COUNT 16
+
+/** Marks a pass that switches no option of the code generator */
+#define NO_CODEGEN_FLAG ((size_t)-1)
+
+/**
+ * Named optimization pass
+ */
+typedef struct {
+    const char *name;
+    const char *description;
+    OptimizationLevel level;          // OPT_LEVEL_1 or OPT_LEVEL_2, the lowest level enabling the pass
+    bool in_size_level;               // Enabled by -Os
+    void (*run_ast)(ASTNode *program_node); // Rewrites the AST, or NULL
+    int (*run_ir)(IrFunction *function);    // Rewrites an SSA function, or NULL
+    size_t codegen_flag;              // Offset of the option in CodegenOptions, or NO_CODEGEN_FLAG
+} Pass;
+
+/**
+ * Passes selected for one compilation
+ */
+typedef struct {
+    bool enabled[PASS_COUNT];
+    double seconds[PASS_COUNT]; // Time spent running each pass
+} PassState;
+
+// Parses -O0, -O1, -O2 or -Os, returns false for other arguments
+bool passes_parse_level(const char *argument, OptimizationLevel *level);
+
+// Enables exactly the passes of an optimization level
+void passes_set_level(struct CompilerContext *context, OptimizationLevel level);
+
+// Enables or disables a pass by its name, returns false if there is no such pass
+bool passes_set_enabled(struct CompilerContext *context, const char *name, bool enabled);
+
+// Runs the enabled AST passes in order
+void passes_run_ast(struct CompilerContext *context, ASTNode *program_node);
+
+// Runs the enabled IR passes on every function and verifies the IR before and after each of them
+void passes_run_ir(struct CompilerContext *context, IrProgram *program);
+
+// Returns the elapsed (monotonic) time in seconds, for timing the phases around the passes
+double passes_clock();
+
+// Prints the time spent in the front end, in each pass and in the code generator
+void passes_print_timing(struct CompilerContext *context, FILE *output, double frontend_seconds, double codegen_seconds);
+
+// Prints names, levels and descriptions of all passes
+void passes_print_list(FILE *output);
+
+#endif // PASSES_H
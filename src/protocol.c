@@ -0,0 +1,179 @@
+/**
+ * @file protocol.c
+ *
+ * Implementation of the protocol of the compile server.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "protocol.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * Sends all bytes, a closed peer is reported as an error instead of SIGPIPE
+ */
+static bool send_all(int connection, const void *data, size_t length)
+{
+    const char *bytes = data;
+    while (length > 0)
+    {
+        ssize_t sent = send(connection, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+/**
+ * Receives exactly the given number of bytes
+ */
+static bool receive_all(int connection, void *data, size_t length)
+{
+    char *bytes = data;
+    while (length > 0)
+    {
+        ssize_t received = read(connection, bytes, length);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        length -= (size_t)received;
+    }
+    return true;
+}
+
+/**
+ * Sends a big-endian 32-bit number
+ */
+static bool send_number(int connection, uint32_t number)
+{
+    unsigned char bytes[4] = {number >> 24, (number >> 16) & 0xff, (number >> 8) & 0xff, number & 0xff};
+    return send_all(connection, bytes, sizeof(bytes));
+}
+
+/**
+ * Receives a big-endian 32-bit number
+ */
+static bool receive_number(int connection, uint32_t *number)
+{
+    unsigned char bytes[4];
+    if (!receive_all(connection, bytes, sizeof(bytes)))
+    {
+        return false;
+    }
+    *number = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+    return true;
+}
+
+/**
+ * Sends a length followed by the bytes
+ */
+static bool send_block(int connection, const char *data, size_t length)
+{
+    if (data == NULL)
+    {
+        length = 0;
+    }
+    if (length > PROTOCOL_MAX_LENGTH)
+    {
+        return false;
+    }
+    return send_number(connection, (uint32_t)length) && send_all(connection, data, length);
+}
+
+/**
+ * Receives a length followed by the bytes into a new buffer terminated by '\0'
+ */
+static bool receive_block(int connection, char **data, size_t *length)
+{
+    uint32_t block_length;
+    if (!receive_number(connection, &block_length) || block_length > PROTOCOL_MAX_LENGTH)
+    {
+        return false;
+    }
+    char *block = malloc((size_t)block_length + 1);
+    if (block == NULL)
+    {
+        return false;
+    }
+    if (!receive_all(connection, block, block_length))
+    {
+        free(block);
+        return false;
+    }
+    block[block_length] = '\0';
+    *data = block;
+    *length = block_length;
+    return true;
+}
+
+/**
+ * Sends a source to compile
+ */
+bool protocol_send_request(int connection, const char *source, size_t length)
+{
+    return send_block(connection, source, length);
+}
+
+/**
+ * Receives a source into a new buffer
+ */
+bool protocol_receive_request(int connection, char **source, size_t *length)
+{
+    return receive_block(connection, source, length);
+}
+
+/**
+ * Sends the result of a compilation with its code and diagnostics
+ */
+bool protocol_send_response(int connection, int result, const char *code, size_t code_length,
+                            const char *diagnostics, size_t diagnostics_length)
+{
+    return send_number(connection, (uint32_t)result) &&
+           send_block(connection, result == 0 ? code : NULL, code_length) &&
+           send_block(connection, diagnostics, diagnostics_length);
+}
+
+/**
+ * Receives the result of a compilation with its code and diagnostics
+ */
+bool protocol_receive_response(int connection, int *result, char **code, size_t *code_length,
+                               char **diagnostics, size_t *diagnostics_length)
+{
+    uint32_t number;
+    if (!receive_number(connection, &number) || !receive_block(connection, code, code_length))
+    {
+        return false;
+    }
+    if (!receive_block(connection, diagnostics, diagnostics_length))
+    {
+        free(*code);
+        *code = NULL;
+        return false;
+    }
+    *result = (int)number;
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file protocol.h
+ *
+ * Header file for the protocol of the compile server.
+ * A client sends requests over a stream socket and gets one response to each:
+ *
+ *   request:  length (u32), source (length bytes)
+ *   response: result (u32), code length (u32), code, diagnostics length (u32), diagnostics
+ *
+ * Numbers are unsigned 32-bit big-endian, the result is the exit code the
+ * compiler would return and the code is sent only when the result is 0.
+ * A connection may carry any number of requests, one after another.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Longest source, code or diagnostics accepted in a frame */
+#define PROTOCOL_MAX_LENGTH (64u * 1024u * 1024u)
+
+// Sends a source to compile
+bool protocol_send_request(int connection, const char *source, size_t length);
+
+// Receives a source into a new buffer freed with free(), false at the end of the connection or on an error
+bool protocol_receive_request(int connection, char **source, size_t *length);
+
+// Sends the result of a compilation with its code and diagnostics (both may be NULL)
+bool protocol_send_response(int connection, int result, const char *code, size_t code_length,
+                            const char *diagnostics, size_t diagnostics_length);
+
+// Receives the result of a compilation, the code and diagnostics are terminated by '\0' and freed with free()
+bool protocol_receive_response(int connection, int *result, char **code, size_t *code_length,
+                               char **diagnostics, size_t *diagnostics_length);
+
+#endif // PROTOCOL_H
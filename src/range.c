@@ -0,0 +1,989 @@
+/**
+ * @file range.c
+ *
+ * Implementation of the integer value range analysis.
+ * Bounds are either constants or linear in the length of a string variable,
+ * so loop counters compared with ifj.length(s) are known to index s.
+ * The analysis walks each function body once: variables assigned in a loop
+ * are widened at its entry (counters keep their initial bound in the direction
+ * they move), conditions of if/while statements narrow the ranges in their branches.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#include "range.h"
+#include "optimizer.h"
+#include "utils.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Largest value of a byte, range of ifj.ord results and of ifj.chr arguments without the modulo */
+#define BYTE_MAX 255
+
+static void analyze_statements(ASTNode *statement, RangeVariable **env, RangeInfo *info);
+
+/**
+ * Creates a bound holding no information
+ */
+static RangeBound infinite_bound()
+{
+    RangeBound bound = {true, NULL, 0, 0, 1};
+    return bound;
+}
+
+/**
+ * Creates a constant bound
+ */
+static RangeBound constant_bound(long long value)
+{
+    RangeBound bound = {false, NULL, 0, value, 1};
+    return bound;
+}
+
+/**
+ * Creates a range of any integer
+ */
+static Range unknown_range()
+{
+    Range range = {infinite_bound(), infinite_bound()};
+    return range;
+}
+
+/**
+ * Creates a range of integers from low to high
+ */
+static Range constant_range(long long low, long long high)
+{
+    Range range = {constant_bound(low), constant_bound(high)};
+    return range;
+}
+
+/**
+ * Multiplies two integers, fails on overflow
+ */
+static bool checked_mul(long long a, long long b, long long *result)
+{
+    if (a == 0 || b == 0)
+    {
+        *result = 0;
+        return true;
+    }
+    if (a == LLONG_MIN || b == LLONG_MIN || llabs(a) > LLONG_MAX / llabs(b))
+    {
+        return false;
+    }
+    *result = a * b;
+    return true;
+}
+
+/**
+ * Adds two integers, fails on overflow
+ */
+static bool checked_add(long long a, long long b, long long *result)
+{
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b))
+    {
+        return false;
+    }
+    *result = a + b;
+    return true;
+}
+
+/**
+ * Greatest common divisor of two non-negative integers
+ */
+static long long gcd(long long a, long long b)
+{
+    while (b != 0)
+    {
+        long long rest = a % b;
+        a = b;
+        b = rest;
+    }
+    return a;
+}
+
+/**
+ * Reduces the fraction of a bound, a bound without a length term is a constant
+ */
+static RangeBound normalize_bound(RangeBound bound)
+{
+    if (bound.infinite)
+    {
+        return bound;
+    }
+    if (bound.p == 0)
+    {
+        bound.string = NULL;
+    }
+    long long divisor = gcd(gcd(llabs(bound.p), llabs(bound.r)), bound.d);
+    if (divisor > 1)
+    {
+        bound.p /= divisor;
+        bound.r /= divisor;
+        bound.d /= divisor;
+    }
+    return bound;
+}
+
+/**
+ * Sum of two bounds, infinite if they depend on lengths of different strings
+ */
+static RangeBound add_bounds(RangeBound a, RangeBound b)
+{
+    if (a.infinite || b.infinite || (a.string != NULL && b.string != NULL && strcmp(a.string, b.string) != 0))
+    {
+        return infinite_bound();
+    }
+    RangeBound sum = {false, a.string != NULL ? a.string : b.string, 0, 0, 1};
+    long long first, second;
+    if (!checked_mul(a.p, b.d, &first) || !checked_mul(b.p, a.d, &second) || !checked_add(first, second, &sum.p) ||
+        !checked_mul(a.r, b.d, &first) || !checked_mul(b.r, a.d, &second) || !checked_add(first, second, &sum.r) ||
+        !checked_mul(a.d, b.d, &sum.d))
+    {
+        return infinite_bound();
+    }
+    return normalize_bound(sum);
+}
+
+/**
+ * Multiplies a bound by a constant
+ */
+static RangeBound scale_bound(RangeBound bound, long long factor)
+{
+    if (bound.infinite || !checked_mul(bound.p, factor, &bound.p) || !checked_mul(bound.r, factor, &bound.r))
+    {
+        return infinite_bound();
+    }
+    return normalize_bound(bound);
+}
+
+/**
+ * Checks if a bound is never greater than another one (lengths are non-negative)
+ */
+static bool bound_less_or_equal(RangeBound a, RangeBound b)
+{
+    RangeBound difference = add_bounds(b, scale_bound(a, -1));
+    return !difference.infinite && difference.p >= 0 && difference.r >= 0;
+}
+
+/**
+ * Checks if a bound is never negative when its string has at least min_length characters
+ */
+static bool bound_is_non_negative(RangeBound bound, long long min_length)
+{
+    long long value;
+    return !bound.infinite && bound.p >= 0 && checked_mul(bound.p, min_length, &value) &&
+           checked_add(value, bound.r, &value) && value >= 0;
+}
+
+/**
+ * Tighter of two upper bounds of the same value (both are valid)
+ */
+static RangeBound min_high(RangeBound a, RangeBound b)
+{
+    if (a.infinite || (!b.infinite && bound_less_or_equal(b, a)))
+    {
+        return b;
+    }
+    if (b.infinite || bound_less_or_equal(a, b))
+    {
+        return a;
+    }
+    // Incomparable, the bound relative to a string length is the useful one for indexing
+    return a.string != NULL ? a : b;
+}
+
+/**
+ * Tighter of two lower bounds of the same value (both are valid)
+ */
+static RangeBound max_low(RangeBound a, RangeBound b)
+{
+    if (a.infinite || (!b.infinite && bound_less_or_equal(a, b)))
+    {
+        return b;
+    }
+    if (b.infinite || bound_less_or_equal(b, a))
+    {
+        return a;
+    }
+    return a.string != NULL ? a : b;
+}
+
+/**
+ * Smallest range containing both ranges
+ */
+static Range join_ranges(Range a, Range b)
+{
+    Range range = unknown_range();
+    if (!a.low.infinite && !b.low.infinite)
+    {
+        range.low = bound_less_or_equal(a.low, b.low) ? a.low : bound_less_or_equal(b.low, a.low) ? b.low : infinite_bound();
+    }
+    if (!a.high.infinite && !b.high.infinite)
+    {
+        range.high = bound_less_or_equal(b.high, a.high) ? a.high : bound_less_or_equal(a.high, b.high) ? b.high : infinite_bound();
+    }
+    return range;
+}
+
+/**
+ * Finds the facts about a variable
+ */
+static RangeVariable *find_variable(RangeVariable *env, const char *name)
+{
+    for (; env != NULL; env = env->next)
+    {
+        if (strcmp(env->name, name) == 0)
+        {
+            return env;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Finds the facts about a variable, adds an unknown variable if it has none
+ */
+static RangeVariable *get_variable(RangeVariable **env, const char *name)
+{
+    RangeVariable *variable = find_variable(*env, name);
+    if (variable == NULL)
+    {
+        variable = (RangeVariable *)safe_malloc(sizeof(RangeVariable));
+        variable->name = name;
+        variable->range = unknown_range();
+        variable->min_length = 0;
+        variable->next = *env;
+        *env = variable;
+    }
+    return variable;
+}
+
+/**
+ * Copies the facts for a branch of the program
+ */
+static RangeVariable *copy_env(RangeVariable *env)
+{
+    RangeVariable *copy = NULL;
+    RangeVariable **link = &copy;
+    for (; env != NULL; env = env->next)
+    {
+        *link = (RangeVariable *)safe_malloc(sizeof(RangeVariable));
+        **link = *env;
+        (*link)->next = NULL;
+        link = &(*link)->next;
+    }
+    return copy;
+}
+
+/**
+ * Frees the facts of a branch
+ */
+static void free_env(RangeVariable *env)
+{
+    while (env != NULL)
+    {
+        RangeVariable *next = env->next;
+        safe_free(env);
+        env = next;
+    }
+}
+
+/**
+ * Facts holding after either of two branches, variables known in only one are dropped
+ */
+static RangeVariable *join_envs(RangeVariable *a, RangeVariable *b)
+{
+    RangeVariable *joined = NULL;
+    for (; a != NULL; a = a->next)
+    {
+        RangeVariable *other = find_variable(b, a->name);
+        if (other != NULL)
+        {
+            RangeVariable *variable = get_variable(&joined, a->name);
+            variable->range = join_ranges(a->range, other->range);
+            variable->min_length = a->min_length < other->min_length ? a->min_length : other->min_length;
+        }
+    }
+    return joined;
+}
+
+/**
+ * Forgets bounds relative to the length of a string that gets a new value
+ */
+static void invalidate_string(RangeVariable *env, const char *name)
+{
+    for (; env != NULL; env = env->next)
+    {
+        if (env->range.low.string != NULL && strcmp(env->range.low.string, name) == 0)
+        {
+            env->range.low = infinite_bound();
+        }
+        if (env->range.high.string != NULL && strcmp(env->range.high.string, name) == 0)
+        {
+            env->range.high = infinite_bound();
+        }
+    }
+}
+
+/**
+ * Checks if a node is a variable (not a keyword)
+ */
+static bool is_variable(ASTNode *node)
+{
+    return node->type == NODE_IDENTIFIER && strcmp(node->name, "true") != 0 &&
+           strcmp(node->name, "false") != 0 && strcmp(node->name, "nil") != 0;
+}
+
+/**
+ * Reads the value of an integer literal
+ */
+static bool get_int_literal(ASTNode *node, long long *value)
+{
+    if (node->type != NODE_LITERAL || node->data_type != TYPE_INT)
+    {
+        return false;
+    }
+    *value = strtoll(node->value, NULL, 10);
+    return true;
+}
+
+/**
+ * Computes the range of an integer expression
+ */
+static Range evaluate_range(ASTNode *node, RangeVariable *env)
+{
+    long long value;
+    if (get_int_literal(node, &value))
+    {
+        return constant_range(value, value);
+    }
+
+    // A nullable variable in an expression is not its integer value
+    if (is_variable(node) && node->data_type == TYPE_INT)
+    {
+        RangeVariable *variable = find_variable(env, node->name);
+        return variable != NULL ? variable->range : unknown_range();
+    }
+
+    if (node->type == NODE_FUNCTION_CALL)
+    {
+        if (strcmp(node->name, "ifj.length") == 0 && is_variable(node->arguments[0]))
+        {
+            RangeBound length = {false, node->arguments[0]->name, 1, 0, 1};
+            Range range = {length, length};
+            return range;
+        }
+        if (strcmp(node->name, "ifj.length") == 0)
+        {
+            Range range = {constant_bound(0), infinite_bound()};
+            return range;
+        }
+        if (strcmp(node->name, "ifj.ord") == 0)
+        {
+            return constant_range(0, BYTE_MAX);
+        }
+        if (strcmp(node->name, "ifj.strcmp") == 0)
+        {
+            return constant_range(-1, 1);
+        }
+        return unknown_range();
+    }
+
+    if (node->type != NODE_BINARY_OPERATION || node->data_type != TYPE_INT)
+    {
+        return unknown_range();
+    }
+
+    Range left = evaluate_range(node->left, env);
+    Range right = evaluate_range(node->right, env);
+    Range range = unknown_range();
+    if (strcmp(node->name, "+") == 0)
+    {
+        range.low = add_bounds(left.low, right.low);
+        range.high = add_bounds(left.high, right.high);
+    }
+    else if (strcmp(node->name, "-") == 0)
+    {
+        range.low = add_bounds(left.low, scale_bound(right.high, -1));
+        range.high = add_bounds(left.high, scale_bound(right.low, -1));
+    }
+    else if (strcmp(node->name, "*") == 0)
+    {
+        // Multiplication by a constant, the other operand keeps its length term
+        Range *scaled = get_int_literal(node->right, &value) ? &left : get_int_literal(node->left, &value) ? &right : NULL;
+        if (scaled != NULL)
+        {
+            range.low = scale_bound(value >= 0 ? scaled->low : scaled->high, value);
+            range.high = scale_bound(value >= 0 ? scaled->high : scaled->low, value);
+        }
+    }
+    else if (strcmp(node->name, "/") == 0 && get_int_literal(node->right, &value) && value > 0 &&
+             bound_is_non_negative(left.low, 0))
+    {
+        // x / k of a non-negative x is in ((x - k + 1) / k, x / k)
+        range.high = left.high;
+        range.low = add_bounds(left.low, constant_bound(1 - value));
+        if (!checked_mul(range.high.d, value, &range.high.d) || !checked_mul(range.low.d, value, &range.low.d))
+        {
+            return unknown_range();
+        }
+        range.high = normalize_bound(range.high);
+        range.low = normalize_bound(range.low);
+        if (range.high.infinite)
+        {
+            range.high = infinite_bound();
+        }
+        range.low = max_low(range.low, constant_bound(0));
+    }
+    return range;
+}
+
+/**
+ * Computes the minimal length of a string expression (when it is not null)
+ */
+static long long evaluate_min_length(ASTNode *node, RangeVariable *env)
+{
+    long long start, end;
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+        return node->data_type == TYPE_U8 ? (long long)strlen(node->value) : 0;
+
+    case NODE_IDENTIFIER:
+    {
+        RangeVariable *variable = find_variable(env, node->name);
+        return variable != NULL ? variable->min_length : 0;
+    }
+
+    case NODE_FUNCTION_CALL:
+        if (strcmp(node->name, "ifj.string") == 0)
+        {
+            return evaluate_min_length(node->arguments[0], env);
+        }
+        if (strcmp(node->name, "ifj.concat") == 0)
+        {
+            long long length;
+            if (!checked_add(evaluate_min_length(node->arguments[0], env),
+                             evaluate_min_length(node->arguments[1], env), &length))
+            {
+                return 0;
+            }
+            return length;
+        }
+        if (strcmp(node->name, "ifj.chr") == 0)
+        {
+            return 1;
+        }
+        if (strcmp(node->name, "ifj.substring") == 0)
+        {
+            ASTNode *start_arg = node->arguments[1];
+            ASTNode *end_arg = node->arguments[2];
+            if (get_int_literal(start_arg, &start) && get_int_literal(end_arg, &end))
+            {
+                return end > start ? end - start : 0;
+            }
+            // ifj.substring(s, i, i + c) has c characters
+            if (is_variable(start_arg) && end_arg->type == NODE_BINARY_OPERATION && strcmp(end_arg->name, "+") == 0 &&
+                is_variable(end_arg->left) && strcmp(end_arg->left->name, start_arg->name) == 0 &&
+                get_int_literal(end_arg->right, &end))
+            {
+                return end > 0 ? end : 0;
+            }
+        }
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Records a call whose checks are not needed
+ */
+static void add_safe_call(RangeInfo *info, ASTNode *call)
+{
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->safe_calls[i] == call)
+        {
+            return;
+        }
+    }
+    if (info->count == info->capacity)
+    {
+        info->capacity = info->capacity == 0 ? 8 : info->capacity * 2;
+        ASTNode **calls = (ASTNode **)safe_malloc(sizeof(ASTNode *) * info->capacity);
+        for (int i = 0; i < info->count; i++)
+        {
+            calls[i] = info->safe_calls[i];
+        }
+        if (info->safe_calls != NULL)
+        {
+            safe_free(info->safe_calls);
+        }
+        info->safe_calls = calls;
+    }
+    info->safe_calls[info->count++] = call;
+}
+
+/**
+ * Removes a call proven safe in an earlier visit but not in the current one
+ */
+static void remove_safe_call(RangeInfo *info, ASTNode *call)
+{
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->safe_calls[i] == call)
+        {
+            info->safe_calls[i] = info->safe_calls[--info->count];
+            return;
+        }
+    }
+}
+
+/**
+ * Checks if an index is in bounds of a string
+ */
+static bool is_index_in_bounds(ASTNode *string, Range index, RangeVariable *env)
+{
+    long long min_length = evaluate_min_length(string, env);
+    RangeBound high = index.high;
+    if (high.infinite || !bound_is_non_negative(index.low, 0))
+    {
+        return false;
+    }
+    if (high.string == NULL)
+    {
+        // index <= r / d < min_length <= length
+        long long limit;
+        return checked_mul(high.d, min_length, &limit) && high.r < limit;
+    }
+    // (p * length + r) / d < length when (d - p) * length > r for every length >= min_length
+    long long value;
+    return is_variable(string) && strcmp(high.string, string->name) == 0 && high.d - high.p >= 0 &&
+           checked_mul(high.d - high.p, min_length, &value) && value > high.r;
+}
+
+/**
+ * Finds calls of ifj.ord and ifj.chr in an expression and proves their arguments in range
+ */
+static void check_calls(ASTNode *node, RangeVariable *env, RangeInfo *info)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    if (node->type == NODE_BINARY_OPERATION)
+    {
+        check_calls(node->left, env, info);
+        check_calls(node->right, env, info);
+        return;
+    }
+    if (node->type != NODE_FUNCTION_CALL)
+    {
+        return;
+    }
+    for (int i = 0; i < node->arg_count; i++)
+    {
+        check_calls(node->arguments[i], env, info);
+    }
+
+    bool is_safe;
+    if (strcmp(node->name, "ifj.ord") == 0)
+    {
+        is_safe = is_index_in_bounds(node->arguments[0], evaluate_range(node->arguments[1], env), env);
+    }
+    else if (strcmp(node->name, "ifj.chr") == 0)
+    {
+        Range range = evaluate_range(node->arguments[0], env);
+        is_safe = bound_is_non_negative(range.low, 0) && !range.high.infinite && range.high.string == NULL &&
+                  range.high.r <= BYTE_MAX * range.high.d;
+    }
+    else
+    {
+        return;
+    }
+
+    if (is_safe)
+    {
+        add_safe_call(info, node);
+    }
+    else
+    {
+        remove_safe_call(info, node);
+    }
+}
+
+/**
+ * Stores the value of an expression into a variable
+ */
+static void assign_variable(RangeVariable **env, const char *name, ASTNode *value)
+{
+    Range range = unknown_range();
+    long long min_length = 0;
+    if (value != NULL)
+    {
+        RangeVariable *source = is_variable(value) ? find_variable(*env, value->name) : NULL;
+        if (source != NULL)
+        {
+            // Also binds |id| to the value of a nullable variable
+            range = source->range;
+            min_length = source->min_length;
+        }
+        else
+        {
+            range = value->data_type == TYPE_INT ? evaluate_range(value, *env) : unknown_range();
+            min_length = evaluate_min_length(value, *env);
+        }
+    }
+    invalidate_string(*env, name);
+    RangeVariable *variable = get_variable(env, name);
+    variable->range = range;
+    variable->min_length = min_length;
+}
+
+/**
+ * Narrows the range of a variable compared with an expression (variable op expression)
+ */
+static void apply_comparison(RangeVariable **env, ASTNode *variable_node, const char *op, ASTNode *expression)
+{
+    if (!is_variable(variable_node) || variable_node->data_type != TYPE_INT)
+    {
+        return;
+    }
+    Range other = evaluate_range(expression, *env);
+    RangeVariable *variable = get_variable(env, variable_node->name);
+    if (strcmp(op, "<") == 0)
+    {
+        variable->range.high = min_high(variable->range.high, add_bounds(other.high, constant_bound(-1)));
+    }
+    else if (strcmp(op, "<=") == 0 || strcmp(op, "==") == 0)
+    {
+        variable->range.high = min_high(variable->range.high, other.high);
+    }
+    if (strcmp(op, ">") == 0)
+    {
+        variable->range.low = max_low(variable->range.low, add_bounds(other.low, constant_bound(1)));
+    }
+    else if (strcmp(op, ">=") == 0 || strcmp(op, "==") == 0)
+    {
+        variable->range.low = max_low(variable->range.low, other.low);
+    }
+}
+
+/**
+ * Narrows ranges of variables by a condition known to evaluate to value
+ */
+static void refine_condition(ASTNode *condition, bool value, RangeVariable **env)
+{
+    static const char *operators[][3] = {
+        // operator, negated, swapped operands
+        {"<", ">=", ">"}, {"<=", ">", ">="}, {">", "<=", "<"},
+        {">=", "<", "<="}, {"==", "!=", "=="}, {"!=", "==", "!="}};
+
+    if (condition->type != NODE_BINARY_OPERATION || condition->left->data_type != TYPE_INT ||
+        condition->right->data_type != TYPE_INT)
+    {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++)
+    {
+        if (strcmp(condition->name, operators[i][0]) == 0)
+        {
+            const char *op = value ? operators[i][0] : operators[i][1];
+            const char *swapped = op;
+            for (size_t j = 0; j < sizeof(operators) / sizeof(operators[0]); j++)
+            {
+                if (strcmp(operators[j][0], op) == 0)
+                {
+                    swapped = operators[j][2];
+                }
+            }
+            apply_comparison(env, condition->left, op, condition->right);
+            apply_comparison(env, condition->right, swapped, condition->left);
+            return;
+        }
+    }
+}
+
+/**
+ * Finds how a variable changes in a loop: 1 if it is only increased by constants,
+ * -1 if only decreased, 0 if it is assigned anything else
+ */
+static int get_counter_direction(ASTNode *statement, const char *name, int direction)
+{
+    for (; statement != NULL && direction != 0; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+            if (strcmp(statement->name, name) == 0)
+            {
+                return 0;
+            }
+            break;
+
+        case NODE_ASSIGNMENT:
+            if (strcmp(statement->name, name) == 0)
+            {
+                ASTNode *value = statement->left;
+                long long step;
+                bool is_step = value->type == NODE_BINARY_OPERATION &&
+                               (strcmp(value->name, "+") == 0 || strcmp(value->name, "-") == 0) &&
+                               is_variable(value->left) && strcmp(value->left->name, name) == 0 &&
+                               get_int_literal(value->right, &step) && step >= 0;
+                int step_direction = is_step ? (strcmp(value->name, "+") == 0 ? 1 : -1) : 0;
+                if (!is_step || (direction != 2 && direction != step_direction))
+                {
+                    return 0;
+                }
+                direction = step_direction;
+            }
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (statement->left != NULL && strcmp(statement->left->name, name) == 0)
+            {
+                return 0;
+            }
+            break;
+
+        case NODE_IF:
+            direction = get_counter_direction(statement->body->body, name, direction);
+            if (statement->left != NULL)
+            {
+                direction = get_counter_direction(statement->left->body, name, direction);
+            }
+            break;
+
+        case NODE_WHILE:
+            direction = get_counter_direction(statement->body->body, name, direction);
+            break;
+
+        default:
+            break;
+        }
+    }
+    return direction;
+}
+
+/**
+ * Checks if a variable gets a new value in a list of statements
+ */
+static bool is_assigned(ASTNode *statement, const char *name)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            if (strcmp(statement->name, name) == 0)
+            {
+                return true;
+            }
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (statement->left != NULL && strcmp(statement->left->name, name) == 0)
+            {
+                return true;
+            }
+            break;
+
+        case NODE_IF:
+            if (is_assigned(statement->body->body, name) ||
+                (statement->left != NULL && is_assigned(statement->left->body, name)))
+            {
+                return true;
+            }
+            break;
+
+        case NODE_WHILE:
+            if (is_assigned(statement->body->body, name))
+            {
+                return true;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Widens the facts at the entry of a loop so they hold in every iteration.
+ * Counters keep the bound in the direction opposite to their steps.
+ */
+static void widen_loop_entry(ASTNode *while_node, RangeVariable *env)
+{
+    ASTNode *body = while_node->body->body;
+    for (RangeVariable *variable = env; variable != NULL; variable = variable->next)
+    {
+        if (!is_assigned(body, variable->name))
+        {
+            continue;
+        }
+        invalidate_string(env, variable->name);
+        variable->min_length = 0;
+        int direction = get_counter_direction(body, variable->name, 2);
+        if (direction != 1)
+        {
+            variable->range.low = infinite_bound();
+        }
+        if (direction != -1)
+        {
+            variable->range.high = infinite_bound();
+        }
+    }
+}
+
+/**
+ * Analyzes a list of statements, updating the facts in order
+ */
+static void analyze_statements(ASTNode *statement, RangeVariable **env, RangeInfo *info)
+{
+    for (; statement != NULL; statement = statement->next)
+    {
+        switch (statement->type)
+        {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_ASSIGNMENT:
+            check_calls(statement->left, *env, info);
+            assign_variable(env, statement->name, statement->left);
+            break;
+
+        case NODE_FUNCTION_CALL:
+            check_calls(statement, *env, info);
+            if (statement->left != NULL)
+            {
+                assign_variable(env, statement->left->name, NULL);
+            }
+            break;
+
+        case NODE_RETURN:
+            check_calls(statement->left, *env, info);
+            break;
+
+        case NODE_IF:
+        {
+            check_calls(statement->condition, *env, info);
+            RangeVariable *then_env = copy_env(*env);
+            RangeVariable *else_env = copy_env(*env);
+            refine_condition(statement->condition, true, &then_env);
+            refine_condition(statement->condition, false, &else_env);
+            analyze_statements(statement->body->body, &then_env, info);
+            if (statement->left != NULL)
+            {
+                analyze_statements(statement->left->body, &else_env, info);
+            }
+
+            // A branch that returns does not reach the next statement
+            bool then_returns = block_terminates(statement->body);
+            bool else_returns = statement->left != NULL && block_terminates(statement->left);
+            free_env(*env);
+            if (then_returns && !else_returns)
+            {
+                *env = else_env;
+                free_env(then_env);
+            }
+            else if (else_returns && !then_returns)
+            {
+                *env = then_env;
+                free_env(else_env);
+            }
+            else
+            {
+                *env = join_envs(then_env, else_env);
+                free_env(then_env);
+                free_env(else_env);
+            }
+            break;
+        }
+
+        case NODE_WHILE:
+        {
+            widen_loop_entry(statement, *env);
+            check_calls(statement->condition, *env, info);
+            RangeVariable *body_env = copy_env(*env);
+            refine_condition(statement->condition, true, &body_env);
+            analyze_statements(statement->body->body, &body_env, info);
+            free_env(body_env);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Analyzes all functions of the program, parameters have unknown values
+ */
+RangeInfo *range_analyze(ASTNode *program_node)
+{
+    RangeInfo *info = (RangeInfo *)safe_malloc(sizeof(RangeInfo));
+    info->safe_calls = NULL;
+    info->count = 0;
+    info->capacity = 0;
+    if (program_node == NULL)
+    {
+        return info;
+    }
+
+    for (ASTNode *function = program_node->body; function != NULL; function = function->next)
+    {
+        if (function->type == NODE_FUNCTION && function->body != NULL)
+        {
+            RangeVariable *env = NULL;
+            analyze_statements(function->body->body, &env, info);
+            free_env(env);
+        }
+    }
+    return info;
+}
+
+/**
+ * Checks if a call was proven safe
+ */
+static bool is_safe_call(RangeInfo *info, ASTNode *call)
+{
+    if (info == NULL)
+    {
+        return false;
+    }
+    for (int i = 0; i < info->count; i++)
+    {
+        if (info->safe_calls[i] == call)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if the index of an ifj.ord call is always in bounds of its string
+ */
+bool range_is_ord_in_bounds(RangeInfo *info, ASTNode *call)
+{
+    return strcmp(call->name, "ifj.ord") == 0 && is_safe_call(info, call);
+}
+
+/**
+ * Checks if the argument of an ifj.chr call is always in 0..255
+ */
+bool range_is_chr_byte(RangeInfo *info, ASTNode *call)
+{
+    return strcmp(call->name, "ifj.chr") == 0 && is_safe_call(info, call);
+}
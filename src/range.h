@@ -0,0 +1,69 @@
+/**
+ * @file range.h
+ *
+ * Header file for the integer value range analysis.
+ * Proves indices of ifj.ord in bounds of their string and arguments
+ * of ifj.chr in 0..255, so the generated code can skip the checks.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef RANGE_H
+#define RANGE_H
+
+#include <stdbool.h>
+#include "ast.h"
+
+/**
+ * Bound (p * length(string) + r) / d of an integer value.
+ * Constant bounds have no string, infinite bounds hold no information.
+ */
+typedef struct {
+    bool infinite;
+    const char *string; // Variable whose length the bound depends on, NULL for a constant
+    long long p;
+    long long r;
+    long long d;        // Positive denominator
+} RangeBound;
+
+/**
+ * Interval of values of an integer expression
+ */
+typedef struct {
+    RangeBound low;
+    RangeBound high;
+} Range;
+
+/**
+ * Facts about a variable at a point of a function body
+ */
+typedef struct RangeVariable {
+    const char *name;
+    Range range;            // Values of an integer variable
+    long long min_length;   // Minimal length of a string variable (when not null)
+    struct RangeVariable *next;
+} RangeVariable;
+
+/**
+ * Built-in function calls whose checks are proven unnecessary
+ */
+typedef struct {
+    ASTNode **safe_calls;
+    int count;
+    int capacity;
+} RangeInfo;
+
+// Analyzes all functions of the program
+RangeInfo *range_analyze(ASTNode *program_node);
+
+// Checks if the index of an ifj.ord call is always in bounds of its string
+bool range_is_ord_in_bounds(RangeInfo *info, ASTNode *call);
+
+// Checks if the argument of an ifj.chr call is always in 0..255
+bool range_is_chr_byte(RangeInfo *info, ASTNode *call);
+
+#endif // RANGE_H
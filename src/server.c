@@ -0,0 +1,452 @@
+/**
+ * @file server.c
+ *
+ * Implementation of the compile server.
+ * A dispatcher thread accepts connections and waits with poll until one of
+ * the idle connections has a request. The connection is then put into a
+ * queue, a worker takes it, answers that one request and gives the
+ * connection back to the dispatcher. Idle clients therefore hold no worker.
+ * SIGINT and SIGTERM are blocked in all threads and waited for by the main
+ * thread, which then stops the dispatcher and the workers, lets the running
+ * compilations finish and removes the socket.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+#include "error.h"
+#include "protocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * List of connections
+ */
+typedef struct {
+    int *items;
+    int count;
+    int capacity;
+} ConnectionList;
+
+/**
+ * State shared by the dispatcher and the workers
+ */
+typedef struct {
+    int listen_socket;
+    int wake_pipe[2];                        // Written to wake the dispatcher from poll
+    const Ifj24Options *options;
+    pthread_mutex_t lock;                    // Guards everything below
+    pthread_cond_t queued;                   // Signaled when a connection is queued or the server stops
+    bool stopping;                           // Set once a signal to stop arrived
+    ConnectionList idle;                     // Connections waiting for their next request, polled by the dispatcher
+    ConnectionList queue;                    // Connections with a request, oldest first
+    int connections[SERVER_MAX_WORKERS];     // Connection served by each worker, or -1
+} Server;
+
+/**
+ * Worker thread of the server
+ */
+typedef struct {
+    Server *server;
+    int index;
+    pthread_t thread;
+} Worker;
+
+/**
+ * Appends a connection to a list, returns false if there is no memory
+ */
+static bool list_append(ConnectionList *list, int connection)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+        int *items = realloc(list->items, sizeof(int) * capacity);
+        if (items == NULL)
+        {
+            return false;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = connection;
+    return true;
+}
+
+/**
+ * Closes all connections of a list and frees it
+ */
+static void list_close(ConnectionList *list)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        close(list->items[i]);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * Wakes the dispatcher waiting in poll
+ */
+static void wake_dispatcher(Server *server)
+{
+    char byte = 0;
+    while (write(server->wake_pipe[1], &byte, 1) < 0 && errno == EINTR)
+    {
+    }
+}
+
+/**
+ * Answers one request of a connection, returns false if the connection ended
+ */
+static bool serve_request(const Server *server, int connection)
+{
+    char *source;
+    size_t length;
+    if (!protocol_receive_request(connection, &source, &length))
+    {
+        return false;
+    }
+
+    Ifj24Buffer code;
+    Ifj24Buffer diagnostics;
+    int result = ifj24_compile(source, length, server->options, &code, &diagnostics);
+    free(source);
+
+    bool sent = protocol_send_response(connection, result, code.data, code.length, diagnostics.data, diagnostics.length);
+    ifj24_free_buffer(&code);
+    ifj24_free_buffer(&diagnostics);
+    return sent;
+}
+
+/**
+ * Answers the queued requests until the server stops
+ */
+static void *run_worker(void *argument)
+{
+    Worker *worker = argument;
+    Server *server = worker->server;
+    pthread_mutex_lock(&server->lock);
+    for (;;)
+    {
+        while (!server->stopping && server->queue.count == 0)
+        {
+            pthread_cond_wait(&server->queued, &server->lock);
+        }
+        if (server->stopping)
+        {
+            pthread_mutex_unlock(&server->lock);
+            return NULL;
+        }
+        int connection = server->queue.items[0];
+        server->queue.count--;
+        memmove(server->queue.items, server->queue.items + 1, sizeof(int) * server->queue.count);
+        server->connections[worker->index] = connection;
+        pthread_mutex_unlock(&server->lock);
+
+        bool open = serve_request(server, connection);
+
+        // A connection still open waits in the dispatcher for its next request
+        pthread_mutex_lock(&server->lock);
+        server->connections[worker->index] = -1;
+        if (open && !server->stopping && list_append(&server->idle, connection))
+        {
+            wake_dispatcher(server);
+        }
+        else
+        {
+            close(connection);
+        }
+    }
+}
+
+/**
+ * Returns true for errors of accept after which the next connection can be accepted
+ */
+static bool is_transient_error(int error)
+{
+    return error == EINTR || error == ECONNABORTED || error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+}
+
+/**
+ * Accepts the pending connections into the idle ones, returns false if the socket failed.
+ * Reading and writing a connection time out, so a client that stops in the middle of
+ * a request ends its connection instead of holding a worker.
+ */
+static bool accept_connections(Server *server)
+{
+    struct timeval timeout = {SERVER_IO_TIMEOUT, 0};
+    for (;;)
+    {
+        int connection = accept(server->listen_socket, NULL, NULL);
+        if (connection < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || is_transient_error(errno);
+        }
+        if (setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+            setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)
+        {
+            close(connection);
+            continue;
+        }
+        pthread_mutex_lock(&server->lock);
+        bool added = list_append(&server->idle, connection);
+        pthread_mutex_unlock(&server->lock);
+        if (!added)
+        {
+            close(connection);
+        }
+    }
+}
+
+/**
+ * Waits for new connections and requests on the idle connections and queues
+ * the connections with a request (or closed by the client) for the workers
+ */
+static void *run_dispatcher(void *argument)
+{
+    Server *server = argument;
+    struct pollfd *polled = NULL;
+    int polled_capacity = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&server->lock);
+        if (server->stopping)
+        {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        int count = 2 + server->idle.count;
+        if (count > polled_capacity)
+        {
+            struct pollfd *larger = realloc(polled, sizeof(struct pollfd) * count);
+            if (larger == NULL)
+            {
+                pthread_mutex_unlock(&server->lock);
+                break;
+            }
+            polled = larger;
+            polled_capacity = count;
+        }
+        polled[0].fd = server->wake_pipe[0];
+        polled[1].fd = server->listen_socket;
+        for (int i = 0; i < server->idle.count; i++)
+        {
+            polled[2 + i].fd = server->idle.items[i];
+        }
+        pthread_mutex_unlock(&server->lock);
+        for (int i = 0; i < count; i++)
+        {
+            polled[i].events = POLLIN;
+            polled[i].revents = 0;
+        }
+
+        if (poll(polled, count, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (polled[0].revents != 0)
+        {
+            char bytes[64];
+            while (read(server->wake_pipe[0], bytes, sizeof(bytes)) > 0)
+            {
+            }
+        }
+        if (polled[1].revents != 0 && !accept_connections(server))
+        {
+            break;
+        }
+
+        // Polled connections are the first ones of the idle list, workers only append to it
+        pthread_mutex_lock(&server->lock);
+        int kept = 0;
+        for (int i = 0; i < server->idle.count; i++)
+        {
+            int connection = server->idle.items[i];
+            bool ready = i < count - 2 && polled[2 + i].revents != 0;
+            if (ready && list_append(&server->queue, connection))
+            {
+                pthread_cond_signal(&server->queued);
+            }
+            else if (ready)
+            {
+                close(connection);
+            }
+            else
+            {
+                server->idle.items[kept++] = connection;
+            }
+        }
+        server->idle.count = kept;
+        pthread_mutex_unlock(&server->lock);
+    }
+    free(polled);
+    return NULL;
+}
+
+/**
+ * Opens the listening socket, removing a socket left by a previous server.
+ * Fails if a server is still listening on it.
+ */
+static int open_listen_socket(const char *socket_path)
+{
+    struct sockaddr_un address;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path is too long: %s\n", socket_path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_socket < 0)
+    {
+        fprintf(stderr, "Cannot create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct stat info;
+    if (lstat(socket_path, &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        if (connect(listen_socket, (struct sockaddr *)&address, sizeof(address)) == 0)
+        {
+            fprintf(stderr, "Another server is listening on %s\n", socket_path);
+            close(listen_socket);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    if (bind(listen_socket, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_socket, SOMAXCONN) != 0 ||
+        fcntl(listen_socket, F_SETFL, O_NONBLOCK) != 0)
+    {
+        fprintf(stderr, "Cannot listen on %s: %s\n", socket_path, strerror(errno));
+        close(listen_socket);
+        return -1;
+    }
+    return listen_socket;
+}
+
+/**
+ * Serves compile requests on the socket until SIGINT or SIGTERM
+ */
+int server_run(const char *socket_path, int workers, const Ifj24Options *options)
+{
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.options = options;
+    server.stopping = false;
+    for (int i = 0; i < SERVER_MAX_WORKERS; i++)
+    {
+        server.connections[i] = -1;
+    }
+    if (pipe(server.wake_pipe) != 0)
+    {
+        fprintf(stderr, "Cannot create a pipe: %s\n", strerror(errno));
+        return ERR_INTERNAL;
+    }
+    fcntl(server.wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(server.wake_pipe[1], F_SETFL, O_NONBLOCK);
+    server.listen_socket = open_listen_socket(socket_path);
+    if (server.listen_socket < 0)
+    {
+        close(server.wake_pipe[0]);
+        close(server.wake_pipe[1]);
+        return ERR_INTERNAL;
+    }
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.queued, NULL);
+
+    // The threads inherit the blocked signals, only sigwait below receives them
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+
+    Worker pool[SERVER_MAX_WORKERS];
+    int started = 0;
+    while (started < workers && started < SERVER_MAX_WORKERS)
+    {
+        pool[started].server = &server;
+        pool[started].index = started;
+        if (pthread_create(&pool[started].thread, NULL, run_worker, &pool[started]) != 0)
+        {
+            break;
+        }
+        started++;
+    }
+    pthread_t dispatcher;
+    bool dispatching = started > 0 && pthread_create(&dispatcher, NULL, run_dispatcher, &server) == 0;
+
+    int result = ERR_OK;
+    if (!dispatching)
+    {
+        fprintf(stderr, "Cannot start the worker threads\n");
+        result = ERR_INTERNAL;
+    }
+    else
+    {
+        int signal_number;
+        sigwait(&stop_signals, &signal_number);
+    }
+
+    // Wake the dispatcher, the workers waiting for a request and those reading one
+    pthread_mutex_lock(&server.lock);
+    server.stopping = true;
+    pthread_cond_broadcast(&server.queued);
+    for (int i = 0; i < started; i++)
+    {
+        if (server.connections[i] >= 0)
+        {
+            shutdown(server.connections[i], SHUT_RD);
+        }
+    }
+    pthread_mutex_unlock(&server.lock);
+    wake_dispatcher(&server);
+
+    if (dispatching)
+    {
+        pthread_join(dispatcher, NULL);
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(pool[i].thread, NULL);
+    }
+    list_close(&server.idle);
+    list_close(&server.queue);
+    close(server.listen_socket);
+    close(server.wake_pipe[0]);
+    close(server.wake_pipe[1]);
+    unlink(socket_path);
+    pthread_cond_destroy(&server.queued);
+    pthread_mutex_destroy(&server.lock);
+    pthread_sigmask(SIG_UNBLOCK, &stop_signals, NULL);
+    return result;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file server.h
+ *
+ * Header file for the compile server.
+ * The server keeps one process running and compiles the requests of
+ * protocol.h arriving on a Unix domain socket, on a pool of worker threads.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "ifj24.h"
+
+/** Largest number of worker threads */
+#define SERVER_MAX_WORKERS 256
+
+/** Seconds a worker waits for the rest of a request or for the client to take the response */
+#define SERVER_IO_TIMEOUT 10
+
+// Serves compile requests on the socket until SIGINT or SIGTERM, returns ERR_OK or ERR_INTERNAL
+int server_run(const char *socket_path, int workers, const Ifj24Options *options);
+
+#endif // SERVER_H
@@ -0,0 +1,42 @@
+/**
+ * @file sha256.h
+ *
+ * Header file for the SHA-256 hash (FIPS 180-4) naming the entries of the
+ * compile cache.
+ *
+ * IFJ Project 2024, Team 'xstepa77'
+ *
+ * @author <xlitvi02> Gleb Litvinchuk
+ * @author <xstepa77> Pavel Stepanov
+ * @author <xkovin00> Viktoriia Kovina
+ * @author <xshmon00> Gleb Shmonin
+ */
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of a hash in bytes */
+#define SHA256_SIZE 32
+
+/**
+ * State of a hash computed over data given in parts
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;         // Bytes hashed so far
+    unsigned char block[64]; // Bytes not yet hashed
+    size_t block_length;
+} Sha256;
+
+// Starts a new hash
+void sha256_init(Sha256 *hash);
+
+// Adds data to the hash
+void sha256_update(Sha256 *hash, const void *data, size_t length);
+
+// Finishes the hash and stores it to digest
+void sha256_final(Sha256 *hash, unsigned char digest[SHA256_SIZE]);
+
+#endif // SHA256_H
@@ -82,6 +82,8 @@ void insert_underscore(SymTable *symtable)
     underscore->is_defined = true;
     underscore->is_used = true;
     underscore->is_constant = false;
+    underscore->parent_function = NULL;
+    underscore->declaration_node = NULL;
     underscore->next = NULL;
 
     symtable_insert(symtable, "_", underscore);
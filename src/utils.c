@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include "utils.h"
 #include "parser.h"
+#include "compiler.h"
 
 /**
  *  Function to safely duplicate a string
@@ -92,38 +93,46 @@ char *construct_builtin_name(const char *str1, const char *str2)
     return result;
 }
 
-PointerStorage global_storage;
+/**
+ * Returns the pointer storage of the current compiler context
+ */
+static PointerStorage *current_storage()
+{
+    return &compiler_context_current()->storage;
+}
 
 /**
- * Initialize the global pointer storage with an initial capacity
+ * Initialize a pointer storage with an initial capacity, returns false if there is no memory
  */
-void init_pointers_storage(size_t initial_capacity)
+bool init_pointers_storage(PointerStorage *storage, size_t initial_capacity)
 {
-    global_storage.pointers = (void **)malloc(initial_capacity * sizeof(void *));
-    if (!global_storage.pointers)
+    storage->pointers = (void **)malloc(initial_capacity * sizeof(void *));
+    if (!storage->pointers)
     {
-        error_exit(ERR_INTERNAL, "Failed to allocate memory for global storage.\n");
+        return false;
     }
-    global_storage.count = 0;
-    global_storage.capacity = initial_capacity;
+    storage->count = 0;
+    storage->capacity = initial_capacity;
+    return true;
 }
 
 /**
- * Add a pointer to the global pointer storage
+ * Add a pointer to the pointer storage of the current compiler context
  */
 void add_pointer_to_storage(void *ptr)
 {
-    if (global_storage.count >= global_storage.capacity)
+    PointerStorage *storage = current_storage();
+    if (storage->count >= storage->capacity)
     {
-        global_storage.capacity *= 2;
-        void **new_pointers = (void **)realloc(global_storage.pointers, global_storage.capacity * sizeof(void *));
+        storage->capacity *= 2;
+        void **new_pointers = (void **)realloc(storage->pointers, storage->capacity * sizeof(void *));
         if (!new_pointers)
         {
-            error_exit(ERR_INTERNAL, "Failed to expand global pointer storage.\n");
+            error_exit(ERR_INTERNAL, "Failed to expand pointer storage.\n");
         }
-        global_storage.pointers = new_pointers;
+        storage->pointers = new_pointers;
     }
-    global_storage.pointers[global_storage.count++] = ptr;
+    storage->pointers[storage->count++] = ptr;
 }
 
 /**
@@ -136,7 +145,7 @@ void *safe_malloc(size_t size)
     {
         error_exit(ERR_INTERNAL, "Memory allocation failed.\n");
     }
-    add_pointer_to_storage(ptr); // Add pointer to the global storage
+    add_pointer_to_storage(ptr); // Add pointer to the storage of the context
     return ptr;
 }
 
@@ -155,11 +164,12 @@ void *safe_realloc(void *ptr, size_t new_size)
     {
         error_exit(ERR_INTERNAL, "Memory reallocation failed.\n");
     }
-    for (size_t i = 0; i < global_storage.count; i++)
+    PointerStorage *storage = current_storage();
+    for (size_t i = 0; i < storage->count; i++)
     {
-        if (global_storage.pointers[i] == ptr)
+        if (storage->pointers[i] == ptr)
         {
-            global_storage.pointers[i] = new_ptr;
+            storage->pointers[i] = new_ptr;
             break;
         }
     }
@@ -177,19 +187,20 @@ void safe_free(void *ptr)
         return;
     }
 
-    for (size_t i = 0; i < global_storage.count; i++)
+    PointerStorage *storage = current_storage();
+    for (size_t i = 0; i < storage->count; i++)
     {
-        if (global_storage.pointers[i] == ptr)
+        if (storage->pointers[i] == ptr)
         {
             free(ptr);
 
-            for (size_t j = i; j < global_storage.count - 1; j++)
+            for (size_t j = i; j < storage->count - 1; j++)
             {
-                global_storage.pointers[j] = global_storage.pointers[j + 1];
+                storage->pointers[j] = storage->pointers[j + 1];
             }
 
-            global_storage.count--;
-            global_storage.pointers[global_storage.count] = NULL;
+            storage->count--;
+            storage->pointers[storage->count] = NULL;
 
             return;
         }
@@ -199,16 +210,16 @@ void safe_free(void *ptr)
 }
 
 /**
- * Clean up the global pointer storage and free all stored pointers
+ * Clean up a pointer storage and free all stored pointers
  */
-void cleanup_pointers_storage(void)
+void cleanup_pointers_storage(PointerStorage *storage)
 {
-    for (size_t i = 0; i < global_storage.count; i++)
+    for (size_t i = 0; i < storage->count; i++)
     {
-        free(global_storage.pointers[i]);
+        free(storage->pointers[i]);
     }
-    free(global_storage.pointers);
-    global_storage.pointers = NULL;
-    global_storage.count = 0;
-    global_storage.capacity = 0;
+    free(storage->pointers);
+    storage->pointers = NULL;
+    storage->count = 0;
+    storage->capacity = 0;
 }
@@ -13,6 +13,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,11 +38,9 @@ typedef struct {
     size_t capacity;
 } PointerStorage;
 
-extern PointerStorage global_storage;
-
-// Function to initialize the pointer storage
-void init_pointers_storage(size_t initial_capacity);
-// Function to add a pointer to the storage
+// Function to initialize the pointer storage, returns false if there is no memory
+bool init_pointers_storage(PointerStorage *storage, size_t initial_capacity);
+// Function to add a pointer to the storage of the current compiler context
 void add_pointer_to_storage(void* ptr);
 // Function to safely allocate memory
 void *safe_malloc(size_t size);
@@ -50,6 +49,6 @@ void *safe_realloc(void *ptr, size_t new_size);
 // Function to safely free memory
 void safe_free(void *ptr);
 // Function to clean up the pointer storage to prevent memory leaks
-void cleanup_pointers_storage(void);
+void cleanup_pointers_storage(PointerStorage *storage);
 
 #endif // UTILS_H